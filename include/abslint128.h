@@ -26,6 +26,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iosfwd>
 #include <iostream>
 #include <limits>
@@ -56,6 +57,34 @@
 #define ABSL_DLL
 #endif // _WIN32
 
+// ABSL_INT128_HEADER_ONLY
+// ABSL_INT128_INLINE
+//
+// Defining ABSL_INT128_HEADER_ONLY before including this header (the
+// abslint128_header_only CMake target does so) makes it define the functions
+// of `uint128_t` and `int128_t` that are otherwise compiled into the library,
+// such as the floating point conversions and formatting, inline at the end of
+// the header. Nothing needs to be linked and every call can be inlined and
+// specialized for constant arguments. The other headers of this library still
+// need the compiled library. ABSL_INT128_INLINE marks those definitions.
+#if defined(ABSL_INT128_HEADER_ONLY)
+#define ABSL_INT128_INLINE inline
+#else
+#define ABSL_INT128_INLINE
+#endif
+
+// ABSL_HAVE_BUILTIN()
+//
+// Checks whether the compiler supports a Clang Feature Checking Macro, and if
+// so, checks whether it supports the provided builtin function "x" where x
+// is one of the functions noted in
+// https://clang.llvm.org/docs/LanguageExtensions.html
+#ifdef __has_builtin
+#define ABSL_HAVE_BUILTIN(x) __has_builtin(x)
+#else
+#define ABSL_HAVE_BUILTIN(x) 0
+#endif
+
 // ABSL_ATTRIBUTE_ALWAYS_INLINE
 // ABSL_ATTRIBUTE_NOINLINE
 //
@@ -102,6 +131,36 @@
   } while (0)
 #endif
 
+// ABSL_INTERNAL_CONSTEXPR_CLZ
+// ABSL_INTERNAL_CONSTEXPR_CTZ
+// ABSL_INTERNAL_CONSTEXPR_POPCOUNT
+//
+// Expand to `constexpr` for functions built on count-leading-zeros,
+// count-trailing-zeros and population count when the compiler's builtins can
+// be evaluated at compile time. MSVC's _BitScanReverse64 and friends cannot,
+// so those functions are merely inline there.
+#if defined(__GNUC__) || defined(__clang__)
+#define ABSL_INTERNAL_CONSTEXPR_CLZ constexpr
+#define ABSL_INTERNAL_CONSTEXPR_CTZ constexpr
+#define ABSL_INTERNAL_CONSTEXPR_POPCOUNT constexpr
+#define ABSL_INTERNAL_HAS_CONSTEXPR_CLZ 1
+#else
+#define ABSL_INTERNAL_CONSTEXPR_CLZ inline
+#define ABSL_INTERNAL_CONSTEXPR_CTZ inline
+#define ABSL_INTERNAL_CONSTEXPR_POPCOUNT inline
+#define ABSL_INTERNAL_HAS_CONSTEXPR_CLZ 0
+#endif
+
+// ABSL_INTERNAL_CONSTEXPR_MUL
+//
+// Expands to `constexpr` for the 128-bit multiplication operators, except on
+// MSVC for x64, where they use the _umul128 intrinsic and are merely inline.
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+#define ABSL_INTERNAL_CONSTEXPR_MUL inline
+#else
+#define ABSL_INTERNAL_CONSTEXPR_MUL constexpr
+#endif
+
 namespace absl {
 
 class int128_t;
@@ -175,17 +234,17 @@ class
   explicit uint128_t(long double v);
 
   // Assignment operators from arithmetic types
-  uint128_t& operator=(int v);
-  uint128_t& operator=(unsigned int v);
-  uint128_t& operator=(long v);                // NOLINT(runtime/int)
-  uint128_t& operator=(unsigned long v);       // NOLINT(runtime/int)
-  uint128_t& operator=(long long v);           // NOLINT(runtime/int)
-  uint128_t& operator=(unsigned long long v);  // NOLINT(runtime/int)
+  constexpr uint128_t& operator=(int v);
+  constexpr uint128_t& operator=(unsigned int v);
+  constexpr uint128_t& operator=(long v);                // NOLINT(runtime/int)
+  constexpr uint128_t& operator=(unsigned long v);       // NOLINT(runtime/int)
+  constexpr uint128_t& operator=(long long v);           // NOLINT(runtime/int)
+  constexpr uint128_t& operator=(unsigned long long v);  // NOLINT(runtime/int)
 #ifdef ABSL_HAVE_INTRINSIC_INT128
-  uint128_t& operator=(__int128_t v);
-  uint128_t& operator=(unsigned __int128_t v);
+  constexpr uint128_t& operator=(__int128_t v);
+  constexpr uint128_t& operator=(unsigned __int128_t v);
 #endif  // ABSL_HAVE_INTRINSIC_INT128
-  uint128_t& operator=(int128_t v);
+  constexpr uint128_t& operator=(int128_t v);
 
   // Conversion operators to other arithmetic types
   constexpr explicit operator bool() const;
@@ -218,21 +277,21 @@ class
   // Trivial copy constructor, assignment operator and destructor.
 
   // Arithmetic operators.
-  uint128_t& operator+=(uint128_t other);
-  uint128_t& operator-=(uint128_t other);
-  uint128_t& operator*=(uint128_t other);
+  constexpr uint128_t& operator+=(uint128_t other);
+  constexpr uint128_t& operator-=(uint128_t other);
+  ABSL_INTERNAL_CONSTEXPR_MUL uint128_t& operator*=(uint128_t other);
   // Long division/modulo for uint128_t.
-  uint128_t& operator/=(uint128_t other);
-  uint128_t& operator%=(uint128_t other);
-  uint128_t operator++(int);
-  uint128_t operator--(int);
-  uint128_t& operator<<=(int);
-  uint128_t& operator>>=(int);
-  uint128_t& operator&=(uint128_t other);
-  uint128_t& operator|=(uint128_t other);
-  uint128_t& operator^=(uint128_t other);
-  uint128_t& operator++();
-  uint128_t& operator--();
+  ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t& operator/=(uint128_t other);
+  ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t& operator%=(uint128_t other);
+  constexpr uint128_t operator++(int);
+  constexpr uint128_t operator--(int);
+  constexpr uint128_t& operator<<=(int);
+  constexpr uint128_t& operator>>=(int);
+  constexpr uint128_t& operator&=(uint128_t other);
+  constexpr uint128_t& operator|=(uint128_t other);
+  constexpr uint128_t& operator^=(uint128_t other);
+  constexpr uint128_t& operator++();
+  constexpr uint128_t& operator--();
 
   // Uint128Low64()
   //
@@ -266,9 +325,12 @@ class
     return H::combine(std::move(h), Uint128High64(v), Uint128Low64(v));
   }
 
-  // Combined division/modulo for a 128-bit unsigned integer.
-  static void DivMod(uint128_t dividend, uint128_t divisor, uint128_t* quotient_ret,
-                     uint128_t* remainder_ret);
+  // Combined division/modulo for a 128-bit unsigned integer. Usable in
+  // constant expressions, like the division operators.
+  static ABSL_INTERNAL_CONSTEXPR_CLZ void DivMod(uint128_t dividend,
+                                                 uint128_t divisor,
+                                                 uint128_t* quotient_ret,
+                                                 uint128_t* remainder_ret);
 
   static std::string ToFormattedString(uint128_t v, std::ios_base::fmtflags flags = std::ios_base::fmtflags());
 
@@ -302,6 +364,171 @@ constexpr uint128_t Uint128Max() {
                  (std::numeric_limits<uint64_t>::max)());
 }
 
+// Isqrt()
+//
+// Returns the integer square root of `v`, that is the largest `r` such that
+// `r * r <= v`. The result always fits in 64 bits.
+uint128_t Isqrt(uint128_t v);
+
+// Icbrt()
+//
+// Returns the integer cube root of `v`, that is the largest `r` such that
+// `r * r * r <= v`.
+uint128_t Icbrt(uint128_t v);
+
+// Iroot()
+//
+// Returns the integer `n`-th root of `v`, that is the largest `r` such that
+// `r^n <= v`. `n` must be positive.
+//
+// Example:
+//
+//   absl::Iroot(absl::MakeUint128(1, 0), 4);  // == 65536
+uint128_t Iroot(uint128_t v, int n);
+
+// BitWidth()
+//
+// Returns the number of bits needed to represent `v`, that is one more than
+// the index of its most significant set bit, or 0 if `v` is zero. Equivalent
+// to C++20 `std::bit_width()`.
+ABSL_INTERNAL_CONSTEXPR_CLZ int BitWidth(uint128_t v);
+
+// Log2Floor()
+//
+// Returns floor(log2(v)), or -1 if `v` is zero.
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log2Floor(uint128_t v);
+
+// Log10Floor()
+//
+// Returns floor(log10(v)), or -1 if `v` is zero. Computed from the bit width
+// and a table of powers of 10, without any division.
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log10Floor(uint128_t v);
+
+// DecimalDigits()
+//
+// Returns the number of decimal digits `uint128_t::ToString(v)` produces,
+// which is 1 for zero.
+//
+// Example:
+//
+//   absl::DecimalDigits(absl::Uint128Max());  // == 39
+ABSL_INTERNAL_CONSTEXPR_CLZ int DecimalDigits(uint128_t v);
+
+// ToChars()
+//
+// Writes the digits of `v` in `base`, which must be in `[2, 36]`, to
+// `[first, last)` with lowercase letters past 9 and no prefix or terminating
+// null, like `std::to_chars()`. Returns a pointer past the last character
+// written, or `nullptr` if they do not fit, in which case the contents of the
+// range are unspecified. At most 39 decimal or 128 binary digits are written.
+//
+// Unlike `uint128_t::ToString()`, this is usable in constant expressions, so
+// formatted values can be checked with `static_assert`.
+//
+// Example:
+//
+//   char buffer[39];
+//   char* end = absl::ToChars(buffer, buffer + sizeof(buffer), v);
+//   std::string text(buffer, end);
+ABSL_INTERNAL_CONSTEXPR_CLZ char* ToChars(char* first, char* last,
+                                          uint128_t v, int base = 10);
+
+// Bit manipulation
+//
+// The following functions mirror the C++20 <bit> header for `uint128_t`. Each
+// one operates on the two 64-bit halves separately, so with the appropriate
+// target flags they compile to one `popcnt`, `lzcnt`, `tzcnt` or `bswap` per
+// half.
+
+// Popcount()
+//
+// Returns the number of set bits in `v`.
+ABSL_INTERNAL_CONSTEXPR_POPCOUNT int Popcount(uint128_t v);
+
+// CountlZero()
+//
+// Returns the number of consecutive zero bits starting from the most
+// significant bit, which is 128 for zero.
+ABSL_INTERNAL_CONSTEXPR_CLZ int CountlZero(uint128_t v);
+
+// CountrZero()
+//
+// Returns the number of consecutive zero bits starting from the least
+// significant bit, which is 128 for zero.
+ABSL_INTERNAL_CONSTEXPR_CTZ int CountrZero(uint128_t v);
+
+// Rotl()
+// Rotr()
+//
+// Rotate `v` left or right by `shift` bits. `shift` is taken modulo 128, so
+// negative amounts rotate in the opposite direction.
+constexpr uint128_t Rotl(uint128_t v, int shift);
+constexpr uint128_t Rotr(uint128_t v, int shift);
+
+// Byteswap()
+//
+// Reverses the order of the 16 bytes of `v`.
+constexpr uint128_t Byteswap(uint128_t v);
+
+// BitReverse()
+//
+// Reverses the order of the 128 bits of `v`.
+constexpr uint128_t BitReverse(uint128_t v);
+
+// HasSingleBit()
+//
+// Returns true if `v` is a power of two.
+ABSL_INTERNAL_CONSTEXPR_POPCOUNT bool HasSingleBit(uint128_t v);
+
+// BitCeil()
+//
+// Returns the smallest power of two not less than `v`. The behavior is
+// undefined if that value is not representable, that is if `v > 2^127`.
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t BitCeil(uint128_t v);
+
+// BitFloor()
+//
+// Returns the largest power of two not greater than `v`, or 0 if `v` is zero.
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t BitFloor(uint128_t v);
+
+// FunnelShiftLeft()
+//
+// Shifts the 256-bit concatenation `hi:lo` left by `shift` bits and returns
+// the upper 128 bits, like the x86 `shld` instruction. `shift` is taken
+// modulo 128. `FunnelShiftLeft(v, v, shift)` rotates `v` left.
+uint128_t FunnelShiftLeft(uint128_t hi, uint128_t lo, int shift);
+
+// FunnelShiftRight()
+//
+// Shifts the 256-bit concatenation `hi:lo` right by `shift` bits and returns
+// the lower 128 bits, like the x86 `shrd` instruction. `shift` is taken
+// modulo 128.
+uint128_t FunnelShiftRight(uint128_t hi, uint128_t lo, int shift);
+
+// InverseMod2_128()
+//
+// Returns the multiplicative inverse of `v` modulo 2^128, that is the value
+// `x` such that `v * x == 1`. `v` must be odd.
+uint128_t InverseMod2_128(uint128_t v);
+
+// DivExact()
+//
+// Returns `a / d` for a divisor `d` that is known to divide `a` exactly, using
+// only a shift and a multiplication by the inverse of the odd part of `d`.
+// The result is unspecified if `d` does not divide `a`.
+//
+// Example:
+//
+//   absl::uint128_t g = ...;  // gcd(a, b)
+//   absl::uint128_t a_reduced = absl::DivExact(a, g);
+uint128_t DivExact(uint128_t a, uint128_t d);
+
+// IsDivisible()
+//
+// Returns true if `d` divides `a`, without computing a remainder. `d` must be
+// nonzero.
+bool IsDivisible(uint128_t a, uint128_t d);
+
 }  // namespace absl
 
 // Specialized numeric_limits for uint128_t.
@@ -406,14 +633,14 @@ class int128_t {
   explicit int128_t(long double v);
 
   // Assignment operators from arithmetic types
-  int128_t& operator=(int v);
-  int128_t& operator=(unsigned int v);
-  int128_t& operator=(long v);                // NOLINT(runtime/int)
-  int128_t& operator=(unsigned long v);       // NOLINT(runtime/int)
-  int128_t& operator=(long long v);           // NOLINT(runtime/int)
-  int128_t& operator=(unsigned long long v);  // NOLINT(runtime/int)
+  constexpr int128_t& operator=(int v);
+  constexpr int128_t& operator=(unsigned int v);
+  constexpr int128_t& operator=(long v);                // NOLINT(runtime/int)
+  constexpr int128_t& operator=(unsigned long v);       // NOLINT(runtime/int)
+  constexpr int128_t& operator=(long long v);           // NOLINT(runtime/int)
+  constexpr int128_t& operator=(unsigned long long v);  // NOLINT(runtime/int)
 #ifdef ABSL_HAVE_INTRINSIC_INT128
-  int128_t& operator=(__int128_t v);
+  constexpr int128_t& operator=(__int128_t v);
 #endif  // ABSL_HAVE_INTRINSIC_INT128
 
   // Conversion operators to other arithmetic types
@@ -447,20 +674,20 @@ class int128_t {
   // Trivial copy constructor, assignment operator and destructor.
 
   // Arithmetic operators
-  int128_t& operator+=(int128_t other);
-  int128_t& operator-=(int128_t other);
-  int128_t& operator*=(int128_t other);
-  int128_t& operator/=(int128_t other);
-  int128_t& operator%=(int128_t other);
-  int128_t operator++(int);  // postfix increment: i++
-  int128_t operator--(int);  // postfix decrement: i--
-  int128_t& operator++();    // prefix increment:  ++i
-  int128_t& operator--();    // prefix decrement:  --i
-  int128_t& operator&=(int128_t other);
-  int128_t& operator|=(int128_t other);
-  int128_t& operator^=(int128_t other);
-  int128_t& operator<<=(int amount);
-  int128_t& operator>>=(int amount);
+  constexpr int128_t& operator+=(int128_t other);
+  constexpr int128_t& operator-=(int128_t other);
+  ABSL_INTERNAL_CONSTEXPR_MUL int128_t& operator*=(int128_t other);
+  ABSL_INTERNAL_CONSTEXPR_CLZ int128_t& operator/=(int128_t other);
+  ABSL_INTERNAL_CONSTEXPR_CLZ int128_t& operator%=(int128_t other);
+  constexpr int128_t operator++(int);  // postfix increment: i++
+  constexpr int128_t operator--(int);  // postfix decrement: i--
+  constexpr int128_t& operator++();    // prefix increment:  ++i
+  constexpr int128_t& operator--();    // prefix decrement:  --i
+  constexpr int128_t& operator&=(int128_t other);
+  constexpr int128_t& operator|=(int128_t other);
+  constexpr int128_t& operator^=(int128_t other);
+  constexpr int128_t& operator<<=(int amount);
+  constexpr int128_t& operator>>=(int amount);
 
   // Int128Low64()
   //
@@ -505,8 +732,10 @@ class int128_t {
   }
 
   // Combined division/modulo for a 128-bit signed integer.
-  static void DivMod(int128_t dividend, int128_t divisor, int128_t* quotient_ret,
-                     int128_t* remainder_ret);
+  static ABSL_INTERNAL_CONSTEXPR_CLZ void DivMod(int128_t dividend,
+                                                int128_t divisor,
+                                                int128_t* quotient_ret,
+                                                int128_t* remainder_ret);
 
   static std::string ToFormattedString(int128_t v, std::ios_base::fmtflags flags = std::ios_base::fmtflags());
 
@@ -543,6 +772,28 @@ constexpr int128_t Int128Min() {
   return int128_t((std::numeric_limits<int64_t>::min)(), 0);
 }
 
+// BitWidth(), Log2Floor(), Log10Floor(), DecimalDigits()
+//
+// Overloads for `int128_t` that operate on the absolute value of `v`, so
+// `DecimalDigits(v)` does not count the sign of a negative value.
+ABSL_INTERNAL_CONSTEXPR_CLZ int BitWidth(int128_t v);
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log2Floor(int128_t v);
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log10Floor(int128_t v);
+ABSL_INTERNAL_CONSTEXPR_CLZ int DecimalDigits(int128_t v);
+
+// ToChars()
+//
+// Overload for `int128_t` that writes a '-' before the digits of a negative
+// value, so at most 40 characters in base 10.
+ABSL_INTERNAL_CONSTEXPR_CLZ char* ToChars(char* first, char* last, int128_t v,
+                                          int base = 10);
+
+// DivExact(), IsDivisible()
+//
+// Overloads for `int128_t`. See the `uint128_t` versions above.
+int128_t DivExact(int128_t a, int128_t d);
+bool IsDivisible(int128_t a, int128_t d);
+
 }  // namespace absl
 
 // Specialized numeric_limits for int128_t.
@@ -601,86 +852,88 @@ constexpr uint128_t MakeUint128(uint64_t high, uint64_t low) {
 
 // Assignment from integer types.
 
-inline uint128_t& uint128_t::operator=(int v) { return *this = uint128_t(v); }
+constexpr uint128_t& uint128_t::operator=(int v) {
+  return *this = uint128_t(v);
+}
 
-inline uint128_t& uint128_t::operator=(unsigned int v) {
+constexpr uint128_t& uint128_t::operator=(unsigned int v) {
   return *this = uint128_t(v);
 }
 
-inline uint128_t& uint128_t::operator=(long v) {  // NOLINT(runtime/int)
+constexpr uint128_t& uint128_t::operator=(long v) {  // NOLINT(runtime/int)
   return *this = uint128_t(v);
 }
 
 // NOLINTNEXTLINE(runtime/int)
-inline uint128_t& uint128_t::operator=(unsigned long v) {
+constexpr uint128_t& uint128_t::operator=(unsigned long v) {
   return *this = uint128_t(v);
 }
 
 // NOLINTNEXTLINE(runtime/int)
-inline uint128_t& uint128_t::operator=(long long v) {
+constexpr uint128_t& uint128_t::operator=(long long v) {
   return *this = uint128_t(v);
 }
 
 // NOLINTNEXTLINE(runtime/int)
-inline uint128_t& uint128_t::operator=(unsigned long long v) {
+constexpr uint128_t& uint128_t::operator=(unsigned long long v) {
   return *this = uint128_t(v);
 }
 
 #ifdef ABSL_HAVE_INTRINSIC_INT128
-inline uint128_t& uint128_t::operator=(__int128_t v) {
+constexpr uint128_t& uint128_t::operator=(__int128_t v) {
   return *this = uint128_t(v);
 }
 
-inline uint128_t& uint128_t::operator=(unsigned __int128_t v) {
+constexpr uint128_t& uint128_t::operator=(unsigned __int128_t v) {
   return *this = uint128_t(v);
 }
 #endif  // ABSL_HAVE_INTRINSIC_INT128
 
-inline uint128_t& uint128_t::operator=(int128_t v) {
+constexpr uint128_t& uint128_t::operator=(int128_t v) {
   return *this = uint128_t(v);
 }
 
 // Arithmetic operators.
 
-uint128_t operator<<(uint128_t lhs, int amount);
-uint128_t operator>>(uint128_t lhs, int amount);
-uint128_t operator+(uint128_t lhs, uint128_t rhs);
-uint128_t operator-(uint128_t lhs, uint128_t rhs);
-uint128_t operator*(uint128_t lhs, uint128_t rhs);
-uint128_t operator/(uint128_t lhs, uint128_t rhs);
-uint128_t operator%(uint128_t lhs, uint128_t rhs);
+constexpr uint128_t operator<<(uint128_t lhs, int amount);
+constexpr uint128_t operator>>(uint128_t lhs, int amount);
+constexpr uint128_t operator+(uint128_t lhs, uint128_t rhs);
+constexpr uint128_t operator-(uint128_t lhs, uint128_t rhs);
+ABSL_INTERNAL_CONSTEXPR_MUL uint128_t operator*(uint128_t lhs, uint128_t rhs);
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t operator/(uint128_t lhs, uint128_t rhs);
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t operator%(uint128_t lhs, uint128_t rhs);
 
-inline uint128_t& uint128_t::operator<<=(int amount) {
+constexpr uint128_t& uint128_t::operator<<=(int amount) {
   *this = *this << amount;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator>>=(int amount) {
+constexpr uint128_t& uint128_t::operator>>=(int amount) {
   *this = *this >> amount;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator+=(uint128_t other) {
+constexpr uint128_t& uint128_t::operator+=(uint128_t other) {
   *this = *this + other;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator-=(uint128_t other) {
+constexpr uint128_t& uint128_t::operator-=(uint128_t other) {
   *this = *this - other;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator*=(uint128_t other) {
+ABSL_INTERNAL_CONSTEXPR_MUL uint128_t& uint128_t::operator*=(uint128_t other) {
   *this = *this * other;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator/=(uint128_t other) {
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t& uint128_t::operator/=(uint128_t other) {
   *this = *this / other;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator%=(uint128_t other) {
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t& uint128_t::operator%=(uint128_t other) {
   *this = *this % other;
   return *this;
 }
@@ -842,16 +1095,16 @@ inline uint128_t::operator long double() const {
 
 // Comparison operators.
 
-inline bool operator==(uint128_t lhs, uint128_t rhs) {
+constexpr bool operator==(uint128_t lhs, uint128_t rhs) {
   return (Uint128Low64(lhs) == Uint128Low64(rhs) &&
           Uint128High64(lhs) == Uint128High64(rhs));
 }
 
-inline bool operator!=(uint128_t lhs, uint128_t rhs) {
+constexpr bool operator!=(uint128_t lhs, uint128_t rhs) {
   return !(lhs == rhs);
 }
 
-inline bool operator<(uint128_t lhs, uint128_t rhs) {
+constexpr bool operator<(uint128_t lhs, uint128_t rhs) {
 #ifdef ABSL_HAVE_INTRINSIC_INT128
   return static_cast<unsigned __int128_t>(lhs) <
          static_cast<unsigned __int128_t>(rhs);
@@ -862,59 +1115,59 @@ inline bool operator<(uint128_t lhs, uint128_t rhs) {
 #endif
 }
 
-inline bool operator>(uint128_t lhs, uint128_t rhs) { return rhs < lhs; }
+constexpr bool operator>(uint128_t lhs, uint128_t rhs) { return rhs < lhs; }
 
-inline bool operator<=(uint128_t lhs, uint128_t rhs) { return !(rhs < lhs); }
+constexpr bool operator<=(uint128_t lhs, uint128_t rhs) { return !(rhs < lhs); }
 
-inline bool operator>=(uint128_t lhs, uint128_t rhs) { return !(lhs < rhs); }
+constexpr bool operator>=(uint128_t lhs, uint128_t rhs) { return !(lhs < rhs); }
 
 // Unary operators.
 
-inline uint128_t operator-(uint128_t val) {
+constexpr uint128_t operator-(uint128_t val) {
   uint64_t hi = ~Uint128High64(val);
   uint64_t lo = ~Uint128Low64(val) + 1;
   if (lo == 0) ++hi;  // carry
   return MakeUint128(hi, lo);
 }
 
-inline bool operator!(uint128_t val) {
+constexpr bool operator!(uint128_t val) {
   return !Uint128High64(val) && !Uint128Low64(val);
 }
 
 // Logical operators.
 
-inline uint128_t operator~(uint128_t val) {
+constexpr uint128_t operator~(uint128_t val) {
   return MakeUint128(~Uint128High64(val), ~Uint128Low64(val));
 }
 
-inline uint128_t operator|(uint128_t lhs, uint128_t rhs) {
+constexpr uint128_t operator|(uint128_t lhs, uint128_t rhs) {
   return MakeUint128(Uint128High64(lhs) | Uint128High64(rhs),
                            Uint128Low64(lhs) | Uint128Low64(rhs));
 }
 
-inline uint128_t operator&(uint128_t lhs, uint128_t rhs) {
+constexpr uint128_t operator&(uint128_t lhs, uint128_t rhs) {
   return MakeUint128(Uint128High64(lhs) & Uint128High64(rhs),
                            Uint128Low64(lhs) & Uint128Low64(rhs));
 }
 
-inline uint128_t operator^(uint128_t lhs, uint128_t rhs) {
+constexpr uint128_t operator^(uint128_t lhs, uint128_t rhs) {
   return MakeUint128(Uint128High64(lhs) ^ Uint128High64(rhs),
                            Uint128Low64(lhs) ^ Uint128Low64(rhs));
 }
 
-inline uint128_t& uint128_t::operator|=(uint128_t other) {
+constexpr uint128_t& uint128_t::operator|=(uint128_t other) {
   hi_ |= other.hi_;
   lo_ |= other.lo_;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator&=(uint128_t other) {
+constexpr uint128_t& uint128_t::operator&=(uint128_t other) {
   hi_ &= other.hi_;
   lo_ &= other.lo_;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator^=(uint128_t other) {
+constexpr uint128_t& uint128_t::operator^=(uint128_t other) {
   hi_ ^= other.hi_;
   lo_ ^= other.lo_;
   return *this;
@@ -922,43 +1175,43 @@ inline uint128_t& uint128_t::operator^=(uint128_t other) {
 
 // Arithmetic operators.
 
-inline uint128_t operator<<(uint128_t lhs, int amount) {
+constexpr uint128_t operator<<(uint128_t lhs, int amount) {
 #ifdef ABSL_HAVE_INTRINSIC_INT128
   return static_cast<unsigned __int128_t>(lhs) << amount;
 #else
-  // uint64_t shifts of >= 64 are undefined, so we will need some
-  // special-casing.
-  if (amount < 64) {
-    if (amount != 0) {
-      return MakeUint128(
-          (Uint128High64(lhs) << amount) | (Uint128Low64(lhs) >> (64 - amount)),
-          Uint128Low64(lhs) << amount);
-    }
-    return lhs;
-  }
-  return MakeUint128(Uint128Low64(lhs) << (amount - 64), 0);
+  // uint64_t shifts of >= 64 are undefined. Rather than branching on the
+  // amount, which mispredicts when it varies, shift both halves by
+  // `amount % 64` and select the result with a mask derived from bit 6. The
+  // bits carried into the high half are shifted in two steps so that a zero
+  // amount does not become a shift by 64.
+  const uint64_t lo = Uint128Low64(lhs);
+  const int s = amount & 63;
+  const uint64_t mask = 0 - static_cast<uint64_t>((amount >> 6) & 1);
+  const uint64_t shifted_lo = lo << s;
+  const uint64_t shifted_hi =
+      (Uint128High64(lhs) << s) | ((lo >> 1) >> (63 - s));
+  return MakeUint128((shifted_hi & ~mask) | (shifted_lo & mask),
+                     shifted_lo & ~mask);
 #endif
 }
 
-inline uint128_t operator>>(uint128_t lhs, int amount) {
+constexpr uint128_t operator>>(uint128_t lhs, int amount) {
 #ifdef ABSL_HAVE_INTRINSIC_INT128
   return static_cast<unsigned __int128_t>(lhs) >> amount;
 #else
-  // uint64_t shifts of >= 64 are undefined, so we will need some
-  // special-casing.
-  if (amount < 64) {
-    if (amount != 0) {
-      return MakeUint128(Uint128High64(lhs) >> amount,
-                         (Uint128Low64(lhs) >> amount) |
-                             (Uint128High64(lhs) << (64 - amount)));
-    }
-    return lhs;
-  }
-  return MakeUint128(0, Uint128High64(lhs) >> (amount - 64));
+  // See operator<< above for why this does not branch on `amount`.
+  const uint64_t hi = Uint128High64(lhs);
+  const int s = amount & 63;
+  const uint64_t mask = 0 - static_cast<uint64_t>((amount >> 6) & 1);
+  const uint64_t shifted_hi = hi >> s;
+  const uint64_t shifted_lo =
+      (Uint128Low64(lhs) >> s) | ((hi << 1) << (63 - s));
+  return MakeUint128(shifted_hi & ~mask,
+                     (shifted_lo & ~mask) | (shifted_hi & mask));
 #endif
 }
 
-inline uint128_t operator+(uint128_t lhs, uint128_t rhs) {
+constexpr uint128_t operator+(uint128_t lhs, uint128_t rhs) {
   uint128_t result = MakeUint128(Uint128High64(lhs) + Uint128High64(rhs),
                                Uint128Low64(lhs) + Uint128Low64(rhs));
   if (Uint128Low64(result) < Uint128Low64(lhs)) {  // check for carry
@@ -967,7 +1220,7 @@ inline uint128_t operator+(uint128_t lhs, uint128_t rhs) {
   return result;
 }
 
-inline uint128_t operator-(uint128_t lhs, uint128_t rhs) {
+constexpr uint128_t operator-(uint128_t lhs, uint128_t rhs) {
   uint128_t result = MakeUint128(Uint128High64(lhs) - Uint128High64(rhs),
                                Uint128Low64(lhs) - Uint128Low64(rhs));
   if (Uint128Low64(lhs) < Uint128Low64(rhs)) {  // check for carry
@@ -976,13 +1229,13 @@ inline uint128_t operator-(uint128_t lhs, uint128_t rhs) {
   return result;
 }
 
-inline uint128_t operator*(uint128_t lhs, uint128_t rhs) {
+ABSL_INTERNAL_CONSTEXPR_MUL uint128_t operator*(uint128_t lhs, uint128_t rhs) {
 #if defined(ABSL_HAVE_INTRINSIC_INT128)
   // TODO(strel) Remove once alignment issues are resolved and unsigned __int128_t
   // can be used for uint128_t storage.
   return static_cast<unsigned __int128_t>(lhs) *
          static_cast<unsigned __int128_t>(rhs);
-#elif defined(_MSC_VER) && defined(_M_X64)
+#elif defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
   uint64_t carry;
   uint64_t low = _umul128(Uint128Low64(lhs), Uint128Low64(rhs), &carry);
   return MakeUint128(Uint128Low64(lhs) * Uint128High64(rhs) +
@@ -1005,24 +1258,24 @@ inline uint128_t operator*(uint128_t lhs, uint128_t rhs) {
 
 // Increment/decrement operators.
 
-inline uint128_t uint128_t::operator++(int) {
+constexpr uint128_t uint128_t::operator++(int) {
   uint128_t tmp(*this);
   *this += 1;
   return tmp;
 }
 
-inline uint128_t uint128_t::operator--(int) {
+constexpr uint128_t uint128_t::operator--(int) {
   uint128_t tmp(*this);
   *this -= 1;
   return tmp;
 }
 
-inline uint128_t& uint128_t::operator++() {
+constexpr uint128_t& uint128_t::operator++() {
   *this += 1;
   return *this;
 }
 
-inline uint128_t& uint128_t::operator--() {
+constexpr uint128_t& uint128_t::operator--() {
   *this -= 1;
   return *this;
 }
@@ -1032,92 +1285,92 @@ constexpr int128_t MakeInt128(int64_t high, uint64_t low) {
 }
 
 // Assignment from integer types.
-inline int128_t& int128_t::operator=(int v) {
+constexpr int128_t& int128_t::operator=(int v) {
   return *this = int128_t(v);
 }
 
-inline int128_t& int128_t::operator=(unsigned int v) {
+constexpr int128_t& int128_t::operator=(unsigned int v) {
   return *this = int128_t(v);
 }
 
-inline int128_t& int128_t::operator=(long v) {  // NOLINT(runtime/int)
+constexpr int128_t& int128_t::operator=(long v) {  // NOLINT(runtime/int)
   return *this = int128_t(v);
 }
 
 // NOLINTNEXTLINE(runtime/int)
-inline int128_t& int128_t::operator=(unsigned long v) {
+constexpr int128_t& int128_t::operator=(unsigned long v) {
   return *this = int128_t(v);
 }
 
 // NOLINTNEXTLINE(runtime/int)
-inline int128_t& int128_t::operator=(long long v) {
+constexpr int128_t& int128_t::operator=(long long v) {
   return *this = int128_t(v);
 }
 
 // NOLINTNEXTLINE(runtime/int)
-inline int128_t& int128_t::operator=(unsigned long long v) {
+constexpr int128_t& int128_t::operator=(unsigned long long v) {
   return *this = int128_t(v);
 }
 
 // Arithmetic operators.
 
-int128_t operator+(int128_t lhs, int128_t rhs);
-int128_t operator-(int128_t lhs, int128_t rhs);
-int128_t operator*(int128_t lhs, int128_t rhs);
-int128_t operator/(int128_t lhs, int128_t rhs);
-int128_t operator%(int128_t lhs, int128_t rhs);
-int128_t operator|(int128_t lhs, int128_t rhs);
-int128_t operator&(int128_t lhs, int128_t rhs);
-int128_t operator^(int128_t lhs, int128_t rhs);
-int128_t operator<<(int128_t lhs, int amount);
-int128_t operator>>(int128_t lhs, int amount);
-
-inline int128_t& int128_t::operator+=(int128_t other) {
+constexpr int128_t operator+(int128_t lhs, int128_t rhs);
+constexpr int128_t operator-(int128_t lhs, int128_t rhs);
+ABSL_INTERNAL_CONSTEXPR_MUL int128_t operator*(int128_t lhs, int128_t rhs);
+ABSL_INTERNAL_CONSTEXPR_CLZ int128_t operator/(int128_t lhs, int128_t rhs);
+ABSL_INTERNAL_CONSTEXPR_CLZ int128_t operator%(int128_t lhs, int128_t rhs);
+constexpr int128_t operator|(int128_t lhs, int128_t rhs);
+constexpr int128_t operator&(int128_t lhs, int128_t rhs);
+constexpr int128_t operator^(int128_t lhs, int128_t rhs);
+constexpr int128_t operator<<(int128_t lhs, int amount);
+constexpr int128_t operator>>(int128_t lhs, int amount);
+
+constexpr int128_t& int128_t::operator+=(int128_t other) {
   *this = *this + other;
   return *this;
 }
 
-inline int128_t& int128_t::operator-=(int128_t other) {
+constexpr int128_t& int128_t::operator-=(int128_t other) {
   *this = *this - other;
   return *this;
 }
 
-inline int128_t& int128_t::operator*=(int128_t other) {
+ABSL_INTERNAL_CONSTEXPR_MUL int128_t& int128_t::operator*=(int128_t other) {
   *this = *this * other;
   return *this;
 }
 
-inline int128_t& int128_t::operator/=(int128_t other) {
+ABSL_INTERNAL_CONSTEXPR_CLZ int128_t& int128_t::operator/=(int128_t other) {
   *this = *this / other;
   return *this;
 }
 
-inline int128_t& int128_t::operator%=(int128_t other) {
+ABSL_INTERNAL_CONSTEXPR_CLZ int128_t& int128_t::operator%=(int128_t other) {
   *this = *this % other;
   return *this;
 }
 
-inline int128_t& int128_t::operator|=(int128_t other) {
+constexpr int128_t& int128_t::operator|=(int128_t other) {
   *this = *this | other;
   return *this;
 }
 
-inline int128_t& int128_t::operator&=(int128_t other) {
+constexpr int128_t& int128_t::operator&=(int128_t other) {
   *this = *this & other;
   return *this;
 }
 
-inline int128_t& int128_t::operator^=(int128_t other) {
+constexpr int128_t& int128_t::operator^=(int128_t other) {
   *this = *this ^ other;
   return *this;
 }
 
-inline int128_t& int128_t::operator<<=(int amount) {
+constexpr int128_t& int128_t::operator<<=(int amount) {
   *this = *this << amount;
   return *this;
 }
 
-inline int128_t& int128_t::operator>>=(int amount) {
+constexpr int128_t& int128_t::operator>>=(int amount) {
   *this = *this >> amount;
   return *this;
 }
@@ -1136,16 +1389,754 @@ constexpr int64_t BitCastToSigned(uint64_t v) {
                                  : static_cast<int64_t>(v);
 }
 
+// Returns the number of leading zero bits in `n`, which is 64 for zero.
+constexpr int CountLeadingZeros64Slow(uint64_t n) {
+  int zeroes = 60;
+  if (n >> 32) {
+    zeroes -= 32;
+    n >>= 32;
+  }
+  if (n >> 16) {
+    zeroes -= 16;
+    n >>= 16;
+  }
+  if (n >> 8) {
+    zeroes -= 8;
+    n >>= 8;
+  }
+  if (n >> 4) {
+    zeroes -= 4;
+    n >>= 4;
+  }
+  return "\4\3\2\2\1\1\1\1\0\0\0\0\0\0\0"[n] + zeroes;
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int CountLeadingZeros64(uint64_t n) {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+  // MSVC does not have __buitin_clzll. Use _BitScanReverse64.
+  unsigned long result = 0;  // NOLINT(runtime/int)
+  if (_BitScanReverse64(&result, n)) {
+    return 63 - result;
+  }
+  return 64;
+#elif defined(_MSC_VER) && !defined(__clang__)
+  // MSVC does not have __buitin_clzll. Compose two calls to _BitScanReverse
+  unsigned long result = 0;  // NOLINT(runtime/int)
+  if ((n >> 32) &&
+      _BitScanReverse(&result, static_cast<unsigned long>(n >> 32))) {
+    return 31 - result;
+  }
+  if (_BitScanReverse(&result, static_cast<unsigned long>(n))) {
+    return 63 - result;
+  }
+  return 64;
+#elif defined(__GNUC__) || defined(__clang__)
+  // Use __builtin_clzll, which uses the following instructions:
+  //  x86: bsr
+  //  ARM64: clz
+  //  PPC: cntlzd
+  static_assert(sizeof(unsigned long long) == sizeof(n),  // NOLINT(runtime/int)
+                "__builtin_clzll does not take 64-bit arg");
+
+  // Handle 0 as a special case because __builtin_clzll(0) is undefined.
+  if (n == 0) {
+    return 64;
+  }
+  return __builtin_clzll(n);
+#else
+  return CountLeadingZeros64Slow(n);
+#endif
+}
+
+// Returns the 0-based position of the last set bit (i.e., most significant bit)
+// in the given uint128_t. The argument is not 0.
+//
+// For example:
+//   Given: 5 (decimal) == 101 (binary)
+//   Returns: 2
+ABSL_INTERNAL_CONSTEXPR_CLZ int Fls128(uint128_t n) {
+  return Uint128High64(n) != 0 ? 127 - CountLeadingZeros64(Uint128High64(n))
+                               : 63 - CountLeadingZeros64(Uint128Low64(n));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CTZ int CountTrailingZeros64(uint64_t n) {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+  unsigned long result = 0;  // NOLINT(runtime/int)
+  return _BitScanForward64(&result, n) ? static_cast<int>(result) : 64;
+#elif defined(__GNUC__) || defined(__clang__)
+  // Use __builtin_ctzll, which compiles to tzcnt or bsf on x86 and rbit+clz
+  // on ARM64. __builtin_ctzll(0) is undefined.
+  return n == 0 ? 64 : __builtin_ctzll(n);
+#else
+  return n == 0 ? 64 : 63 - CountLeadingZeros64(n & (~n + 1));
+#endif
+}
+
+ABSL_INTERNAL_CONSTEXPR_POPCOUNT int Popcount64(uint64_t n) {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+  return static_cast<int>(__popcnt64(n));
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(n);
+#else
+  n -= (n >> 1) & 0x5555555555555555;
+  n = (n & 0x3333333333333333) + ((n >> 2) & 0x3333333333333333);
+  n = (n + (n >> 4)) & 0x0f0f0f0f0f0f0f0f;
+  return static_cast<int>((n * 0x0101010101010101) >> 56);
+#endif
+}
+
+constexpr uint64_t Byteswap64(uint64_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap64(n);
+#else
+  n = ((n & 0x00ff00ff00ff00ff) << 8) | ((n >> 8) & 0x00ff00ff00ff00ff);
+  n = ((n & 0x0000ffff0000ffff) << 16) | ((n >> 16) & 0x0000ffff0000ffff);
+  return (n << 32) | (n >> 32);
+#endif
+}
+
+constexpr uint64_t BitReverse64(uint64_t n) {
+#if defined(__clang__)
+  return __builtin_bitreverse64(n);
+#else
+  // Reverse the bytes, then the bits within each byte.
+  n = Byteswap64(n);
+  n = ((n & 0x0f0f0f0f0f0f0f0f) << 4) | ((n >> 4) & 0x0f0f0f0f0f0f0f0f);
+  n = ((n & 0x3333333333333333) << 2) | ((n >> 2) & 0x3333333333333333);
+  return ((n & 0x5555555555555555) << 1) | ((n >> 1) & 0x5555555555555555);
+#endif
+}
+
+// Returns 2^n. `n` is less than 128.
+constexpr uint128_t PowerOf2(int n) {
+  return n < 64 ? MakeUint128(0, uint64_t{1} << n)
+                : MakeUint128(uint64_t{1} << (n - 64), 0);
+}
+
+// Returns |v| without the undefined behavior of negating Int128Min().
+constexpr uint128_t UnsignedAbs(int128_t v);
+
+// kPowersOf10[i] == 10^i for every power of 10 that fits in a uint128_t.
+constexpr uint128_t kPowersOf10[] = {
+    MakeUint128(0x0u, 0x1u),
+    MakeUint128(0x0u, 0xau),
+    MakeUint128(0x0u, 0x64u),
+    MakeUint128(0x0u, 0x3e8u),
+    MakeUint128(0x0u, 0x2710u),
+    MakeUint128(0x0u, 0x186a0u),
+    MakeUint128(0x0u, 0xf4240u),
+    MakeUint128(0x0u, 0x989680u),
+    MakeUint128(0x0u, 0x5f5e100u),
+    MakeUint128(0x0u, 0x3b9aca00u),
+    MakeUint128(0x0u, 0x2540be400u),
+    MakeUint128(0x0u, 0x174876e800u),
+    MakeUint128(0x0u, 0xe8d4a51000u),
+    MakeUint128(0x0u, 0x9184e72a000u),
+    MakeUint128(0x0u, 0x5af3107a4000u),
+    MakeUint128(0x0u, 0x38d7ea4c68000u),
+    MakeUint128(0x0u, 0x2386f26fc10000u),
+    MakeUint128(0x0u, 0x16345785d8a0000u),
+    MakeUint128(0x0u, 0xde0b6b3a7640000u),
+    MakeUint128(0x0u, 0x8ac7230489e80000u),
+    MakeUint128(0x5u, 0x6bc75e2d63100000u),
+    MakeUint128(0x36u, 0x35c9adc5dea00000u),
+    MakeUint128(0x21eu, 0x19e0c9bab2400000u),
+    MakeUint128(0x152du, 0x2c7e14af6800000u),
+    MakeUint128(0xd3c2u, 0x1bcecceda1000000u),
+    MakeUint128(0x84595u, 0x161401484a000000u),
+    MakeUint128(0x52b7d2u, 0xdcc80cd2e4000000u),
+    MakeUint128(0x33b2e3cu, 0x9fd0803ce8000000u),
+    MakeUint128(0x204fce5eu, 0x3e25026110000000u),
+    MakeUint128(0x1431e0faeu, 0x6d7217caa0000000u),
+    MakeUint128(0xc9f2c9cd0u, 0x4674edea40000000u),
+    MakeUint128(0x7e37be2022u, 0xc0914b2680000000u),
+    MakeUint128(0x4ee2d6d415bu, 0x85acef8100000000u),
+    MakeUint128(0x314dc6448d93u, 0x38c15b0a00000000u),
+    MakeUint128(0x1ed09bead87c0u, 0x378d8e6400000000u),
+    MakeUint128(0x13426172c74d82u, 0x2b878fe800000000u),
+    MakeUint128(0xc097ce7bc90715u, 0xb34b9f1000000000u),
+    MakeUint128(0x785ee10d5da46d9u, 0xf436a000000000u),
+    MakeUint128(0x4b3b4ca85a86c47au, 0x98a224000000000u),
+};
+
+// Returns the full 128-bit product of two 64-bit values.
+inline uint128_t Multiply64To128(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  const unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+  return MakeUint128(static_cast<uint64_t>(p >> 64), static_cast<uint64_t>(p));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  uint64_t high;
+  const uint64_t low = _umul128(a, b, &high);
+  return MakeUint128(high, low);
+#else
+  return uint128_t(a) * b;
+#endif
+}
+
+// Returns the low half of the full 256-bit product of two 128-bit values and
+// stores the high half in `*high`.
+inline uint128_t Multiply128To256(uint128_t a, uint128_t b, uint128_t* high) {
+  const uint128_t ll = Multiply64To128(Uint128Low64(a), Uint128Low64(b));
+  const uint128_t lh = Multiply64To128(Uint128Low64(a), Uint128High64(b));
+  const uint128_t hl = Multiply64To128(Uint128High64(a), Uint128Low64(b));
+  const uint128_t hh = Multiply64To128(Uint128High64(a), Uint128High64(b));
+  // At most 3 * (2^64 - 1), so the sum of the middle column cannot overflow.
+  const uint128_t mid = uint128_t(Uint128High64(ll)) + Uint128Low64(lh) +
+                        Uint128Low64(hl);
+  *high = hh + Uint128High64(lh) + Uint128High64(hl) + Uint128High64(mid);
+  return MakeUint128(Uint128Low64(mid), Uint128Low64(ll));
+}
+
+// Returns the quotient of the 128-bit value `high:low` by `divisor`, which
+// must be greater than `high` so that the quotient fits in 64 bits, and
+// stores the remainder in `*remainder`. This is Knuth's algorithm D with
+// 32-bit digits ("divlu" in Hacker's Delight), which needs no 128-bit
+// arithmetic and so works in constant expressions.
+ABSL_INTERNAL_CONSTEXPR_CLZ uint64_t Divide128By64(uint64_t high, uint64_t low,
+                                                   uint64_t divisor,
+                                                   uint64_t* remainder) {
+  constexpr uint64_t kBase = uint64_t{1} << 32;
+  // Normalizing the divisor to set its top bit makes each estimated quotient
+  // digit at most two too large. The low half is shifted in two steps so that
+  // a zero shift does not become a shift by 64.
+  const int s = CountLeadingZeros64(divisor);
+  divisor <<= s;
+  const uint64_t d1 = divisor >> 32;
+  const uint64_t d0 = divisor & 0xffffffff;
+  const uint64_t u32 = (high << s) | ((low >> 1) >> (63 - s));
+  const uint64_t u1 = (low << s) >> 32;
+  const uint64_t u0 = (low << s) & 0xffffffff;
+
+  uint64_t q1 = u32 / d1;
+  uint64_t r = u32 - q1 * d1;
+  while (q1 >= kBase || q1 * d0 > ((r << 32) | u1)) {
+    --q1;
+    r += d1;
+    if (r >= kBase) break;
+  }
+  // The top digit of the partial remainder cancels, so this is exact modulo
+  // 2^64.
+  const uint64_t u21 = ((u32 << 32) | u1) - q1 * divisor;
+
+  uint64_t q0 = u21 / d1;
+  r = u21 - q0 * d1;
+  while (q0 >= kBase || q0 * d0 > ((r << 32) | u0)) {
+    --q0;
+    r += d1;
+    if (r >= kBase) break;
+  }
+  *remainder = (((u21 << 32) | u0) - q0 * divisor) >> s;
+  return (q1 << 32) | q0;
+}
+
+// Writes the `count` lowest digits of `v` in `base`, including leading
+// zeros, to the `count` characters before `end`.
+constexpr void WriteDigits64(uint64_t v, uint64_t base, int count, char* end) {
+  for (int i = 0; i < count; ++i) {
+    *--end = "0123456789abcdefghijklmnopqrstuvwxyz"[v % base];
+    v /= base;
+  }
+}
+
+// Hashes the limbs of a 128-bit value with two rounds of the "mum" mix of
+// wyhash, a 64x64->128 multiply whose halves are folded together, and the
+// finalizer of MurmurHash3. The first round multiplies the limbs, each xor-ed
+// with an odd constant. A product is zero when one of its factors is, so the
+// second round multiplies the first hash xor-ed with each limb in turn, which
+// still mixes both limbs of the keys that zero the first. When the first
+// product is that of a limb with 0 or 1, one factor of the second is constant;
+// the finalizer, a bijection, spreads those hashes over all the bits.
+constexpr uint64_t kHashSecret0 = 0xa0761d6478bd642fu;
+constexpr uint64_t kHashSecret1 = 0xe7037ed1a0b428dbu;
+constexpr uint64_t kHashSecret2 = 0x8ebc6af09c88c6e3u;
+constexpr uint64_t kHashSecret3 = 0x589965cc75374cc3u;
+
+inline uint64_t Hash128(uint64_t high, uint64_t low) {
+  const uint128_t p = Multiply64To128(low ^ kHashSecret0, high ^ kHashSecret1);
+  const uint64_t h = Uint128High64(p) ^ Uint128Low64(p);
+  const uint128_t q =
+      Multiply64To128(h ^ low ^ kHashSecret2, h ^ high ^ kHashSecret3);
+  uint64_t x = Uint128High64(q) ^ Uint128Low64(q);
+  x = (x ^ (x >> 33)) * 0xff51afd7ed558ccdu;
+  x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53u;
+  return x ^ (x >> 33);
+}
+
+// Fetches the cache line holding `address`. GCC treats a prefetch as free of
+// side effects, so it deletes calls to a function that only prefetches unless
+// it has already inlined them. This helper, and any function that does no more
+// than call it, must therefore be always inlined.
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline void Prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+  static_cast<void>(address);
+#endif
+}
+
 }  // namespace int128_t_internal
 
+ABSL_INTERNAL_CONSTEXPR_CLZ void uint128_t::DivMod(uint128_t dividend,
+                                                   uint128_t divisor,
+                                                   uint128_t* quotient_ret,
+                                                   uint128_t* remainder_ret) {
+  assert(divisor != 0);
+  const uint64_t high = Uint128High64(dividend);
+  const uint64_t low = Uint128Low64(dividend);
+
+  if (Uint128High64(divisor) == 0) {
+    const uint64_t d = Uint128Low64(divisor);
+    if (high == 0) {
+      *quotient_ret = low / d;
+      *remainder_ret = low % d;
+      return;
+    }
+    // Divide the high half first, so the rest has a 64-bit quotient.
+    uint64_t remainder = 0;
+    const uint64_t quotient_low =
+        int128_t_internal::Divide128By64(high % d, low, d, &remainder);
+    *quotient_ret = MakeUint128(high / d, quotient_low);
+    *remainder_ret = remainder;
+    return;
+  }
+
+  if (divisor > dividend) {
+    *quotient_ret = 0;
+    *remainder_ret = dividend;
+    return;
+  }
+
+  // The quotient fits in 64 bits. Dividing `dividend / 2` by the top 64 bits
+  // of the normalized divisor estimates it to within one after scaling back
+  // (Hacker's Delight, section 9-5); the halving keeps that division from
+  // overflowing.
+  const int n = int128_t_internal::CountLeadingZeros64(Uint128High64(divisor));
+  const uint64_t top = Uint128High64(divisor << n);
+  const uint128_t half = dividend >> 1;
+  uint64_t unused = 0;
+  uint64_t quotient = int128_t_internal::Divide128By64(
+                          Uint128High64(half), Uint128Low64(half), top,
+                          &unused) >>
+                      (63 - n);
+  if (quotient != 0) --quotient;
+  uint128_t remainder = dividend - divisor * quotient;
+  if (remainder >= divisor) {
+    ++quotient;
+    remainder -= divisor;
+  }
+  *quotient_ret = quotient;
+  *remainder_ret = remainder;
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t operator/(uint128_t lhs, uint128_t rhs) {
+#if defined(ABSL_HAVE_INTRINSIC_INT128)
+  return static_cast<unsigned __int128>(lhs) /
+         static_cast<unsigned __int128>(rhs);
+#else  // ABSL_HAVE_INTRINSIC_INT128
+  uint128_t quotient = 0;
+  uint128_t remainder = 0;
+  uint128_t::DivMod(lhs, rhs, &quotient, &remainder);
+  return quotient;
+#endif  // ABSL_HAVE_INTRINSIC_INT128
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t operator%(uint128_t lhs, uint128_t rhs) {
+#if defined(ABSL_HAVE_INTRINSIC_INT128)
+  return static_cast<unsigned __int128>(lhs) %
+         static_cast<unsigned __int128>(rhs);
+#else  // ABSL_HAVE_INTRINSIC_INT128
+  uint128_t quotient = 0;
+  uint128_t remainder = 0;
+  uint128_t::DivMod(lhs, rhs, &quotient, &remainder);
+  return remainder;
+#endif  // ABSL_HAVE_INTRINSIC_INT128
+}
+
+namespace int128_t_internal {
+
+ABSL_ATTRIBUTE_ALWAYS_INLINE ABSL_INTERNAL_CONSTEXPR_CLZ char* ToCharsInBase(
+    char* first, char* last, uint128_t v, uint64_t base) {
+  // Split `v` into at most three chunks below `base^k`, the largest power of
+  // `base` that fits in 64 bits, so that the digits themselves come from
+  // 64-bit arithmetic.
+  uint64_t chunk = base;
+  int k = 1;
+  while (chunk <= (std::numeric_limits<uint64_t>::max)() / base) {
+    chunk *= base;
+    ++k;
+  }
+  uint128_t high = 0;
+  uint128_t mid = 0;
+  uint128_t low = 0;
+  uint128_t::DivMod(v, chunk, &high, &low);
+  uint128_t::DivMod(high, chunk, &high, &mid);
+  const uint64_t chunks[3] = {Uint128Low64(low), Uint128Low64(mid),
+                              Uint128Low64(high)};
+  const int lead = high != 0 ? 2 : mid != 0 ? 1 : 0;
+
+  int lead_digits = 1;
+  for (uint64_t t = chunks[lead]; t >= base; t /= base) ++lead_digits;
+  const int size = lead_digits + lead * k;
+  if (last - first < size) return nullptr;
+  char* end = first + size;
+  for (int i = 0; i < lead; ++i) {
+    WriteDigits64(chunks[i], base, k, end);
+    end -= k;
+  }
+  WriteDigits64(chunks[lead], base, lead_digits, end);
+  return first + size;
+}
+
+}  // namespace int128_t_internal
+
+ABSL_INTERNAL_CONSTEXPR_CLZ char* ToChars(char* first, char* last,
+                                          uint128_t v, int base) {
+  assert(base >= 2 && base <= 36);
+  // Expanding the common bases separately lets the compiler turn each
+  // division by the base into a multiplication or a shift.
+  switch (base) {
+    case 8:
+      return int128_t_internal::ToCharsInBase(first, last, v, 8);
+    case 10:
+      return int128_t_internal::ToCharsInBase(first, last, v, 10);
+    case 16:
+      return int128_t_internal::ToCharsInBase(first, last, v, 16);
+    default:
+      return int128_t_internal::ToCharsInBase(first, last, v,
+                                              static_cast<uint64_t>(base));
+  }
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int BitWidth(uint128_t v) {
+  return v ? int128_t_internal::Fls128(v) + 1 : 0;
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log2Floor(uint128_t v) {
+  return BitWidth(v) - 1;
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log10Floor(uint128_t v) {
+  // 1233 / 4096 approximates log10(2) closely enough that `t` is exact for
+  // 2^bit_width, so floor(log10(v)) is either `t` or `t - 1`.
+  const int t = (BitWidth(v) * 1233) >> 12;
+  const uint128_t p = int128_t_internal::kPowersOf10[t];
+  return t - ((Uint128High64(v) == Uint128High64(p))
+                  ? (Uint128Low64(v) < Uint128Low64(p))
+                  : (Uint128High64(v) < Uint128High64(p)));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int DecimalDigits(uint128_t v) {
+  return v ? Log10Floor(v) + 1 : 1;
+}
+
+ABSL_INTERNAL_CONSTEXPR_POPCOUNT int Popcount(uint128_t v) {
+  return int128_t_internal::Popcount64(Uint128High64(v)) +
+         int128_t_internal::Popcount64(Uint128Low64(v));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int CountlZero(uint128_t v) {
+  return Uint128High64(v) != 0
+             ? int128_t_internal::CountLeadingZeros64(Uint128High64(v))
+             : 64 + int128_t_internal::CountLeadingZeros64(Uint128Low64(v));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CTZ int CountrZero(uint128_t v) {
+  return Uint128Low64(v) != 0
+             ? int128_t_internal::CountTrailingZeros64(Uint128Low64(v))
+             : 64 + int128_t_internal::CountTrailingZeros64(Uint128High64(v));
+}
+
+constexpr uint128_t Rotl(uint128_t v, int shift) {
+  // Rotating by 64 or more swaps the halves first; the remaining amount is
+  // below 64 and the halves trade the bits shifted out of each other.
+  return (shift & 64) != 0
+             ? Rotl(MakeUint128(Uint128Low64(v), Uint128High64(v)),
+                    shift & 63)
+         : (shift & 63) == 0
+             ? v
+             : MakeUint128((Uint128High64(v) << (shift & 63)) |
+                               (Uint128Low64(v) >> (64 - (shift & 63))),
+                           (Uint128Low64(v) << (shift & 63)) |
+                               (Uint128High64(v) >> (64 - (shift & 63))));
+}
+
+constexpr uint128_t Rotr(uint128_t v, int shift) {
+  // Reduced before negating, which would overflow for INT_MIN.
+  return Rotl(v, 128 - (shift & 127));
+}
+
+constexpr uint128_t Byteswap(uint128_t v) {
+  return MakeUint128(int128_t_internal::Byteswap64(Uint128Low64(v)),
+                     int128_t_internal::Byteswap64(Uint128High64(v)));
+}
+
+constexpr uint128_t BitReverse(uint128_t v) {
+  return MakeUint128(int128_t_internal::BitReverse64(Uint128Low64(v)),
+                     int128_t_internal::BitReverse64(Uint128High64(v)));
+}
+
+ABSL_INTERNAL_CONSTEXPR_POPCOUNT bool HasSingleBit(uint128_t v) {
+  return Popcount(v) == 1;
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t BitCeil(uint128_t v) {
+  return Uint128High64(v) == 0 && Uint128Low64(v) <= 1
+             ? uint128_t(1)
+             : int128_t_internal::PowerOf2(
+                   BitWidth(MakeUint128(Uint128High64(v) -
+                                            (Uint128Low64(v) == 0),
+                                        Uint128Low64(v) - 1)));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ uint128_t BitFloor(uint128_t v) {
+  return v ? int128_t_internal::PowerOf2(BitWidth(v) - 1) : uint128_t(0);
+}
+
+inline uint128_t FunnelShiftLeft(uint128_t hi, uint128_t lo, int shift) {
+  // Shifting `lo` in two steps keeps a zero shift from becoming a shift by
+  // 128, so no branch is needed.
+  const int s = shift & 127;
+  return (hi << s) | ((lo >> 1) >> (127 - s));
+}
+
+inline uint128_t FunnelShiftRight(uint128_t hi, uint128_t lo, int shift) {
+  const int s = shift & 127;
+  return (lo >> s) | ((hi << 1) << (127 - s));
+}
+
+inline uint128_t InverseMod2_128(uint128_t v) {
+  assert((Uint128Low64(v) & 1) != 0);
+  // Newton-Hensel iteration x' = x * (2 - v * x) doubles the number of
+  // correct low bits. (3 * v) ^ 2 is correct to 5 bits, four steps in 64-bit
+  // arithmetic reach 64 bits and a final 128-bit step completes the inverse.
+  const uint64_t lo = Uint128Low64(v);
+  uint64_t x = (3 * lo) ^ 2;
+  x *= 2 - lo * x;
+  x *= 2 - lo * x;
+  x *= 2 - lo * x;
+  x *= 2 - lo * x;
+  const uint128_t x128 = x;
+  return x128 * (2 - v * x128);
+}
+
+inline uint128_t DivExact(uint128_t a, uint128_t d) {
+  assert(d != 0);
+  const int shift = CountrZero(d);
+  return (a >> shift) * InverseMod2_128(d >> shift);
+}
+
+inline bool IsDivisible(uint128_t a, uint128_t d) {
+  assert(d != 0);
+  // An even divisor needs its trailing zeros matched in `a` first.
+  const int shift = CountrZero(d);
+  if (shift != 0 && CountrZero(a) < shift) return false;
+  a >>= shift;
+  d >>= shift;
+
+  // For odd `d`, q = a * d^-1 (mod 2^128) is the exact quotient when `d`
+  // divides `a`, so q * d == a fits in 128 bits. Otherwise q * d only agrees
+  // with `a` modulo 2^128 and must overflow. Checking the full product for
+  // overflow takes a handful of 64x64 multiplications and no remainder
+  // (Granlund and Montgomery, "Division by invariant integers using
+  // multiplication").
+  const uint128_t q = a * InverseMod2_128(d);
+  const uint64_t qh = Uint128High64(q), ql = Uint128Low64(q);
+  const uint64_t dh = Uint128High64(d), dl = Uint128Low64(d);
+  if (qh != 0 && dh != 0) return false;
+  const uint128_t cross = uint128_t(qh) * dl + uint128_t(ql) * dh;
+  const uint128_t low = uint128_t(ql) * dl;
+  return Uint128High64(cross) == 0 &&
+         Uint128Low64(cross) + Uint128High64(low) >= Uint128High64(low);
+}
+
 #if defined(ABSL_HAVE_INTRINSIC_INT128)
 #include "int128_have_intrinsic.inc"  // IWYU pragma: export
 #else  // ABSL_HAVE_INTRINSIC_INT128
 #include "int128_no_intrinsic.inc"  // IWYU pragma: export
 #endif  // ABSL_HAVE_INTRINSIC_INT128
 
+constexpr uint128_t int128_t_internal::UnsignedAbs(int128_t v) {
+  return Int128High64(v) < 0
+             ? MakeUint128(~static_cast<uint64_t>(Int128High64(v)) +
+                               (Int128Low64(v) == 0),
+                           0 - Int128Low64(v))
+             : uint128_t(v);
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int BitWidth(int128_t v) {
+  return BitWidth(int128_t_internal::UnsignedAbs(v));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log2Floor(int128_t v) {
+  return Log2Floor(int128_t_internal::UnsignedAbs(v));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int Log10Floor(int128_t v) {
+  return Log10Floor(int128_t_internal::UnsignedAbs(v));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ int DecimalDigits(int128_t v) {
+  return DecimalDigits(int128_t_internal::UnsignedAbs(v));
+}
+
+ABSL_INTERNAL_CONSTEXPR_CLZ char* ToChars(char* first, char* last, int128_t v,
+                                          int base) {
+  if (Int128High64(v) < 0) {
+    if (first == last) return nullptr;
+    *first++ = '-';
+  }
+  return ToChars(first, last, int128_t_internal::UnsignedAbs(v), base);
+}
+
+inline int128_t DivExact(int128_t a, int128_t d) {
+  // Exact division commutes with reduction modulo 2^128, so the two's
+  // complement bits can be divided as if unsigned once the shift of the
+  // even part keeps the sign of `a`.
+  assert(d != 0);
+  const int shift = CountrZero(uint128_t(d));
+  return int128_t(uint128_t(a >> shift) *
+                  InverseMod2_128(uint128_t(d >> shift)));
+}
+
+inline bool IsDivisible(int128_t a, int128_t d) {
+  return IsDivisible(int128_t_internal::UnsignedAbs(a),
+                     int128_t_internal::UnsignedAbs(d));
+}
+
+namespace int128_t_internal {
+
+// The value of the characters of an integer literal.
+struct LiteralValue {
+  uint128_t value;
+  bool valid;     // Every character is a digit of the base or a separator.
+  bool overflow;  // The value does not fit in 128 bits.
+};
+
+// Sets `*value` to `*value * base + digit`, or returns false if that does not
+// fit. The low half is multiplied in 32-bit pieces so that the carry into the
+// high half is exact, without the 128-bit operators, which are not constexpr
+// everywhere.
+constexpr bool MultiplyAddSmall(uint128_t* value, uint64_t base,
+                                uint64_t digit) {
+  const uint64_t lo = Uint128Low64(*value);
+  const uint64_t hi = Uint128High64(*value);
+  const uint64_t low = (lo & 0xffffffff) * base + digit;
+  const uint64_t mid = (lo >> 32) * base + (low >> 32);
+  const uint64_t carry = mid >> 32;
+  if (hi > ((std::numeric_limits<uint64_t>::max)() - carry) / base) {
+    return false;
+  }
+  *value = MakeUint128(hi * base + carry, (mid << 32) | (low & 0xffffffff));
+  return true;
+}
+
+// Parses the characters of a decimal, "0x" hexadecimal, "0b" binary or
+// leading-zero octal integer literal, which may contain ' separators.
+template <char... Chars>
+constexpr LiteralValue ParseLiteral() {
+  const char text[] = {Chars...};
+  const size_t size = sizeof...(Chars);
+  uint64_t base = 10;
+  size_t i = 0;
+  if (size >= 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+    base = 16;
+    i = 2;
+  } else if (size >= 2 && text[0] == '0' &&
+             (text[1] == 'b' || text[1] == 'B')) {
+    base = 2;
+    i = 2;
+  } else if (text[0] == '0') {
+    base = 8;
+  }
+
+  LiteralValue result = {uint128_t(0), i < size, false};
+  for (; i < size; ++i) {
+    const char c = text[i];
+    if (c == '\'') continue;
+    const uint64_t digit =
+        c >= '0' && c <= '9'   ? static_cast<uint64_t>(c - '0')
+        : c >= 'a' && c <= 'f' ? static_cast<uint64_t>(c - 'a' + 10)
+        : c >= 'A' && c <= 'F' ? static_cast<uint64_t>(c - 'A' + 10)
+                               : base;
+    if (digit >= base) {
+      result.valid = false;
+      break;
+    }
+    if (!MultiplyAddSmall(&result.value, base, digit)) {
+      result.overflow = true;
+      break;
+    }
+  }
+  return result;
+}
+
+}  // namespace int128_t_internal
+
+// Literals
+//
+// The `_u128` and `_i128` suffixes make integer literals of any size, in any
+// base the language has, into `uint128_t` and `int128_t` constants. They are
+// parsed entirely at compile time: a value that does not fit is a compile
+// error, and the result is a constant with no runtime cost. Like the builtin
+// types, the negative literals are the negation of a positive one, so
+// `Int128Min()` cannot be written as a literal.
+//
+// Example:
+//
+//   using namespace absl::int128_literals;
+//   constexpr absl::uint128_t kBig = 0x1234'5678'9abc'def0'1234'5678_u128;
+//   constexpr absl::int128_t kDebt = -18'446'744'073'709'551'616_i128;
+inline namespace int128_literals {
+
+template <char... Chars>
+constexpr uint128_t operator""_u128() {
+  constexpr int128_t_internal::LiteralValue kLiteral =
+      int128_t_internal::ParseLiteral<Chars...>();
+  static_assert(kLiteral.valid, "invalid digit in a uint128_t literal");
+  static_assert(!kLiteral.overflow, "uint128_t literal out of range");
+  return kLiteral.value;
+}
+
+template <char... Chars>
+constexpr int128_t operator""_i128() {
+  constexpr int128_t_internal::LiteralValue kLiteral =
+      int128_t_internal::ParseLiteral<Chars...>();
+  static_assert(kLiteral.valid, "invalid digit in an int128_t literal");
+  static_assert(!kLiteral.overflow && Uint128High64(kLiteral.value) >> 63 == 0,
+                "int128_t literal out of range");
+  return int128_t(kLiteral.value);
+}
+
+}  // namespace int128_literals
+
 }  // namespace absl
 
+// Specialized hashes for uint128_t and int128_t. `absl::HashN()` in
+// int128_kernels.h computes the same hashes for whole arrays.
+namespace std {
+template <>
+struct hash<absl::uint128_t> {
+  size_t operator()(absl::uint128_t v) const {
+    return static_cast<size_t>(absl::int128_t_internal::Hash128(
+        absl::Uint128High64(v), absl::Uint128Low64(v)));
+  }
+};
+
+template <>
+struct hash<absl::int128_t> {
+  size_t operator()(absl::int128_t v) const {
+    return static_cast<size_t>(absl::int128_t_internal::Hash128(
+        static_cast<uint64_t>(absl::Int128High64(v)), absl::Int128Low64(v)));
+  }
+};
+}  // namespace std
+
+#if defined(ABSL_INT128_HEADER_ONLY)
+#include "int128_impl.inc"  // IWYU pragma: export
+#endif  // ABSL_INT128_HEADER_ONLY
+
 #undef ABSL_INTERNAL_WCHAR_T
 
 #endif  // ABSL_INT128_H_
@@ -0,0 +1,299 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_column.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `Uint128Column` and `Int128Column`, containers that
+// store 128-bit integers as a structure of arrays: all high halves in one
+// array and all low halves in another. Vector kernels can then load 4 (AVX2)
+// or 8 (AVX-512) limbs of the same significance with a single aligned load
+// instead of shuffling them out of interleaved `uint128_t` values.
+//
+// Example:
+//
+//   std::vector<absl::uint128_t> values = ...;
+//   absl::Uint128Column column(values);
+//   column[0] += 1;
+//   const uint64_t* hi = column.hi();  // 64-byte aligned
+//   std::vector<absl::uint128_t> back = column.ToVector();
+
+#ifndef ABSL_INT128_COLUMN_H_
+#define ABSL_INT128_COLUMN_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "abslint128.h"
+
+namespace absl {
+
+namespace int128_t_internal {
+
+// Limb access shared by the unsigned and signed column types.
+template <typename T>
+struct ColumnTraits;
+
+template <>
+struct ColumnTraits<uint128_t> {
+  using High = uint64_t;
+  static uint64_t HighOf(uint128_t v) { return Uint128High64(v); }
+  static uint64_t LowOf(uint128_t v) { return Uint128Low64(v); }
+  static uint128_t Make(uint64_t high, uint64_t low) {
+    return MakeUint128(high, low);
+  }
+};
+
+template <>
+struct ColumnTraits<int128_t> {
+  using High = int64_t;
+  static int64_t HighOf(int128_t v) { return Int128High64(v); }
+  static uint64_t LowOf(int128_t v) { return Int128Low64(v); }
+  static int128_t Make(int64_t high, uint64_t low) {
+    return MakeInt128(high, low);
+  }
+};
+
+}  // namespace int128_t_internal
+
+// BasicInt128Column
+//
+// The common implementation of `Uint128Column` and `Int128Column`. `T` is
+// either `uint128_t` or `int128_t`.
+template <typename T>
+class BasicInt128Column {
+  using Traits = int128_t_internal::ColumnTraits<T>;
+
+ public:
+  using value_type = T;
+  using High = typename Traits::High;
+
+  // Both limb arrays start on a 64-byte boundary, and their capacity is a
+  // multiple of kAlignment / 8 elements, so a kernel may process whole
+  // vectors up to capacity() without a scalar tail.
+  static constexpr size_t kAlignment = 64;
+
+  // Reference
+  //
+  // Proxy returned by the non-const `operator[]`, since an element has no
+  // contiguous storage to refer to.
+  class Reference {
+   public:
+    operator T() const { return Traits::Make(*hi_, *lo_); }  // NOLINT
+
+    Reference& operator=(T v) {
+      *hi_ = Traits::HighOf(v);
+      *lo_ = Traits::LowOf(v);
+      return *this;
+    }
+    Reference& operator=(const Reference& other) {
+      return *this = static_cast<T>(other);
+    }
+    Reference& operator+=(T v) { return *this = static_cast<T>(*this) + v; }
+    Reference& operator-=(T v) { return *this = static_cast<T>(*this) - v; }
+
+   private:
+    friend class BasicInt128Column;
+    Reference(High* hi, uint64_t* lo) : hi_(hi), lo_(lo) {}
+
+    High* hi_;
+    uint64_t* lo_;
+  };
+
+  BasicInt128Column() = default;
+
+  // Constructs a column of `n` zeroes.
+  explicit BasicInt128Column(size_t n) { resize(n); }
+
+  // Constructs a column from `n` interleaved values, splitting them into
+  // limbs.
+  BasicInt128Column(const T* values, size_t n) { Assign(values, n); }
+
+  explicit BasicInt128Column(const std::vector<T>& values)
+      : BasicInt128Column(values.data(), values.size()) {}
+
+  BasicInt128Column(const BasicInt128Column& other) {
+    Reallocate(other.size_);
+    size_ = other.size_;
+    std::copy(other.hi_, other.hi_ + size_, hi_);
+    std::copy(other.lo_, other.lo_ + size_, lo_);
+  }
+
+  BasicInt128Column(BasicInt128Column&& other) noexcept { swap(other); }
+
+  BasicInt128Column& operator=(BasicInt128Column other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~BasicInt128Column() { Deallocate(); }
+
+  void swap(BasicInt128Column& other) noexcept {
+    std::swap(hi_, other.hi_);
+    std::swap(lo_, other.lo_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  // Limb arrays. `hi()[i]` and `lo()[i]` are the halves of element `i`.
+  High* hi() { return hi_; }
+  const High* hi() const { return hi_; }
+  uint64_t* lo() { return lo_; }
+  const uint64_t* lo() const { return lo_; }
+
+  Reference operator[](size_t i) {
+    assert(i < size_);
+    return Reference(hi_ + i, lo_ + i);
+  }
+  T operator[](size_t i) const {
+    assert(i < size_);
+    return Traits::Make(hi_[i], lo_[i]);
+  }
+
+  void reserve(size_t n) {
+    if (n > capacity_) Reallocate(n);
+  }
+
+  // Resizes the column. New elements are zero.
+  void resize(size_t n) {
+    reserve(n);
+    for (size_t i = size_; i < n; ++i) {
+      hi_[i] = 0;
+      lo_[i] = 0;
+    }
+    size_ = n;
+  }
+
+  void clear() { size_ = 0; }
+
+  void push_back(T v) {
+    if (size_ == capacity_) Reallocate(capacity_ == 0 ? 8 : 2 * capacity_);
+    hi_[size_] = Traits::HighOf(v);
+    lo_[size_] = Traits::LowOf(v);
+    ++size_;
+  }
+
+  // Replaces the contents with `n` interleaved values (scatter into limbs).
+  void Assign(const T* values, size_t n) {
+    reserve(n);
+    // A plain loop over both limbs, which compilers turn into vector unpack
+    // instructions.
+    for (size_t i = 0; i < n; ++i) {
+      hi_[i] = Traits::HighOf(values[i]);
+      lo_[i] = Traits::LowOf(values[i]);
+    }
+    size_ = n;
+  }
+
+  // Writes the elements to `out` in interleaved form (gather from limbs).
+  // `out` must have room for size() values.
+  void CopyTo(T* out) const {
+    for (size_t i = 0; i < size_; ++i) {
+      out[i] = Traits::Make(hi_[i], lo_[i]);
+    }
+  }
+
+  std::vector<T> ToVector() const {
+    std::vector<T> out(size_);
+    CopyTo(out.data());
+    return out;
+  }
+
+ private:
+  static size_t RoundUp(size_t n) {
+    const size_t lanes = kAlignment / sizeof(uint64_t);
+    return (n + lanes - 1) / lanes * lanes;
+  }
+
+  template <typename U>
+  static U* Allocate(size_t n) {
+    return static_cast<U*>(::operator new(n * sizeof(U),
+                                          std::align_val_t(kAlignment)));
+  }
+
+  template <typename U>
+  static void Free(U* p) {
+    ::operator delete(p, std::align_val_t(kAlignment));
+  }
+
+  struct Deleter {
+    template <typename U>
+    void operator()(U* p) const {
+      Free(p);
+    }
+  };
+
+  void Reallocate(size_t n) {
+    n = RoundUp(n);
+    // `hi` is owned until `lo` is allocated too, so that it is freed if that
+    // throws.
+    std::unique_ptr<High, Deleter> hi(Allocate<High>(n));
+    uint64_t* lo = Allocate<uint64_t>(n);
+    const size_t keep = size_ < n ? size_ : n;
+    std::copy(hi_, hi_ + keep, hi.get());
+    std::copy(lo_, lo_ + keep, lo);
+    Deallocate();
+    hi_ = hi.release();
+    lo_ = lo;
+    capacity_ = n;
+  }
+
+  void Deallocate() {
+    if (hi_ != nullptr) Free(hi_);
+    if (lo_ != nullptr) Free(lo_);
+    hi_ = nullptr;
+    lo_ = nullptr;
+  }
+
+  High* hi_ = nullptr;
+  uint64_t* lo_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+};
+
+template <typename T>
+constexpr size_t BasicInt128Column<T>::kAlignment;
+
+template <typename T>
+void swap(BasicInt128Column<T>& a, BasicInt128Column<T>& b) noexcept {
+  a.swap(b);
+}
+
+// Uint128Column
+//
+// A column of `uint128_t` values stored as separate high and low limb arrays.
+using Uint128Column = BasicInt128Column<uint128_t>;
+
+// Int128Column
+//
+// A column of `int128_t` values stored as separate high and low limb arrays.
+// The high limbs are signed.
+using Int128Column = BasicInt128Column<int128_t>;
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_COLUMN_H_
@@ -0,0 +1,284 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_column_file.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines a binary file format for arrays of `uint128_t` and
+// `int128_t`, a writer for it, and `MappedUint128Column` and
+// `MappedInt128Column`, which memory-map such a file. When the file's byte
+// order is the host's, the values are used in place with no parsing and no
+// copy; otherwise each access converts the values it reads.
+//
+// A file is a 64-byte header followed by the data:
+//
+//   bytes 0-7    magic "I128COL" and a zero byte
+//   bytes 8-11   format version, 1
+//   byte 12      byte order of the data: 0 little-endian, 1 big-endian
+//   byte 13      0 for `uint128_t`, 1 for `int128_t`
+//   byte 14      layout: 0 interleaved values, 1 split into all high halves
+//                followed by all low halves (as in `Uint128Column`)
+//   byte 15      flags: bit 0 set if the checksum is present
+//   bytes 16-23  number of values
+//   bytes 24-31  XXH64 (seed 0) of the data, or zero
+//   bytes 32-63  zero
+//
+// Header fields are little-endian. The data takes 16 bytes per value: whole
+// values in the file's byte order, or 64-bit halves in that order for the
+// split layout. It starts 64 bytes into the file, so a mapping aligns it for
+// any vector load.
+//
+// Example:
+//
+//   std::string error;
+//   if (!absl::WriteColumnFile("ids.col", ids.data(), ids.size(), {},
+//                              &error)) { ... }
+//
+//   absl::MappedUint128Column ids;
+//   if (!ids.Open("ids.col", &error)) { ... }
+//   const absl::uint128_t* p = ids.data();  // zero-copy, or nullptr
+//   absl::uint128_t first = ids[0];         // converts as needed
+
+#ifndef ABSL_INT128_COLUMN_FILE_H_
+#define ABSL_INT128_COLUMN_FILE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "abslint128.h"
+#include "int128_column.h"
+#include "int128_endian.h"
+
+namespace absl {
+
+// ColumnByteOrder
+//
+// The byte order of the data in a column file.
+enum class ColumnByteOrder : uint8_t {
+  kLittleEndian = 0,
+  kBigEndian = 1,
+#if defined(ABSL_IS_BIG_ENDIAN)
+  kHost = kBigEndian,
+#else
+  kHost = kLittleEndian,
+#endif
+};
+
+// ColumnLayout
+//
+// How a column file arranges the halves of its values.
+enum class ColumnLayout : uint8_t {
+  kInterleaved = 0,  // value i in bytes [16 * i, 16 * i + 16)
+  kSplit = 1,        // n high halves, then n low halves
+};
+
+// ColumnFileOptions
+//
+// How `WriteColumnFile()` encodes the data.
+struct ColumnFileOptions {
+  ColumnByteOrder byte_order = ColumnByteOrder::kHost;
+  ColumnLayout layout = ColumnLayout::kInterleaved;
+  bool checksum = true;
+};
+
+// WriteColumnFile()
+//
+// Writes `values[0, n)`, or a column, to a file at `path`, replacing it
+// atomically: the data goes to `path` with ".tmp" appended, which is renamed
+// to `path` once complete. On failure, returns false and describes the error
+// in `*error` if `error` is not null.
+bool WriteColumnFile(const std::string& path, const uint128_t* values,
+                     size_t n, const ColumnFileOptions& options = {},
+                     std::string* error = nullptr);
+bool WriteColumnFile(const std::string& path, const int128_t* values, size_t n,
+                     const ColumnFileOptions& options = {},
+                     std::string* error = nullptr);
+bool WriteColumnFile(const std::string& path, const Uint128Column& column,
+                     const ColumnFileOptions& options = {},
+                     std::string* error = nullptr);
+bool WriteColumnFile(const std::string& path, const Int128Column& column,
+                     const ColumnFileOptions& options = {},
+                     std::string* error = nullptr);
+
+namespace int128_t_internal {
+
+// Returns the XXH64 hash, with seed 0, of the `size` bytes at `data`.
+uint64_t Xxh64(const void* data, size_t size);
+
+// A read-only mapping of a column file whose header has been validated.
+class MappedColumnFile {
+ public:
+  MappedColumnFile() = default;
+  MappedColumnFile(const MappedColumnFile&) = delete;
+  MappedColumnFile& operator=(const MappedColumnFile&) = delete;
+  MappedColumnFile(MappedColumnFile&& other) noexcept { swap(other); }
+  MappedColumnFile& operator=(MappedColumnFile&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+  ~MappedColumnFile() { Close(); }
+
+  void swap(MappedColumnFile& other) noexcept {
+    std::swap(mapping_, other.mapping_);
+    std::swap(mapping_size_, other.mapping_size_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(byte_order_, other.byte_order_);
+    std::swap(layout_, other.layout_);
+    std::swap(has_checksum_, other.has_checksum_);
+    std::swap(checksum_, other.checksum_);
+  }
+
+  // Maps the file at `path` and checks that it is a column file of `int128_t`
+  // values if `is_signed`, and of `uint128_t` values otherwise.
+  bool Open(const std::string& path, bool is_signed, std::string* error);
+  void Close();
+
+  bool is_open() const { return mapping_ != nullptr; }
+  size_t size() const { return size_; }
+  ColumnByteOrder byte_order() const { return byte_order_; }
+  ColumnLayout layout() const { return layout_; }
+  const uint8_t* data() const { return data_; }
+  bool VerifyChecksum() const;
+
+ private:
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  ColumnByteOrder byte_order_ = ColumnByteOrder::kHost;
+  ColumnLayout layout_ = ColumnLayout::kInterleaved;
+  bool has_checksum_ = false;
+  uint64_t checksum_ = 0;
+};
+
+}  // namespace int128_t_internal
+
+// BasicMappedColumn
+//
+// The common implementation of `MappedUint128Column` and `MappedInt128Column`.
+// `T` is either `uint128_t` or `int128_t`, and must match the type the file
+// was written with.
+template <typename T>
+class BasicMappedColumn {
+  using Traits = int128_t_internal::ColumnTraits<T>;
+
+ public:
+  using value_type = T;
+  using High = typename Traits::High;
+
+  BasicMappedColumn() = default;
+
+  // Maps the file at `path`, unmapping any previous one. On failure, returns
+  // false and describes the error in `*error` if `error` is not null.
+  bool Open(const std::string& path, std::string* error = nullptr) {
+    return file_.Open(path, std::is_same<T, int128_t>::value, error);
+  }
+
+  void Close() { file_.Close(); }
+
+  bool is_open() const { return file_.is_open(); }
+  size_t size() const { return file_.size(); }
+  bool empty() const { return size() == 0; }
+  ColumnByteOrder byte_order() const { return file_.byte_order(); }
+  ColumnLayout layout() const { return file_.layout(); }
+
+  // Returns whether the data is in host byte order, so that `data()` or
+  // `hi()` and `lo()` can be used.
+  bool zero_copy() const { return byte_order() == ColumnByteOrder::kHost; }
+
+  // Returns the values in place for an interleaved file in host byte order,
+  // and null otherwise.
+  const T* data() const {
+    return zero_copy() && layout() == ColumnLayout::kInterleaved
+               ? reinterpret_cast<const T*>(file_.data())
+               : nullptr;
+  }
+
+  // Return the limb arrays in place for a split file in host byte order, and
+  // null otherwise.
+  const High* hi() const {
+    return zero_copy() && layout() == ColumnLayout::kSplit
+               ? reinterpret_cast<const High*>(file_.data())
+               : nullptr;
+  }
+  const uint64_t* lo() const {
+    return zero_copy() && layout() == ColumnLayout::kSplit
+               ? reinterpret_cast<const uint64_t*>(file_.data() + 8 * size())
+               : nullptr;
+  }
+
+  // Returns value `i`, converted to host byte order.
+  T operator[](size_t i) const {
+    assert(i < size());
+    const uint8_t* data = file_.data();
+    if (layout() == ColumnLayout::kInterleaved) {
+      return byte_order() == ColumnByteOrder::kLittleEndian
+                 ? LoadLE128<T>(data + 16 * i)
+                 : LoadBE128<T>(data + 16 * i);
+    }
+    return Traits::Make(static_cast<High>(Limb(data + 8 * i)),
+                        Limb(data + 8 * (size() + i)));
+  }
+
+  // Copies values `[begin, begin + n)` to `out`, converting them to host byte
+  // order. Interleaved files are converted with the bulk byte swap.
+  void Read(size_t begin, size_t n, T* out) const {
+    assert(begin <= size() && n <= size() - begin);
+    const uint8_t* data = file_.data();
+    if (layout() == ColumnLayout::kInterleaved) {
+      if (byte_order() == ColumnByteOrder::kLittleEndian) {
+        LoadLE128N(out, data + 16 * begin, n);
+      } else {
+        LoadBE128N(out, data + 16 * begin, n);
+      }
+      return;
+    }
+    for (size_t i = 0; i < n; ++i) out[i] = (*this)[begin + i];
+  }
+
+  // Returns whether the data matches the checksum in the header, reading all
+  // of it. Files written without a checksum always match.
+  bool VerifyChecksum() const { return file_.VerifyChecksum(); }
+
+ private:
+  uint64_t Limb(const uint8_t* p) const {
+    const uint64_t v = int128_t_internal::LoadHost64(p);
+    return byte_order() == ColumnByteOrder::kLittleEndian
+               ? int128_t_internal::LittleEndian64(v)
+               : int128_t_internal::BigEndian64(v);
+  }
+
+  int128_t_internal::MappedColumnFile file_;
+};
+
+// MappedUint128Column
+//
+// A column file of `uint128_t` values, mapped into memory.
+using MappedUint128Column = BasicMappedColumn<uint128_t>;
+
+// MappedInt128Column
+//
+// A column file of `int128_t` values, mapped into memory.
+using MappedInt128Column = BasicMappedColumn<int128_t>;
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_COLUMN_FILE_H_
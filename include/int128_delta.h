@@ -0,0 +1,245 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_delta.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines a block codec for arrays of `uint128_t` and
+// `int128_t` that are sorted or otherwise change slowly, such as IDs and
+// nanosecond timestamps. Each block of up to `kDeltaBlockSize` values stores
+// its first value, and the differences between consecutive values minus their
+// minimum ("frame of reference") packed at the bit width of the largest one.
+// A block of timestamps one second apart packs to no bits at all.
+//
+// Blocks are independent, so a reader can decode any one of them without the
+// others. The packed bits of a block are four interleaved streams of 64-bit
+// words, stream `j` holding the values `j`, `j + 4`, `j + 8`, ... so that one
+// 256-bit load and shift unpacks four values; decoding uses AVX2 where it is
+// available.
+//
+// The encoding is a sequence of blocks, each laid out as little-endian 64-bit
+// words:
+//
+//   word 0       bit width (bits 0-7) and number of values (bits 8-15)
+//   words 1-2    the first value
+//   words 3-4    the minimum difference
+//   words 5-     the packed differences, `4 * ceil(rows * width / 64)` words
+//                for `rows = ceil((values - 1) / 4)`
+//
+// Differences wrap modulo 2^128 and their minimum is taken as signed, so any
+// sequence round-trips; a decreasing one just packs less tightly.
+//
+// Example:
+//
+//   absl::Int128DeltaWriter writer;
+//   for (absl::int128_t t : timestamps) writer.Add(t);
+//   std::vector<uint8_t> encoded = writer.Finish();
+//
+//   absl::Int128DeltaReader reader(encoded.data(), encoded.size());
+//   absl::int128_t t = reader[12345];  // decodes one block
+//   std::vector<absl::int128_t> all(reader.size());
+//   reader.Decode(all.data());
+
+#ifndef ABSL_INT128_DELTA_H_
+#define ABSL_INT128_DELTA_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "abslint128.h"
+
+namespace absl {
+
+// kDeltaBlockSize
+//
+// The largest number of values in a block.
+constexpr size_t kDeltaBlockSize = 128;
+
+// MaxDeltaBlockBytes()
+//
+// Returns the size of the largest block of `n` values: 40 bytes of header and
+// 64 bytes (four 128-bit differences) per row.
+constexpr size_t MaxDeltaBlockBytes(size_t n) {
+  return 40 + 64 * ((n + 2) / 4);
+}
+
+// EncodeDeltaBlock()
+//
+// Encodes `values[0, n)`, for `n` in `[1, kDeltaBlockSize]`, as one block at
+// `out` and returns its size in bytes. `out` must have room for
+// `MaxDeltaBlockBytes(n)` bytes.
+size_t EncodeDeltaBlock(const uint128_t* values, size_t n, uint8_t* out);
+size_t EncodeDeltaBlock(const int128_t* values, size_t n, uint8_t* out);
+
+// DeltaBlockBytes()
+//
+// Returns the size in bytes of the block at `block`, and sets `*n` to its
+// number of values. Returns 0 if the `size` bytes at `block` do not start
+// with a whole, well-formed block.
+size_t DeltaBlockBytes(const uint8_t* block, size_t size, size_t* n);
+
+// DecodeDeltaBlock()
+//
+// Decodes the block at `block`, which `DeltaBlockBytes()` has validated, into
+// `out`, which must have room for its values.
+void DecodeDeltaBlock(const uint8_t* block, uint128_t* out);
+void DecodeDeltaBlock(const uint8_t* block, int128_t* out);
+
+// BasicDeltaWriter
+//
+// Encodes a stream of values into blocks of `kDeltaBlockSize` values. `T` is
+// `uint128_t` or `int128_t`.
+template <typename T>
+class BasicDeltaWriter {
+ public:
+  BasicDeltaWriter() = default;
+
+  void Add(T v) {
+    pending_[pending_size_++] = v;
+    ++size_;
+    if (pending_size_ == kDeltaBlockSize) {
+      AppendBlock(pending_, kDeltaBlockSize);
+      pending_size_ = 0;
+    }
+  }
+
+  // Adds `values[0, n)`. Whole blocks are encoded straight from `values`.
+  void AddN(const T* values, size_t n) {
+    size_t i = 0;
+    while (i < n && pending_size_ != 0) Add(values[i++]);
+    for (; n - i >= kDeltaBlockSize; i += kDeltaBlockSize) {
+      AppendBlock(values + i, kDeltaBlockSize);
+      size_ += kDeltaBlockSize;
+    }
+    while (i < n) Add(values[i++]);
+  }
+
+  // Encodes the values added since the last block as a shorter block, so
+  // that `data()` holds every value added so far.
+  void Flush() {
+    if (pending_size_ == 0) return;
+    AppendBlock(pending_, pending_size_);
+    pending_size_ = 0;
+  }
+
+  // Flushes and returns the encoding, leaving the writer empty.
+  std::vector<uint8_t> Finish() {
+    Flush();
+    std::vector<uint8_t> data;
+    data.swap(data_);
+    size_ = 0;
+    return data;
+  }
+
+  // The blocks encoded so far.
+  const std::vector<uint8_t>& data() const { return data_; }
+
+  // The number of values added, including those not yet in `data()`.
+  size_t size() const { return size_; }
+
+ private:
+  void AppendBlock(const T* values, size_t n) {
+    const size_t offset = data_.size();
+    data_.resize(offset + MaxDeltaBlockBytes(n));
+    data_.resize(offset + EncodeDeltaBlock(values, n, data_.data() + offset));
+  }
+
+  std::vector<uint8_t> data_;
+  T pending_[kDeltaBlockSize];
+  size_t pending_size_ = 0;
+  size_t size_ = 0;
+};
+
+// BasicDeltaReader
+//
+// Decodes a sequence of blocks, as a whole or one block at a time. The reader
+// indexes the blocks when constructed and refers to the encoded data, which
+// must outlive it.
+template <typename T>
+class BasicDeltaReader {
+ public:
+  BasicDeltaReader(const uint8_t* data, size_t size) : data_(data) {
+    offsets_.push_back(0);
+    starts_.push_back(0);
+    size_t offset = 0;
+    while (offset < size) {
+      size_t n;
+      const size_t bytes = DeltaBlockBytes(data + offset, size - offset, &n);
+      if (bytes == 0) {
+        ok_ = false;
+        break;
+      }
+      offset += bytes;
+      offsets_.push_back(offset);
+      starts_.push_back(starts_.back() + n);
+    }
+  }
+
+  // Returns false if the data is not a sequence of whole, well-formed
+  // blocks. The reader then covers the blocks before the first bad one.
+  bool ok() const { return ok_; }
+
+  size_t size() const { return starts_.back(); }
+  size_t num_blocks() const { return offsets_.size() - 1; }
+
+  // Returns the index of the first value of block `b`.
+  size_t block_start(size_t b) const { return starts_[b]; }
+
+  // Decodes block `b` into `out`, which must have room for
+  // `kDeltaBlockSize` values, and returns its number of values.
+  size_t DecodeBlock(size_t b, T* out) const {
+    assert(b < num_blocks());
+    DecodeDeltaBlock(data_ + offsets_[b], out);
+    return starts_[b + 1] - starts_[b];
+  }
+
+  // Decodes every value into `out[0, size())`.
+  void Decode(T* out) const {
+    for (size_t b = 0; b < num_blocks(); ++b) {
+      DecodeDeltaBlock(data_ + offsets_[b], out + starts_[b]);
+    }
+  }
+
+  // Returns value `i`, decoding the block that holds it.
+  T operator[](size_t i) const {
+    assert(i < size());
+    const size_t b =
+        std::upper_bound(starts_.begin(), starts_.end(), i) - starts_.begin() -
+        1;
+    T block[kDeltaBlockSize];
+    DecodeBlock(b, block);
+    return block[i - starts_[b]];
+  }
+
+ private:
+  const uint8_t* data_;
+  std::vector<size_t> offsets_;  // byte offset of each block, and the end
+  std::vector<size_t> starts_;   // index of each block's first value, and size
+  bool ok_ = true;
+};
+
+using Uint128DeltaWriter = BasicDeltaWriter<uint128_t>;
+using Int128DeltaWriter = BasicDeltaWriter<int128_t>;
+using Uint128DeltaReader = BasicDeltaReader<uint128_t>;
+using Int128DeltaReader = BasicDeltaReader<int128_t>;
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_DELTA_H_
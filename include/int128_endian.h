@@ -0,0 +1,165 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_endian.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines loads and stores of `uint128_t` and `int128_t`
+// values from and to byte buffers in an explicit byte order, at any
+// alignment: little-endian as in Arrow and Parquet buffers, or big-endian
+// (network byte order) as in wire protocols and IPv6 addresses.
+//
+// The single-value functions are a `memcpy` of each limb plus a byte swap when
+// the buffer's order differs from the host's (as set by `ABSL_IS_LITTLE_ENDIAN`
+// or `ABSL_IS_BIG_ENDIAN`). Compilers turn them into plain moves, or `movbe`
+// or `mov` and `bswap` on x86-64. The array functions convert whole buffers,
+// reversing 16 bytes per value with `vpshufb` where AVX2 is available.
+//
+// Example:
+//
+//   absl::uint128_t address = absl::LoadBE128(packet + 8);
+//   absl::int128_t amount = absl::LoadLE128<absl::int128_t>(column + 16 * i);
+//   absl::StoreBE128(out, address);
+
+#ifndef ABSL_INT128_ENDIAN_H_
+#define ABSL_INT128_ENDIAN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "abslint128.h"
+
+namespace absl {
+
+namespace int128_t_internal {
+
+inline uint64_t LoadHost64(const void* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void StoreHost64(void* p, uint64_t v) {
+  std::memcpy(p, &v, sizeof(v));
+}
+
+// Converts between host order and little- or big-endian order; each function
+// is its own inverse.
+#if defined(ABSL_IS_LITTLE_ENDIAN)
+constexpr uint64_t LittleEndian64(uint64_t v) { return v; }
+constexpr uint64_t BigEndian64(uint64_t v) { return Byteswap64(v); }
+#elif defined(ABSL_IS_BIG_ENDIAN)
+constexpr uint64_t LittleEndian64(uint64_t v) { return Byteswap64(v); }
+constexpr uint64_t BigEndian64(uint64_t v) { return v; }
+#endif
+
+template <typename T>
+struct IsInt128
+    : std::integral_constant<bool, std::is_same<T, uint128_t>::value ||
+                                       std::is_same<T, int128_t>::value> {};
+
+}  // namespace int128_t_internal
+
+// LoadLE128()
+// LoadBE128()
+//
+// Return the value stored in the 16 bytes at `p` in little-endian or
+// big-endian order. `T` is `uint128_t` (the default) or `int128_t`.
+template <typename T = uint128_t>
+T LoadLE128(const void* p) {
+  static_assert(int128_t_internal::IsInt128<T>::value,
+                "T must be uint128_t or int128_t");
+  const auto* bytes = static_cast<const unsigned char*>(p);
+  const uint64_t low = int128_t_internal::LittleEndian64(
+      int128_t_internal::LoadHost64(bytes));
+  const uint64_t high = int128_t_internal::LittleEndian64(
+      int128_t_internal::LoadHost64(bytes + 8));
+  return static_cast<T>(MakeUint128(high, low));
+}
+
+template <typename T = uint128_t>
+T LoadBE128(const void* p) {
+  static_assert(int128_t_internal::IsInt128<T>::value,
+                "T must be uint128_t or int128_t");
+  const auto* bytes = static_cast<const unsigned char*>(p);
+  const uint64_t high =
+      int128_t_internal::BigEndian64(int128_t_internal::LoadHost64(bytes));
+  const uint64_t low =
+      int128_t_internal::BigEndian64(int128_t_internal::LoadHost64(bytes + 8));
+  return static_cast<T>(MakeUint128(high, low));
+}
+
+// StoreLE128()
+// StoreBE128()
+//
+// Store `v` to the 16 bytes at `p` in little-endian or big-endian order.
+inline void StoreLE128(void* p, uint128_t v) {
+  auto* bytes = static_cast<unsigned char*>(p);
+  int128_t_internal::StoreHost64(
+      bytes, int128_t_internal::LittleEndian64(Uint128Low64(v)));
+  int128_t_internal::StoreHost64(
+      bytes + 8, int128_t_internal::LittleEndian64(Uint128High64(v)));
+}
+
+inline void StoreLE128(void* p, int128_t v) {
+  StoreLE128(p, static_cast<uint128_t>(v));
+}
+
+inline void StoreBE128(void* p, uint128_t v) {
+  auto* bytes = static_cast<unsigned char*>(p);
+  int128_t_internal::StoreHost64(
+      bytes, int128_t_internal::BigEndian64(Uint128High64(v)));
+  int128_t_internal::StoreHost64(
+      bytes + 8, int128_t_internal::BigEndian64(Uint128Low64(v)));
+}
+
+inline void StoreBE128(void* p, int128_t v) {
+  StoreBE128(p, static_cast<uint128_t>(v));
+}
+
+// LoadLE128N()
+// LoadBE128N()
+//
+// Set `dst[i]` to the value stored in bytes `[16 * i, 16 * i + 16)` of `src`
+// for `i` in `[0, n)`. `src` may be unaligned, and may be `dst` itself for an
+// in-place conversion, but must not otherwise overlap it.
+void LoadLE128N(uint128_t* dst, const void* src, size_t n);
+void LoadLE128N(int128_t* dst, const void* src, size_t n);
+void LoadBE128N(uint128_t* dst, const void* src, size_t n);
+void LoadBE128N(int128_t* dst, const void* src, size_t n);
+
+// StoreLE128N()
+// StoreBE128N()
+//
+// Store `src[0, n)` to consecutive 16-byte slots of `dst`, under the same
+// conditions as the loads.
+void StoreLE128N(void* dst, const uint128_t* src, size_t n);
+void StoreLE128N(void* dst, const int128_t* src, size_t n);
+void StoreBE128N(void* dst, const uint128_t* src, size_t n);
+void StoreBE128N(void* dst, const int128_t* src, size_t n);
+
+// ByteswapN()
+//
+// Reverses the 16 bytes of each of `src[0, n)` into `dst`, as `Byteswap()`
+// does for one `uint128_t`. `dst` may be `src`.
+void ByteswapN(uint128_t* dst, const uint128_t* src, size_t n);
+void ByteswapN(int128_t* dst, const int128_t* src, size_t n);
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_ENDIAN_H_
@@ -0,0 +1,553 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_flat_hash.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `FlatHashMap128<V>` and `FlatHashSet128`, open
+// addressing hash tables keyed by `uint128_t`, laid out like Swiss tables:
+//
+//   * One control byte per slot holds 7 bits of the key's hash, or marks the
+//     slot empty or deleted. Slots form groups of 16, and a lookup compares
+//     all 16 control bytes of a group against the hash with one SSE2 compare,
+//     so it touches a key only when its 7 hash bits match.
+//   * Keys live in their own 16-byte aligned array, apart from the values,
+//     and each candidate is checked with a single 16-byte vector compare.
+//   * Since emptiness is kept in the control bytes, no key value needs to be
+//     reserved as an empty-key sentinel: every `uint128_t` is a valid key.
+//
+// The tables are not stable: insertion may move keys and values, which
+// invalidates pointers to them.
+//
+// Example:
+//
+//   absl::FlatHashMap128<uint32_t> ids;
+//   ids[absl::MakeUint128(1, 2)] = 7;
+//   if (const uint32_t* id = ids.find(key)) ...
+//
+//   std::vector<const uint32_t*> found(keys.size());
+//   size_t hits = ids.FindN(keys.data(), keys.size(), found.data());
+
+#ifndef ABSL_INT128_FLAT_HASH_H_
+#define ABSL_INT128_FLAT_HASH_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ABSL_INT128_FLAT_HASH_SSE2 1
+#else
+#define ABSL_INT128_FLAT_HASH_SSE2 0
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include "abslint128.h"
+
+namespace absl {
+
+namespace int128_t_internal {
+
+// A full slot's control byte holds the low 7 bits of its key's hash. Empty and
+// deleted slots have the high bit set.
+constexpr int8_t kCtrlEmpty = -128;
+constexpr int8_t kCtrlDeleted = -2;
+constexpr size_t kGroupWidth = 16;
+
+// The control bytes of one group, with bit masks of the slots that match.
+class CtrlGroup {
+ public:
+  explicit CtrlGroup(const int8_t* ctrl) {
+#if ABSL_INT128_FLAT_HASH_SSE2
+    ctrl_ = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+    std::memcpy(ctrl_, ctrl, kGroupWidth);
+#endif
+  }
+
+  uint32_t Match(int8_t h2) const {
+#if ABSL_INT128_FLAT_HASH_SSE2
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+    }
+    return mask;
+#endif
+  }
+
+  uint32_t MatchEmpty() const { return Match(kCtrlEmpty); }
+
+  // Empty and deleted bytes are the ones with the high bit set.
+  uint32_t MatchEmptyOrDeleted() const {
+#if ABSL_INT128_FLAT_HASH_SSE2
+    return static_cast<uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
+
+ private:
+#if ABSL_INT128_FLAT_HASH_SSE2
+  __m128i ctrl_;
+#else
+  int8_t ctrl_[kGroupWidth];
+#endif
+};
+
+// Compares a stored key with `key` as one 16-byte vector (pcmpeqq with
+// SSE4.1, pcmpeqb otherwise).
+inline bool KeyEquals(const uint128_t* slot, const uint128_t& key) {
+#if ABSL_INT128_FLAT_HASH_SSE2
+  const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(slot));
+  const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&key));
+#if defined(__SSE4_1__)
+  return _mm_movemask_epi8(_mm_cmpeq_epi64(a, b)) == 0xffff;
+#else
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff;
+#endif
+#else
+  return *slot == key;
+#endif
+}
+
+// The value type of a set.
+struct NoValue {};
+
+// FlatHashTable
+//
+// The implementation shared by `FlatHashMap128` and `FlatHashSet128`. The
+// number of slots is zero or a power of two of at least one group, and at
+// most 7/8 of the slots are used. Probing visits whole groups in triangular
+// order, which reaches every group of a power-of-two table.
+template <typename V>
+class FlatHashTable {
+ public:
+  static constexpr size_t npos = ~size_t{0};
+
+  FlatHashTable() = default;
+
+  FlatHashTable(const FlatHashTable& other) {
+    reserve(other.size_);
+    other.ForEachSlot([this, &other](size_t slot) {
+      const uint128_t key = other.keys_[slot];
+      InsertNew(key, Hash(key), other.value(slot));
+    });
+  }
+
+  FlatHashTable(FlatHashTable&& other) noexcept { swap(other); }
+
+  FlatHashTable& operator=(FlatHashTable other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~FlatHashTable() { Deallocate(); }
+
+  void swap(FlatHashTable& other) noexcept {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(keys_, other.keys_);
+    std::swap(values_, other.values_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growth_left_, other.growth_left_);
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+
+  void clear() {
+    ForEachSlot([this](size_t slot) { value(slot).~V(); });
+    if (capacity_ != 0) std::memset(ctrl_, kCtrlEmpty, capacity_);
+    size_ = 0;
+    growth_left_ = MaxLoad(capacity_);
+  }
+
+  void reserve(size_t n) {
+    if (n <= size_ + growth_left_) return;
+    size_t capacity = kGroupWidth;
+    while (MaxLoad(capacity) < n) capacity *= 2;
+    Resize(capacity > capacity_ ? capacity : capacity_);
+  }
+
+  static uint64_t Hash(const uint128_t& key) {
+    return Hash128(Uint128High64(key), Uint128Low64(key));
+  }
+
+  // Fetches the control bytes of the first group a lookup of `hash` probes
+  // into the cache.
+  ABSL_ATTRIBUTE_ALWAYS_INLINE void PrefetchCtrl(uint64_t hash) const {
+    if (capacity_ != 0) Prefetch(ctrl_ + FirstGroup(hash) * kGroupWidth);
+  }
+
+  // Fetches the first key in that group whose control byte matches `hash`,
+  // which is usually the key itself.
+  ABSL_ATTRIBUTE_ALWAYS_INLINE void PrefetchKey(uint64_t hash) const {
+    if (capacity_ == 0) return;
+    const size_t base = FirstGroup(hash) * kGroupWidth;
+    const uint32_t m = CtrlGroup(ctrl_ + base).Match(H2(hash));
+    if (m != 0) Prefetch(keys_ + base + CountTrailingZeros64(m));
+  }
+
+  // Returns the slot holding `key`, or npos.
+  size_t Find(const uint128_t& key, uint64_t hash) const {
+    if (capacity_ == 0) return npos;
+    const int8_t h2 = H2(hash);
+    size_t group = FirstGroup(hash);
+    for (size_t step = 1;; ++step) {
+      const size_t base = group * kGroupWidth;
+      const CtrlGroup g(ctrl_ + base);
+      for (uint32_t m = g.Match(h2); m != 0; m &= m - 1) {
+        const size_t slot = base + CountTrailingZeros64(m);
+        if (KeyEquals(keys_ + slot, key)) return slot;
+      }
+      if (g.MatchEmpty() != 0) return npos;
+      group = (group + step) & (GroupCount() - 1);
+    }
+  }
+
+  // Returns the slot of `key` and whether it was inserted, constructing its
+  // value from `args` if so.
+  template <typename... Args>
+  std::pair<size_t, bool> Emplace(const uint128_t& key, Args&&... args) {
+    const uint64_t hash = Hash(key);
+    const size_t found = Find(key, hash);
+    if (found != npos) return {found, false};
+    return {InsertNew(key, hash, std::forward<Args>(args)...), true};
+  }
+
+  bool Erase(const uint128_t& key) {
+    const size_t slot = Find(key, Hash(key));
+    if (slot == npos) return false;
+    value(slot).~V();
+    --size_;
+    // No lookup has probed past a group that still has an empty slot, so the
+    // slot can become empty again. Otherwise it must stay a tombstone.
+    const CtrlGroup g(ctrl_ + slot / kGroupWidth * kGroupWidth);
+    if (g.MatchEmpty() != 0) {
+      ctrl_[slot] = kCtrlEmpty;
+      ++growth_left_;
+    } else {
+      ctrl_[slot] = kCtrlDeleted;
+    }
+    return true;
+  }
+
+  // Calls `on_slot(i, slot)` with the slot of each of `keys[0, n)`, or npos.
+  // Keys go through in batches, in three passes: hash every key and prefetch
+  // its control bytes, then prefetch the key slot they point to, then look the
+  // keys up. The cache misses of a batch overlap instead of forming a chain of
+  // two dependent misses per key.
+  template <typename F>
+  void FindN(const uint128_t* keys, size_t n, F on_slot) const {
+    constexpr size_t kBatch = 32;
+    uint64_t hashes[kBatch];
+    for (size_t begin = 0; begin < n; begin += kBatch) {
+      const size_t count = n - begin < kBatch ? n - begin : kBatch;
+      for (size_t j = 0; j < count; ++j) {
+        hashes[j] = Hash(keys[begin + j]);
+        PrefetchCtrl(hashes[j]);
+      }
+      for (size_t j = 0; j < count; ++j) PrefetchKey(hashes[j]);
+      for (size_t j = 0; j < count; ++j) {
+        on_slot(begin + j, Find(keys[begin + j], hashes[j]));
+      }
+    }
+  }
+
+  const uint128_t& key(size_t slot) const { return keys_[slot]; }
+  V& value(size_t slot) { return *ValueAt(values_, slot); }
+  const V& value(size_t slot) const { return *ValueAt(values_, slot); }
+
+  // Calls `f(slot)` for each full slot.
+  template <typename F>
+  void ForEachSlot(F f) const {
+    for (size_t slot = 0; slot < capacity_; ++slot) {
+      if (ctrl_[slot] >= 0) f(slot);
+    }
+  }
+
+ private:
+  static constexpr size_t kAlignment = 16;
+
+  static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+  // A set stores one empty value that stands in for all of its slots.
+  static V* ValueAt(V* values, size_t slot) {
+    return std::is_empty<V>::value ? values : values + slot;
+  }
+
+  static int8_t H2(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+  size_t GroupCount() const { return capacity_ / kGroupWidth; }
+  size_t FirstGroup(uint64_t hash) const {
+    return static_cast<size_t>(hash >> 7) & (GroupCount() - 1);
+  }
+
+  // Returns the first empty or deleted slot on the probe sequence of `hash`.
+  size_t FindFreeSlot(uint64_t hash) const {
+    size_t group = FirstGroup(hash);
+    for (size_t step = 1;; ++step) {
+      const size_t base = group * kGroupWidth;
+      const uint32_t free = CtrlGroup(ctrl_ + base).MatchEmptyOrDeleted();
+      if (free != 0) return base + CountTrailingZeros64(free);
+      group = (group + step) & (GroupCount() - 1);
+    }
+  }
+
+  // Inserts a key known to be absent.
+  template <typename... Args>
+  size_t InsertNew(const uint128_t& key, uint64_t hash, Args&&... args) {
+    size_t slot = capacity_ == 0 ? npos : FindFreeSlot(hash);
+    if (slot == npos || (growth_left_ == 0 && ctrl_[slot] == kCtrlEmpty)) {
+      // Grow, unless tombstones take up much of the table, in which case
+      // rehashing at the same size clears them.
+      Resize(capacity_ == 0 ? kGroupWidth
+                            : size_ < MaxLoad(capacity_) / 2 ? capacity_
+                                                             : capacity_ * 2);
+      slot = FindFreeSlot(hash);
+    }
+    if (ctrl_[slot] == kCtrlEmpty) --growth_left_;
+    ctrl_[slot] = H2(hash);
+    keys_[slot] = key;
+    new (ValueAt(values_, slot)) V(std::forward<Args>(args)...);
+    ++size_;
+    return slot;
+  }
+
+  void Resize(size_t capacity) {
+    int8_t* old_ctrl = ctrl_;
+    uint128_t* old_keys = keys_;
+    V* old_values = values_;
+    const size_t old_capacity = capacity_;
+
+    ctrl_ = Allocate<int8_t>(capacity);
+    keys_ = Allocate<uint128_t>(capacity);
+    values_ = Allocate<V>(capacity);
+    std::memset(ctrl_, kCtrlEmpty, capacity);
+    capacity_ = capacity;
+    growth_left_ = MaxLoad(capacity) - size_;  // tombstones are dropped
+
+    for (size_t slot = 0; slot < old_capacity; ++slot) {
+      if (old_ctrl[slot] < 0) continue;
+      const uint64_t hash = Hash(old_keys[slot]);
+      const size_t to = FindFreeSlot(hash);
+      ctrl_[to] = H2(hash);
+      keys_[to] = old_keys[slot];
+      V* value = ValueAt(old_values, slot);
+      new (ValueAt(values_, to)) V(std::move(*value));
+      value->~V();
+    }
+    Free(old_ctrl);
+    Free(old_keys);
+    Free(old_values);
+  }
+
+  template <typename U>
+  static U* Allocate(size_t n) {
+    if (std::is_empty<U>::value) n = 1;
+    return static_cast<U*>(
+        ::operator new(n * sizeof(U), std::align_val_t(kAlignment)));
+  }
+
+  template <typename U>
+  static void Free(U* p) {
+    if (p != nullptr) ::operator delete(p, std::align_val_t(kAlignment));
+  }
+
+  void Deallocate() {
+    ForEachSlot([this](size_t slot) { value(slot).~V(); });
+    Free(ctrl_);
+    Free(keys_);
+    Free(values_);
+    ctrl_ = nullptr;
+    keys_ = nullptr;
+    values_ = nullptr;
+  }
+
+  int8_t* ctrl_ = nullptr;
+  uint128_t* keys_ = nullptr;
+  V* values_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t growth_left_ = 0;  // empty slots that may still be filled
+};
+
+template <typename V>
+constexpr size_t FlatHashTable<V>::npos;
+
+}  // namespace int128_t_internal
+
+// FlatHashMap128
+//
+// A hash map from `uint128_t` keys to values of type `V`.
+template <typename V>
+class FlatHashMap128 {
+  using Table = int128_t_internal::FlatHashTable<V>;
+
+ public:
+  using key_type = uint128_t;
+  using mapped_type = V;
+
+  FlatHashMap128() = default;
+  explicit FlatHashMap128(size_t n) { reserve(n); }
+
+  size_t size() const { return table_.size(); }
+  bool empty() const { return table_.size() == 0; }
+  size_t capacity() const { return table_.capacity(); }
+  void clear() { table_.clear(); }
+
+  // Makes room for `n` elements without rehashing.
+  void reserve(size_t n) { table_.reserve(n); }
+
+  // Inserts `value` under `key` unless the key is present. Returns the value
+  // stored under the key and whether it was inserted.
+  std::pair<V*, bool> insert(const uint128_t& key, const V& value) {
+    const auto result = table_.Emplace(key, value);
+    return {&table_.value(result.first), result.second};
+  }
+  std::pair<V*, bool> insert(const uint128_t& key, V&& value) {
+    const auto result = table_.Emplace(key, std::move(value));
+    return {&table_.value(result.first), result.second};
+  }
+
+  // Returns the value under `key`, inserting a value-initialized one if the
+  // key is absent.
+  V& operator[](const uint128_t& key) {
+    return table_.value(table_.Emplace(key).first);
+  }
+
+  // Returns the value under `key`, or nullptr.
+  V* find(const uint128_t& key) {
+    const size_t slot = table_.Find(key, Table::Hash(key));
+    return slot == Table::npos ? nullptr : &table_.value(slot);
+  }
+  const V* find(const uint128_t& key) const {
+    const size_t slot = table_.Find(key, Table::Hash(key));
+    return slot == Table::npos ? nullptr : &table_.value(slot);
+  }
+
+  bool contains(const uint128_t& key) const { return find(key) != nullptr; }
+
+  // Removes `key`. Returns whether it was present.
+  bool erase(const uint128_t& key) { return table_.Erase(key); }
+
+  // FindN()
+  //
+  // Sets `values[i]` to `find(keys[i])` for `i` in `[0, n)` and returns the
+  // number of keys found. Lookups are batched and prefetched, which hides most
+  // cache misses on tables larger than the cache.
+  size_t FindN(const uint128_t* keys, size_t n, const V** values) const {
+    size_t found = 0;
+    table_.FindN(keys, n, [&](size_t i, size_t slot) {
+      values[i] = slot == Table::npos ? nullptr : &table_.value(slot);
+      found += slot != Table::npos;
+    });
+    return found;
+  }
+
+  // Calls `f(key, value)` for each element, in no particular order.
+  template <typename F>
+  void ForEach(F f) {
+    table_.ForEachSlot(
+        [&](size_t slot) { f(table_.key(slot), table_.value(slot)); });
+  }
+  template <typename F>
+  void ForEach(F f) const {
+    table_.ForEachSlot(
+        [&](size_t slot) { f(table_.key(slot), table_.value(slot)); });
+  }
+
+  void swap(FlatHashMap128& other) noexcept { table_.swap(other.table_); }
+
+ private:
+  Table table_;
+};
+
+// FlatHashSet128
+//
+// A hash set of `uint128_t` keys.
+class FlatHashSet128 {
+  using Table = int128_t_internal::FlatHashTable<int128_t_internal::NoValue>;
+
+ public:
+  using key_type = uint128_t;
+
+  FlatHashSet128() = default;
+  explicit FlatHashSet128(size_t n) { reserve(n); }
+
+  size_t size() const { return table_.size(); }
+  bool empty() const { return table_.size() == 0; }
+  size_t capacity() const { return table_.capacity(); }
+  void clear() { table_.clear(); }
+  void reserve(size_t n) { table_.reserve(n); }
+
+  // Inserts `key`. Returns whether it was absent.
+  bool insert(const uint128_t& key) { return table_.Emplace(key).second; }
+
+  bool contains(const uint128_t& key) const {
+    return table_.Find(key, Table::Hash(key)) != Table::npos;
+  }
+
+  // Removes `key`. Returns whether it was present.
+  bool erase(const uint128_t& key) { return table_.Erase(key); }
+
+  // FindN()
+  //
+  // Sets `found[i]` to `contains(keys[i])` for `i` in `[0, n)` and returns the
+  // number of keys found, with batched, prefetched lookups.
+  size_t FindN(const uint128_t* keys, size_t n, bool* found) const {
+    size_t hits = 0;
+    table_.FindN(keys, n, [&](size_t i, size_t slot) {
+      found[i] = slot != Table::npos;
+      hits += found[i];
+    });
+    return hits;
+  }
+
+  // Calls `f(key)` for each key, in no particular order.
+  template <typename F>
+  void ForEach(F f) const {
+    table_.ForEachSlot([&](size_t slot) { f(table_.key(slot)); });
+  }
+
+  void swap(FlatHashSet128& other) noexcept { table_.swap(other.table_); }
+
+ private:
+  Table table_;
+};
+
+template <typename V>
+void swap(FlatHashMap128<V>& a, FlatHashMap128<V>& b) noexcept {
+  a.swap(b);
+}
+
+inline void swap(FlatHashSet128& a, FlatHashSet128& b) noexcept { a.swap(b); }
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_FLAT_HASH_H_
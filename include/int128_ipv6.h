@@ -0,0 +1,219 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_ipv6.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `Ipv6Address`, an IPv6 address held as the
+// `uint128_t` whose big-endian bytes are the address in network order, with
+// conversions to and from text and helpers for prefixes.
+//
+// Formatting follows RFC 5952: lowercase hex, no leading zeros, the longest
+// run of two or more zero groups (the first, on a tie) replaced by "::", and
+// IPv4-mapped addresses written as "::ffff:192.0.2.1". Parsing accepts any
+// RFC 4291 text form, including "::", a trailing dotted IPv4 address and a
+// zone ID after "%", in the same cases as `inet_pton()`. Neither allocates,
+// and the batch forms convert delimited text such as one address per line
+// without copying each address out first.
+//
+// Example:
+//
+//   absl::Ipv6Address address;
+//   if (!absl::Ipv6Address::Parse(text, size, &address)) { ... }
+//   if (address.InNetwork(site_prefix, 48)) { ... }
+//   char buffer[absl::kIpv6AddressMaxLength];
+//   size_t length = address.Format(buffer);
+
+#ifndef ABSL_INT128_IPV6_H_
+#define ABSL_INT128_IPV6_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "abslint128.h"
+#include "int128_lpm.h"
+
+namespace absl {
+
+// The length of the longest text `Ipv6Address::Format()` writes, as in
+// "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff".
+constexpr size_t kIpv6AddressMaxLength = 39;
+
+namespace int128_t_internal {
+
+bool ParseIpv6(const char* p, const char* end, uint128_t* value,
+               const char** zone);
+size_t FormatIpv6(uint128_t value, char* out);
+
+}  // namespace int128_t_internal
+
+// Ipv6Address
+//
+// An IPv6 address. The default value is the unspecified address, "::".
+class Ipv6Address {
+ public:
+  constexpr Ipv6Address() : value_(0) {}
+  constexpr explicit Ipv6Address(uint128_t value) : value_(value) {}
+
+  // Returns the IPv4-mapped address of `ipv4`, "::ffff:a.b.c.d".
+  static constexpr Ipv6Address FromIpv4(uint32_t ipv4) {
+    return Ipv6Address(MakeUint128(0, uint64_t{0xffff} << 32 | ipv4));
+  }
+
+  // Returns the address as an integer: the first byte on the wire is the top
+  // byte.
+  constexpr uint128_t value() const { return value_; }
+
+  // Returns whether this is an IPv4-mapped address, in ::ffff:0:0/96.
+  constexpr bool IsIpv4Mapped() const {
+    return Uint128High64(value_) == 0 &&
+           Uint128Low64(value_) >> 32 == 0xffff;
+  }
+
+  // Returns the low 32 bits, the IPv4 address of an IPv4-mapped address.
+  constexpr uint32_t ToIpv4() const {
+    return static_cast<uint32_t>(Uint128Low64(value_));
+  }
+
+  // Network()
+  //
+  // Returns the address with all but its top `length` bits cleared, the
+  // network of the /`length` prefix it belongs to. `length` must be in
+  // `[0, 128]`.
+  Ipv6Address Network(int length) const {
+    return Ipv6Address(value_ & PrefixMask(length));
+  }
+
+  // Host()
+  //
+  // Returns the address with its top `length` bits cleared, its position
+  // within the /`length` prefix.
+  Ipv6Address Host(int length) const {
+    return Ipv6Address(value_ & ~PrefixMask(length));
+  }
+
+  // InNetwork()
+  //
+  // Returns whether the address lies in the prefix of `length` bits of
+  // `network`. Bits of `network` past `length` are ignored.
+  bool InNetwork(Ipv6Address network, int length) const {
+    return ((value_ ^ network.value_) & PrefixMask(length)) == 0;
+  }
+
+  // Parse()
+  //
+  // Parses an address from the `size` characters at `text`. Returns false,
+  // leaving `*address` unchanged, if they are not one. If `zone` is not null,
+  // sets `*zone` to the offset of the zone ID after a "%", or to `size` if
+  // there is none.
+  static bool Parse(const char* text, size_t size, Ipv6Address* address,
+                    size_t* zone = nullptr) {
+    uint128_t value;
+    const char* zone_start;
+    if (!int128_t_internal::ParseIpv6(text, text + size, &value,
+                                      &zone_start)) {
+      return false;
+    }
+    *address = Ipv6Address(value);
+    if (zone != nullptr) *zone = static_cast<size_t>(zone_start - text);
+    return true;
+  }
+  static bool Parse(const std::string& text, Ipv6Address* address,
+                    size_t* zone = nullptr) {
+    return Parse(text.data(), text.size(), address, zone);
+  }
+
+  // Format()
+  //
+  // Writes the RFC 5952 text of the address, at most `kIpv6AddressMaxLength`
+  // characters, to `out` and returns its length. No terminating null is
+  // written.
+  size_t Format(char* out) const {
+    return int128_t_internal::FormatIpv6(value_, out);
+  }
+
+  std::string ToString() const {
+    char buffer[kIpv6AddressMaxLength];
+    return std::string(buffer, Format(buffer));
+  }
+
+  friend bool operator==(Ipv6Address a, Ipv6Address b) {
+    return a.value_ == b.value_;
+  }
+  friend bool operator!=(Ipv6Address a, Ipv6Address b) {
+    return a.value_ != b.value_;
+  }
+  friend bool operator<(Ipv6Address a, Ipv6Address b) {
+    return a.value_ < b.value_;
+  }
+  friend bool operator>(Ipv6Address a, Ipv6Address b) {
+    return a.value_ > b.value_;
+  }
+  friend bool operator<=(Ipv6Address a, Ipv6Address b) {
+    return a.value_ <= b.value_;
+  }
+  friend bool operator>=(Ipv6Address a, Ipv6Address b) {
+    return a.value_ >= b.value_;
+  }
+
+  // Support for absl::Hash.
+  template <typename H>
+  friend H AbslHashValue(H h, Ipv6Address v) {
+    return H::combine(std::move(h), v.value_);
+  }
+
+ private:
+  uint128_t value_;
+};
+
+// ParseIpv6Addresses()
+//
+// Parses `n` addresses from `[p, end)` into `values[0, n)`, each followed by
+// `separator` except that the last may instead end the input. Zone IDs are
+// accepted and dropped. Returns a pointer past the last address and its
+// separator, or `nullptr` if an address is invalid or the input holds fewer
+// than `n`, in which case the contents of `values` are unspecified.
+const char* ParseIpv6Addresses(const char* p, const char* end, char separator,
+                               uint128_t* values, size_t n);
+const char* ParseIpv6Addresses(const char* p, const char* end, char separator,
+                               Ipv6Address* values, size_t n);
+
+// FormatIpv6Addresses()
+//
+// Writes the text of `values[0, n)` to `out`, each followed by `separator`,
+// and returns a pointer past the last separator. `out` must have room for
+// `n * (kIpv6AddressMaxLength + 1)` characters.
+char* FormatIpv6Addresses(const uint128_t* values, size_t n, char separator,
+                          char* out);
+char* FormatIpv6Addresses(const Ipv6Address* values, size_t n, char separator,
+                          char* out);
+
+}  // namespace absl
+
+// The hash of an `Ipv6Address` is that of its `uint128_t` value.
+namespace std {
+template <>
+struct hash<absl::Ipv6Address> {
+  size_t operator()(absl::Ipv6Address v) const {
+    return hash<absl::uint128_t>()(v.value());
+  }
+};
+}  // namespace std
+
+#endif  // ABSL_INT128_IPV6_H_
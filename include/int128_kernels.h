@@ -0,0 +1,322 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_kernels.h
+// -----------------------------------------------------------------------------
+//
+// This header file declares bulk kernels over arrays of `uint128_t` and
+// `int128_t`. Each kernel has a portable implementation with the same results
+// as the scalar operators, and on x86-64 AVX2 and AVX-512 implementations that
+// are selected at runtime according to the features of the CPU. The multiply
+// and divide kernels likewise have BMI2 and ADX implementations, so that a
+// library built for baseline x86-64 still uses mulx, adcx and adox where the
+// CPU has them. `ActiveKernelVariants()` reports the choice.
+//
+// Arrays are passed as a pointer and an element count. Output arrays may alias
+// input arrays exactly (in-place operation) but must not otherwise overlap.
+
+#ifndef ABSL_INT128_KERNELS_H_
+#define ABSL_INT128_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "abslint128.h"
+#include "int128_column.h"
+
+namespace absl {
+
+// AddN()
+//
+// Sets `dst[i] = a[i] + b[i]` for `i` in `[0, n)`, wrapping modulo 2^128 like
+// `operator+`.
+void AddN(uint128_t* dst, const uint128_t* a, const uint128_t* b, size_t n);
+void AddN(int128_t* dst, const int128_t* a, const int128_t* b, size_t n);
+
+// SubN()
+//
+// Sets `dst[i] = a[i] - b[i]` for `i` in `[0, n)`.
+void SubN(uint128_t* dst, const uint128_t* a, const uint128_t* b, size_t n);
+void SubN(int128_t* dst, const int128_t* a, const int128_t* b, size_t n);
+
+// NegN()
+//
+// Sets `dst[i] = -a[i]` for `i` in `[0, n)`.
+void NegN(uint128_t* dst, const uint128_t* a, size_t n);
+void NegN(int128_t* dst, const int128_t* a, size_t n);
+
+// AddScalarN()
+// SubScalarN()
+//
+// Broadcast variants: set `dst[i] = a[i] + b` or `dst[i] = a[i] - b`.
+void AddScalarN(uint128_t* dst, const uint128_t* a, uint128_t b, size_t n);
+void AddScalarN(int128_t* dst, const int128_t* a, int128_t b, size_t n);
+void SubScalarN(uint128_t* dst, const uint128_t* a, uint128_t b, size_t n);
+void SubScalarN(int128_t* dst, const int128_t* a, int128_t b, size_t n);
+
+// HashN()
+//
+// Sets `out[i]` to `std::hash` of `values[i]` (as a 64-bit value, even where
+// `size_t` is narrower) for `i` in `[0, n)`. There is no vector 64x64->128
+// multiply, so this is a scalar loop, but its iterations are independent and
+// the multiplies of consecutive values overlap.
+void HashN(uint64_t* out, const uint128_t* values, size_t n);
+void HashN(uint64_t* out, const int128_t* values, size_t n);
+
+// MulN()
+//
+// Sets `dst[i] = a[i] * b[i]` for `i` in `[0, n)`, wrapping modulo 2^128 like
+// `operator*`.
+void MulN(uint128_t* dst, const uint128_t* a, const uint128_t* b, size_t n);
+void MulN(int128_t* dst, const int128_t* a, const int128_t* b, size_t n);
+
+// MulScalarN()
+//
+// Broadcast variant: sets `dst[i] = a[i] * b`.
+void MulScalarN(uint128_t* dst, const uint128_t* a, uint128_t b, size_t n);
+void MulScalarN(int128_t* dst, const int128_t* a, int128_t b, size_t n);
+
+// MulWideN()
+//
+// Sets `high[i]` and `low[i]` to the high and low halves of the full 256-bit
+// product `a[i] * b[i]` for `i` in `[0, n)`. `high` and `low` may each alias
+// `a` or `b` exactly.
+void MulWideN(uint128_t* high, uint128_t* low, const uint128_t* a,
+              const uint128_t* b, size_t n);
+
+// DivModScalarN()
+//
+// Sets `quotient[i] = a[i] / divisor` and `remainder[i] = a[i] % divisor` for
+// `i` in `[0, n)`. `divisor` must not be zero. Its reciprocal is computed once,
+// after which each value takes four multiplications and no division.
+//
+// Example:
+//
+//   // Splits amounts in micro-units into whole units and fractions.
+//   absl::DivModScalarN(units.data(), micros.data(), amounts.data(), 1000000,
+//                       amounts.size());
+void DivModScalarN(uint128_t* quotient, uint64_t* remainder,
+                   const uint128_t* a, uint64_t divisor, size_t n);
+
+// CompareOp
+//
+// The comparison applied by `CompareN()`.
+enum class CompareOp {
+  kEq,  // x == c
+  kNe,  // x != c
+  kLt,  // x < c
+  kLe,  // x <= c
+  kGt,  // x > c
+  kGe,  // x >= c
+};
+
+// CompareN()
+//
+// Evaluates `values[i] op c` for `i` in `[0, n)` and stores the result in bit
+// `i % 64` of `bitmap[i / 64]`. `bitmap` must hold `(n + 63) / 64` words; bits
+// past `n` in the last word are cleared. Returns the number of selected
+// elements.
+//
+// High halves are compared first and the low halves only break ties, all
+// with vector compares on 4 (AVX2) or 8 (AVX-512) values at a time. The
+// column overloads read the limb arrays directly; the array overloads
+// deinterleave limbs after loading.
+//
+// Example:
+//
+//   std::vector<uint64_t> bitmap((n + 63) / 64);
+//   size_t hits = absl::CompareN(column, absl::CompareOp::kLt, limit,
+//                                bitmap.data());
+size_t CompareN(const uint128_t* values, size_t n, CompareOp op, uint128_t c,
+                uint64_t* bitmap);
+size_t CompareN(const int128_t* values, size_t n, CompareOp op, int128_t c,
+                uint64_t* bitmap);
+size_t CompareN(const Uint128Column& column, CompareOp op, uint128_t c,
+                uint64_t* bitmap);
+size_t CompareN(const Int128Column& column, CompareOp op, int128_t c,
+                uint64_t* bitmap);
+
+// BetweenN()
+//
+// Like `CompareN()`, for the half-open range predicate `lower <= x < upper`.
+size_t BetweenN(const uint128_t* values, size_t n, uint128_t lower,
+                uint128_t upper, uint64_t* bitmap);
+size_t BetweenN(const int128_t* values, size_t n, int128_t lower,
+                int128_t upper, uint64_t* bitmap);
+size_t BetweenN(const Uint128Column& column, uint128_t lower, uint128_t upper,
+                uint64_t* bitmap);
+size_t BetweenN(const Int128Column& column, int128_t lower, int128_t upper,
+                uint64_t* bitmap);
+
+// BitmapToSelection()
+//
+// Writes the indices of the bits set among the first `n` bits of `bitmap` to
+// `selection`, in increasing order, and returns how many were written.
+// `selection` must have room for that many indices. `n` must be below 2^32.
+size_t BitmapToSelection(const uint64_t* bitmap, size_t n,
+                         uint32_t* selection);
+
+// Execution
+//
+// Whether a reduction runs on the calling thread or splits its input into one
+// contiguous chunk per OpenMP thread. Small inputs always run sequentially.
+enum class Execution {
+  kSequential,
+  kParallel,
+};
+
+// BasicInt192
+//
+// The exact result of `Sum()`: the 192-bit two's complement value
+// `high * 2^128 + low`. `T` is the type of the summed values; the high word
+// is signed for `int128_t`. The sum of up to 2^64 values of `T` fits.
+template <typename T>
+struct BasicInt192 {
+  using High = typename int128_t_internal::ColumnTraits<T>::High;
+
+  High high = 0;
+  uint128_t low = 0;
+
+  // Returns whether the value is representable as `T`.
+  bool FitsIn128() const {
+    if (std::is_signed<High>::value) {
+      return high == (Uint128High64(low) >> 63 ? High(-1) : High(0));
+    }
+    return high == 0;
+  }
+
+  // Returns the value modulo 2^128, which is the value if FitsIn128().
+  T Truncate() const { return T(low); }
+};
+
+// Uint192
+//
+// The exact sum of `uint128_t` values.
+using Uint192 = BasicInt192<uint128_t>;
+
+// Int192
+//
+// The exact sum of `int128_t` values.
+using Int192 = BasicInt192<int128_t>;
+
+// Sum()
+//
+// Returns the sum of `values[0, n)`, computed without overflow.
+//
+// Example:
+//
+//   absl::Int192 total = absl::Sum(balances.data(), balances.size(),
+//                                  absl::Execution::kParallel);
+//   if (!total.FitsIn128()) ...
+Uint192 Sum(const uint128_t* values, size_t n,
+            Execution execution = Execution::kSequential);
+Int192 Sum(const int128_t* values, size_t n,
+           Execution execution = Execution::kSequential);
+
+// Min()
+// Max()
+// MinMax()
+//
+// Return the smallest, the largest, or both (as `{min, max}`) of
+// `values[0, n)`. `n` must not be zero.
+uint128_t Min(const uint128_t* values, size_t n,
+              Execution execution = Execution::kSequential);
+int128_t Min(const int128_t* values, size_t n,
+             Execution execution = Execution::kSequential);
+uint128_t Max(const uint128_t* values, size_t n,
+              Execution execution = Execution::kSequential);
+int128_t Max(const int128_t* values, size_t n,
+             Execution execution = Execution::kSequential);
+std::pair<uint128_t, uint128_t> MinMax(
+    const uint128_t* values, size_t n,
+    Execution execution = Execution::kSequential);
+std::pair<int128_t, int128_t> MinMax(
+    const int128_t* values, size_t n,
+    Execution execution = Execution::kSequential);
+
+// InclusivePrefixSum()
+// ExclusivePrefixSum()
+//
+// Set `dst[i]` to the sum of `a[0, i]` (inclusive) or of `a[0, i)`
+// (exclusive, so that `dst[0]` is zero) for `i` in `[0, n)`, wrapping modulo
+// 2^128 like `operator+`. `dst` may be `a`. With `Execution::kParallel`, each
+// thread sums its chunk, and then scans it again starting from the total of
+// the chunks before it.
+void InclusivePrefixSum(uint128_t* dst, const uint128_t* a, size_t n,
+                        Execution execution = Execution::kSequential);
+void InclusivePrefixSum(int128_t* dst, const int128_t* a, size_t n,
+                        Execution execution = Execution::kSequential);
+void ExclusivePrefixSum(uint128_t* dst, const uint128_t* a, size_t n,
+                        Execution execution = Execution::kSequential);
+void ExclusivePrefixSum(int128_t* dst, const int128_t* a, size_t n,
+                        Execution execution = Execution::kSequential);
+
+// ActiveKernelVariants()
+//
+// Returns the implementations the kernels currently use, as in
+// "vector=avx512 multiply=bmi2+adx varint=bmi2", for logging at startup. The
+// vector variant is that of the arithmetic, filter, reduction and byte swap
+// kernels; the multiply variant that of `MulN()`, `MulScalarN()`, `MulWideN()`
+// and `DivModScalarN()`; the varint variant that of the bulk varint codecs in
+// int128_varint.h.
+std::string ActiveKernelVariants();
+
+namespace int128_t_internal {
+
+// The instruction set extensions a kernel implementation may use.
+enum class KernelLevel {
+  kPortable,
+  kAvx2,
+  kAvx512,
+};
+
+// Returns the best level supported by the CPU and the build.
+KernelLevel DetectedKernelLevel();
+
+// Returns the level the kernels currently use.
+KernelLevel ActiveKernelLevel();
+
+// Selects the level the kernels use, for tests and benchmarks. Levels above
+// DetectedKernelLevel() are lowered to it.
+void SetKernelLevel(KernelLevel level);
+
+// The instruction set extensions the multiply and divide kernels may use:
+// BMI2 for mulx and the flagless shifts, ADX for the adcx and adox carry
+// chains.
+enum class MulKernelLevel {
+  kPortable,
+  kBmi2,
+  kBmi2Adx,
+};
+
+// Like DetectedKernelLevel(), ActiveKernelLevel() and SetKernelLevel(), for
+// the multiply and divide kernels.
+MulKernelLevel DetectedMulKernelLevel();
+MulKernelLevel ActiveMulKernelLevel();
+void SetMulKernelLevel(MulKernelLevel level);
+
+// Returns whether the varint codecs use pext and pdep: the multiply kernels
+// use BMI2, and the CPU is not an AMD Zen 1 or 2, which microcode them.
+bool UsePdep();
+
+}  // namespace int128_t_internal
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_KERNELS_H_
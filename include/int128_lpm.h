@@ -0,0 +1,140 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_lpm.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `LpmTable128`, a longest-prefix-match table over
+// `uint128_t` keys such as IPv6 addresses, and helpers converting between
+// netmasks and prefix lengths.
+//
+// The table is a compressed multibit trie in the style of Poptrie. The top 18
+// bits of a key index a flat array directly. Below that, each node covers 6
+// bits and holds two 64-bit bitmaps instead of 64 entries: one marks the
+// slots that have a child node, and the other marks where a run of slots
+// with the same value starts. A lookup finds the position of a child or value
+// in a node's array by counting the set bits below its slot (with popcnt
+// where the CPU has it), so a /48 takes one array access and at most five
+// node steps.
+//
+// With the benchmark in test_lpm.cpp on a 1.8 GHz Xeon virtual machine, a
+// table of 200,000 routes up to /48 (19 MB) answers `LookupN()` in 35 to 50 ns
+// per key, 20 to 30 million lookups per second, and `Lookup()` in 100 to
+// 150 ns, as each of its steps waits on a cache miss. A table that fits in
+// cache takes 25 to 30 ns per key. That is the cost of the node steps
+// themselves, so going faster needs fewer levels rather than more overlap.
+//
+// Example:
+//
+//   std::vector<absl::LpmRoute128> routes = {
+//       {address, 32, next_hop_a},
+//       {more_specific, 48, next_hop_b},
+//   };
+//   absl::LpmTable128 table(routes.data(), routes.size());
+//   uint32_t next_hop = table.Lookup(destination);
+//   if (next_hop == absl::LpmTable128::kNoMatch) ...
+
+#ifndef ABSL_INT128_LPM_H_
+#define ABSL_INT128_LPM_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "abslint128.h"
+
+namespace absl {
+
+// PrefixMask()
+//
+// Returns the netmask of a prefix of `length` bits: the top `length` bits set.
+// `length` must be in `[0, 128]`.
+constexpr uint128_t PrefixMask(int length) {
+  return length == 0 ? uint128_t(0) : Uint128Max() << (128 - length);
+}
+
+// PrefixLength()
+//
+// Returns the length of the prefix a netmask selects, or -1 if the set bits of
+// `mask` are not a contiguous run from the top.
+inline int PrefixLength(uint128_t mask) {
+  const int length = CountlZero(~mask);
+  return mask == PrefixMask(length) ? length : -1;
+}
+
+// LpmRoute128
+//
+// A prefix and the value a lookup of a key under it returns. Bits of `prefix`
+// past `length` are ignored.
+struct LpmRoute128 {
+  uint128_t prefix;
+  int length;  // in [0, 128]
+  uint32_t value;  // below LpmTable128::kNoMatch
+};
+
+// LpmTable128
+//
+// An immutable longest-prefix-match table, built in bulk from a list of
+// routes. To change the routes, build a new table.
+class LpmTable128 {
+ public:
+  // The value of keys that no route covers.
+  static constexpr uint32_t kNoMatch = 0x7fffffff;
+
+  // Constructs a table without routes.
+  LpmTable128();
+
+  // Constructs a table from `routes[0, n)`. If several routes have the same
+  // prefix and length, the last one wins.
+  LpmTable128(const LpmRoute128* routes, size_t n);
+
+  // Returns the value of the longest route that covers `key`, or kNoMatch.
+  uint32_t Lookup(uint128_t key) const;
+
+  // LookupN()
+  //
+  // Sets `values[i] = Lookup(keys[i])` for `i` in `[0, n)`. Lookups advance
+  // through the trie in batches, one level at a time, so that the cache misses
+  // of different keys overlap. On tables larger than the cache this is about
+  // three times as fast as calling `Lookup()` for each key.
+  void LookupN(const uint128_t* keys, size_t n, uint32_t* values) const;
+
+  // Returns the number of bytes the table occupies.
+  size_t MemoryUsage() const;
+
+ private:
+  struct Node {
+    uint64_t children;  // bit s: slot s has a child node
+    uint64_t runs;      // bit s: a run of equal values starts at slot s
+    uint32_t child_base;
+    uint32_t value_base;
+  };
+
+  class Builder;
+  struct Walker;
+
+  // Direct entries are a node index, or a value with kValueFlag set.
+  static constexpr uint32_t kValueFlag = 0x80000000;
+
+  std::vector<uint32_t> direct_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> values_;
+};
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_LPM_H_
@@ -0,0 +1,299 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_random.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines random number engines whose `operator()` returns
+// a uniformly distributed `uint128_t`, and unbiased uniform distributions over
+// `uint128_t` ranges:
+//
+//   * `Pcg64Dxsm`, the PCG64 DXSM generator (a 128-bit LCG with the "double
+//     xorshift multiply" output function), which can jump ahead any number of
+//     draws in logarithmic time and has 2^127 selectable streams.
+//   * `Xoshiro256PlusPlus`, the xoshiro256++ generator, which has no multiply
+//     in its step and is the faster of the two. `Jump()` advances it by 2^128
+//     steps, for non-overlapping parallel sequences.
+//
+// Each draw of a `uint128_t` takes two 64-bit outputs of the underlying
+// generator, high half first. `Next64()` returns a single output.
+//
+// `UniformUint128()` maps a draw to a range with Lemire's multiply-shift
+// method: the high half of the 256-bit product of the draw and the range size
+// is the result, and a draw is rejected only when the low half shows it would
+// introduce bias, which happens with probability below size / 2^128. The
+// rejection threshold takes a 128-bit modulo, but only on that rare path.
+//
+// Example:
+//
+//   absl::Xoshiro256PlusPlus engine(seed);
+//   absl::uint128_t id = engine();
+//   absl::uint128_t index = absl::UniformUint128(engine, 0, n - 1);
+//
+//   std::vector<absl::uint128_t> samples(1 << 20);
+//   absl::FillUniformUint128(engine, samples.data(), samples.size(), lo, hi);
+
+#ifndef ABSL_INT128_RANDOM_H_
+#define ABSL_INT128_RANDOM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "abslint128.h"
+
+namespace absl {
+
+// Pcg64Dxsm
+//
+// A PCG64 DXSM engine: the 128-bit LCG with the 64-bit "cheap multiplier"
+// and the output function of the variant NumPy ships as `PCG64DXSM`.
+class Pcg64Dxsm {
+ public:
+  using result_type = uint128_t;
+
+  static constexpr uint64_t kMultiplier = 0xda942042e4dd58b5u;
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return Uint128Max(); }
+
+  // Seeds the engine. Engines with different `stream` values produce
+  // different sequences; only the low 127 bits of `stream` are used.
+  explicit Pcg64Dxsm(uint128_t seed = 0xcafef00dd15ea5e5u,
+                     uint128_t stream = 0) {
+    this->seed(seed, stream);
+  }
+
+  void seed(uint128_t seed, uint128_t stream = 0) {
+    increment_ = (stream << 1) | 1;
+    state_ = 0;
+    Step();
+    state_ += seed;
+    Step();
+  }
+
+  // Returns the next 64-bit output.
+  uint64_t Next64() {
+    uint64_t hi = Uint128High64(state_);
+    const uint64_t lo = Uint128Low64(state_) | 1;
+    Step();
+    hi ^= hi >> 32;
+    hi *= kMultiplier;
+    hi ^= hi >> 48;
+    return hi * lo;
+  }
+
+  result_type operator()() {
+    const uint64_t hi = Next64();
+    return MakeUint128(hi, Next64());
+  }
+
+  // Advances the engine by `n` draws of `uint128_t`, in O(log n) steps.
+  void discard(uint128_t n) { Advance(n << 1); }
+
+  friend bool operator==(const Pcg64Dxsm& a, const Pcg64Dxsm& b) {
+    return a.state_ == b.state_ && a.increment_ == b.increment_;
+  }
+  friend bool operator!=(const Pcg64Dxsm& a, const Pcg64Dxsm& b) {
+    return !(a == b);
+  }
+
+ private:
+  // state * kMultiplier + increment, with two 64x64 multiplies instead of a
+  // full 128x128 one.
+  void Step() {
+    const uint128_t low = int128_t_internal::Multiply64To128(
+        Uint128Low64(state_), kMultiplier);
+    const uint64_t high =
+        Uint128High64(low) + Uint128High64(state_) * kMultiplier;
+    state_ = MakeUint128(high, Uint128Low64(low)) + increment_;
+  }
+
+  // Applies `steps` LCG steps by composing the affine map with itself, one
+  // bit of `steps` at a time (Brown, "Random Number Generation with
+  // Arbitrary Strides").
+  void Advance(uint128_t steps) {
+    uint128_t multiplier = kMultiplier;
+    uint128_t increment = increment_;
+    uint128_t total_multiplier = 1;
+    uint128_t total_increment = 0;
+    while (steps != 0) {
+      if ((Uint128Low64(steps) & 1) != 0) {
+        total_multiplier *= multiplier;
+        total_increment = total_increment * multiplier + increment;
+      }
+      increment = (multiplier + 1) * increment;
+      multiplier *= multiplier;
+      steps >>= 1;
+    }
+    state_ = total_multiplier * state_ + total_increment;
+  }
+
+  uint128_t state_;
+  uint128_t increment_;
+};
+
+// Xoshiro256PlusPlus
+//
+// An xoshiro256++ engine.
+class Xoshiro256PlusPlus {
+ public:
+  using result_type = uint128_t;
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return Uint128Max(); }
+
+  // Seeds the state with four outputs of SplitMix64 started at `seed`, as the
+  // authors of xoshiro recommend, which never yields the all-zero state.
+  explicit Xoshiro256PlusPlus(uint64_t seed = 0x853c49e6748fea9bu) {
+    this->seed(seed);
+  }
+
+  void seed(uint64_t seed) {
+    for (uint64_t& s : s_) {
+      seed += 0x9e3779b97f4a7c15u;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  // Returns the next 64-bit output.
+  uint64_t Next64() {
+    const uint64_t result = Rotl64(s_[0] + s_[3], 23) + s_[0];
+    const uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = Rotl64(s_[3], 45);
+    return result;
+  }
+
+  result_type operator()() {
+    const uint64_t hi = Next64();
+    return MakeUint128(hi, Next64());
+  }
+
+  // Advances the engine by 2^128 64-bit outputs. Engines seeded alike and
+  // jumped 0, 1, 2, ... times produce non-overlapping sequences for any
+  // practical length.
+  void Jump() {
+    static constexpr uint64_t kJump[] = {
+        0x180ec6d33cfd0abau, 0xd5a61266f0c9392cu, 0xa9582618e03fc9aau,
+        0x39abdc4529b1661cu};
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (uint64_t word : kJump) {
+      for (int b = 0; b < 64; ++b) {
+        if ((word >> b) & 1) {
+          for (int i = 0; i < 4; ++i) s[i] ^= s_[i];
+        }
+        Next64();
+      }
+    }
+    for (int i = 0; i < 4; ++i) s_[i] = s[i];
+  }
+
+  friend bool operator==(const Xoshiro256PlusPlus& a,
+                         const Xoshiro256PlusPlus& b) {
+    return a.s_[0] == b.s_[0] && a.s_[1] == b.s_[1] && a.s_[2] == b.s_[2] &&
+           a.s_[3] == b.s_[3];
+  }
+  friend bool operator!=(const Xoshiro256PlusPlus& a,
+                         const Xoshiro256PlusPlus& b) {
+    return !(a == b);
+  }
+
+ private:
+  static uint64_t Rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t s_[4];
+};
+
+namespace int128_t_internal {
+
+// The precomputed part of Lemire's method for a range of `size` values.
+class LemireRange {
+ public:
+  // `size == 0` stands for the full range of 2^128 values.
+  explicit LemireRange(uint128_t size) : size_(size) {}
+
+  // Maps draws of `engine` to `[0, size)`.
+  template <typename Engine>
+  uint128_t operator()(Engine& engine) {
+    uint128_t x = engine();
+    if (size_ == 0) return x;
+    uint128_t high;
+    uint128_t low = Multiply128To256(x, size_, &high);
+    if (low < size_) {
+      // Of the 2^128 draws, 2^128 mod size must be rejected so that each
+      // result is the high half for equally many of them.
+      if (!has_threshold_) {
+        threshold_ = -size_ % size_;
+        has_threshold_ = true;
+      }
+      while (low < threshold_) {
+        x = engine();
+        low = Multiply128To256(x, size_, &high);
+      }
+    }
+    return high;
+  }
+
+ private:
+  uint128_t size_;
+  uint128_t threshold_ = 0;
+  bool has_threshold_ = false;
+};
+
+}  // namespace int128_t_internal
+
+// UniformUint128()
+//
+// Returns a value drawn uniformly from the closed interval `[lo, hi]`, which
+// lets the full range be drawn. For `[0, n)`, pass `0` and `n - 1`. `lo` must
+// not exceed `hi`.
+template <typename Engine>
+uint128_t UniformUint128(Engine& engine, uint128_t lo, uint128_t hi) {
+  return lo + int128_t_internal::LemireRange(hi - lo + 1)(engine);
+}
+
+// FillRandom()
+//
+// Sets `out[0, n)` to successive draws of `engine`.
+template <typename Engine>
+void FillRandom(Engine& engine, uint128_t* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = engine();
+}
+
+// FillUniformUint128()
+//
+// Sets `out[0, n)` to values drawn uniformly from `[lo, hi]`. The values are
+// those of `n` successive `UniformUint128()` calls, but the rejection
+// threshold is computed at most once for the whole array.
+template <typename Engine>
+void FillUniformUint128(Engine& engine, uint128_t* out, size_t n, uint128_t lo,
+                        uint128_t hi) {
+  int128_t_internal::LemireRange range(hi - lo + 1);
+  for (size_t i = 0; i < n; ++i) out[i] = lo + range(engine);
+}
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_RANDOM_H_
@@ -0,0 +1,88 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_sort.h
+// -----------------------------------------------------------------------------
+//
+// This header file declares sorting functions for arrays of `uint128_t` and
+// `int128_t` keys.
+//
+// `RadixSort()` is a least-significant-digit radix sort on 10- and 11-bit
+// digits. One read of the keys counts every digit. Each of the up to 12
+// passes then scatters the keys by one digit into a scratch buffer. A pass is
+// skipped when all keys share its digit, which is common in structured keys
+// such as IPv6 addresses or zero-extended integers. The sort runs in O(n)
+// time and needs O(n) extra memory.
+//
+// `Sort()` is a comparison sort, and with `Execution::kParallel` a parallel
+// merge sort. Run sequentially, it needs no scratch memory.
+//
+// Example:
+//
+//   std::vector<absl::uint128_t> addresses = ...;
+//   absl::RadixSort(addresses.data(), addresses.size(),
+//                   absl::Execution::kParallel);
+
+#ifndef ABSL_INT128_SORT_H_
+#define ABSL_INT128_SORT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "abslint128.h"
+#include "int128_kernels.h"
+
+namespace absl {
+
+// RadixSort()
+//
+// Sorts `keys[0, n)` in ascending order. The sort is stable. With
+// `Execution::kParallel`, the counting and scattering of large inputs are
+// split across OpenMP threads.
+void RadixSort(uint128_t* keys, size_t n,
+               Execution execution = Execution::kSequential);
+void RadixSort(int128_t* keys, size_t n,
+               Execution execution = Execution::kSequential);
+
+// RadixSortByKey()
+//
+// Sorts `keys[0, n)` like `RadixSort()` and applies the same permutation to
+// `values[0, n)`. For example, with `values[i] == i` beforehand, `values`
+// holds the original index of each sorted key afterwards.
+void RadixSortByKey(uint128_t* keys, uint32_t* values, size_t n,
+                    Execution execution = Execution::kSequential);
+void RadixSortByKey(uint128_t* keys, uint64_t* values, size_t n,
+                    Execution execution = Execution::kSequential);
+void RadixSortByKey(int128_t* keys, uint32_t* values, size_t n,
+                    Execution execution = Execution::kSequential);
+void RadixSortByKey(int128_t* keys, uint64_t* values, size_t n,
+                    Execution execution = Execution::kSequential);
+
+// Sort()
+//
+// Sorts `keys[0, n)` in ascending order. The sort is not stable. Run
+// sequentially, it is `std::sort`. With `Execution::kParallel`, each thread
+// sorts one chunk of a large input, and the sorted chunks are then merged in
+// pairs. Each merge is split at balanced points (the "merge path") so that
+// every round keeps all threads busy, including the last one.
+void Sort(uint128_t* keys, size_t n,
+          Execution execution = Execution::kSequential);
+void Sort(int128_t* keys, size_t n,
+          Execution execution = Execution::kSequential);
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_SORT_H_
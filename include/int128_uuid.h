@@ -0,0 +1,175 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_uuid.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `Uuid`, a UUID held as the `uint128_t` whose
+// big-endian bytes are the UUID's 16 bytes, and conversions to and from the
+// canonical 36-character text form, such as
+// "123e4567-e89b-12d3-a456-426614174000". Ordering and hashing are those of
+// the integer, which orders UUIDs as their text does.
+//
+// Parsing and formatting use SSSE3 byte shuffles where the CPU has them.
+// Neither allocates; the batch forms convert whole arrays of `uint128_t`, so
+// UUIDs stored as integers need no copy into `Uuid` first.
+//
+// Example:
+//
+//   absl::Uuid id;
+//   if (!absl::Uuid::Parse(text, absl::kUuidStringLength, &id)) { ... }
+//   if (id.version() == 4) { ... }
+//   char buffer[absl::kUuidStringLength];
+//   id.Format(buffer);
+
+#ifndef ABSL_INT128_UUID_H_
+#define ABSL_INT128_UUID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "abslint128.h"
+
+namespace absl {
+
+// The length of the canonical text form of a UUID.
+constexpr size_t kUuidStringLength = 36;
+
+// UuidVariant
+//
+// The layout a UUID follows, from the top bits of its byte 8.
+enum class UuidVariant {
+  kNcs,        // 0xxx: Apollo NCS, obsolete
+  kRfc4122,    // 10xx: RFC 4122 and RFC 9562
+  kMicrosoft,  // 110x: Microsoft GUIDs, obsolete
+  kFuture,     // 111x: reserved
+};
+
+namespace int128_t_internal {
+
+bool ParseUuid(const char* text, uint128_t* value);
+void FormatUuid(uint128_t value, char* out);
+
+}  // namespace int128_t_internal
+
+// Uuid
+//
+// A UUID. The default value is the nil UUID, all zeros.
+class Uuid {
+ public:
+  constexpr Uuid() : value_(0) {}
+  constexpr explicit Uuid(uint128_t value) : value_(value) {}
+
+  // Returns the UUID as an integer: byte 0 of the UUID is the top byte.
+  constexpr uint128_t value() const { return value_; }
+
+  // Returns the version number, the top four bits of byte 6. For the
+  // RFC 4122 variant, 4 is a random UUID and 7 a time-ordered one.
+  constexpr int version() const {
+    return static_cast<int>(Uint128High64(value_) >> 12 & 0xf);
+  }
+
+  constexpr UuidVariant variant() const {
+    const uint64_t bits = Uint128Low64(value_) >> 61;
+    return bits < 4   ? UuidVariant::kNcs
+           : bits < 6 ? UuidVariant::kRfc4122
+           : bits < 7 ? UuidVariant::kMicrosoft
+                      : UuidVariant::kFuture;
+  }
+
+  // Parse()
+  //
+  // Parses the canonical form, 32 hex digits in either case with hyphens
+  // after the 8th, 12th, 16th and 20th, from the `size` characters at
+  // `text`. Returns false, leaving `*uuid` unchanged, if they are anything
+  // else.
+  static bool Parse(const char* text, size_t size, Uuid* uuid) {
+    uint128_t value;
+    if (size != kUuidStringLength ||
+        !int128_t_internal::ParseUuid(text, &value)) {
+      return false;
+    }
+    *uuid = Uuid(value);
+    return true;
+  }
+  static bool Parse(const std::string& text, Uuid* uuid) {
+    return Parse(text.data(), text.size(), uuid);
+  }
+
+  // Format()
+  //
+  // Writes the canonical form, in lowercase, to `out[0, kUuidStringLength)`.
+  // No terminating null is written.
+  void Format(char* out) const { int128_t_internal::FormatUuid(value_, out); }
+
+  std::string ToString() const {
+    std::string text(kUuidStringLength, '\0');
+    Format(&text[0]);
+    return text;
+  }
+
+  friend bool operator==(Uuid a, Uuid b) { return a.value_ == b.value_; }
+  friend bool operator!=(Uuid a, Uuid b) { return a.value_ != b.value_; }
+  friend bool operator<(Uuid a, Uuid b) { return a.value_ < b.value_; }
+  friend bool operator>(Uuid a, Uuid b) { return a.value_ > b.value_; }
+  friend bool operator<=(Uuid a, Uuid b) { return a.value_ <= b.value_; }
+  friend bool operator>=(Uuid a, Uuid b) { return a.value_ >= b.value_; }
+
+  // Support for absl::Hash.
+  template <typename H>
+  friend H AbslHashValue(H h, Uuid v) {
+    return H::combine(std::move(h), v.value_);
+  }
+
+ private:
+  uint128_t value_;
+};
+
+// ParseUuids()
+//
+// Parses `n` UUIDs in canonical form, the `i`th taking the
+// `kUuidStringLength` characters at `text + i * stride`, into `out[0, n)`.
+// `stride` must be at least `kUuidStringLength`; the characters between the
+// UUIDs are not read. Returns the index of the first one that fails to parse,
+// with the values before it written, or `n` if all parse.
+size_t ParseUuids(const char* text, size_t stride, size_t n, uint128_t* out);
+size_t ParseUuids(const char* text, size_t stride, size_t n, Uuid* out);
+
+// FormatUuids()
+//
+// Writes the canonical forms of `values[0, n)` to `out`, the `i`th at
+// `out + i * stride`. `stride` must be at least `kUuidStringLength`; the
+// characters between the UUIDs are left as they are, so a caller may fill in
+// separators once and format into the same buffer repeatedly.
+void FormatUuids(const uint128_t* values, size_t n, char* out, size_t stride);
+void FormatUuids(const Uuid* uuids, size_t n, char* out, size_t stride);
+
+}  // namespace absl
+
+// The hash of a `Uuid` is that of its `uint128_t` value.
+namespace std {
+template <>
+struct hash<absl::Uuid> {
+  size_t operator()(absl::Uuid v) const {
+    return hash<absl::uint128_t>()(v.value());
+  }
+};
+}  // namespace std
+
+#endif  // ABSL_INT128_UUID_H_
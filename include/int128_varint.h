@@ -0,0 +1,137 @@
+//
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: int128_varint.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines the LEB128 variable-length encoding of `uint128_t`
+// (the base-128 varint of Protocol Buffers, extended to 128 bits) and the
+// zigzag mapping that gives small negative `int128_t` values short encodings
+// too.
+//
+// A value takes one byte per 7 significant bits, least significant group
+// first, with the high bit of each byte set when more bytes follow: 1 byte
+// below 2^7, and at most `kMaxVarint128Bytes` (19) bytes.
+//
+// The decoder reads 8 bytes at a time and finds the terminating byte of each
+// value from the clear high bits of a whole word, then gathers the 7-bit
+// groups with `pext` on CPUs with BMI2 and with a fixed sequence of shifts and
+// masks elsewhere, so that only the value's length in words is a branch.
+//
+// Example:
+//
+//   uint8_t buffer[absl::kMaxVarint128Bytes];
+//   uint8_t* end = absl::EncodeVarint128(absl::ZigZagEncode128(delta), buffer);
+//
+//   absl::uint128_t value;
+//   const uint8_t* next = absl::DecodeVarint128(p, end, &value);
+//   if (next == nullptr) { /* truncated or malformed input */ }
+
+#ifndef ABSL_INT128_VARINT_H_
+#define ABSL_INT128_VARINT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "abslint128.h"
+
+namespace absl {
+
+// kMaxVarint128Bytes
+//
+// The length of the encoding of values of 2^126 and more.
+constexpr size_t kMaxVarint128Bytes = 19;
+
+// Varint128Length()
+//
+// Returns the number of bytes `EncodeVarint128()` writes for `v`.
+inline size_t Varint128Length(uint128_t v) {
+  const int bits = 128 - CountlZero(v);
+  return bits == 0 ? 1 : static_cast<size_t>(bits + 6) / 7;
+}
+
+namespace int128_t_internal {
+
+// Returns all ones if `v` is negative, and zero otherwise.
+constexpr uint64_t SignMask64(int64_t v) {
+  return 0 - (static_cast<uint64_t>(v) >> 63);
+}
+
+}  // namespace int128_t_internal
+
+// ZigZagEncode128()
+// ZigZagDecode128()
+//
+// Map `int128_t` values to `uint128_t` ones that are small when the magnitude
+// is small: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ... They compute
+// `(v << 1) ^ (v >> 127)` and its inverse one 64-bit limb at a time.
+constexpr uint128_t ZigZagEncode128(int128_t v) {
+  return MakeUint128(((static_cast<uint64_t>(Int128High64(v)) << 1) |
+                      (Int128Low64(v) >> 63)) ^
+                         int128_t_internal::SignMask64(Int128High64(v)),
+                     (Int128Low64(v) << 1) ^
+                         int128_t_internal::SignMask64(Int128High64(v)));
+}
+
+constexpr int128_t ZigZagDecode128(uint128_t v) {
+  return MakeInt128(static_cast<int64_t>((Uint128High64(v) >> 1) ^
+                                         (0 - (Uint128Low64(v) & 1))),
+                    ((Uint128Low64(v) >> 1) | (Uint128High64(v) << 63)) ^
+                        (0 - (Uint128Low64(v) & 1)));
+}
+
+// EncodeVarint128()
+//
+// Writes the encoding of `v` to `out` and returns a pointer past its last
+// byte. `out` must have room for `kMaxVarint128Bytes` bytes, whatever the
+// length of the encoding.
+uint8_t* EncodeVarint128(uint128_t v, uint8_t* out);
+
+// DecodeVarint128()
+//
+// Decodes the value starting at `p` into `*value` and returns a pointer past
+// its last byte, reading no byte at or past `end`. Returns `nullptr` if the
+// input ends within the value, or the value does not fit in 128 bits.
+// Encodings with redundant zero groups, as in `0x80 0x00` for 0, are
+// accepted.
+const uint8_t* DecodeVarint128(const uint8_t* p, const uint8_t* end,
+                               uint128_t* value);
+
+// EncodeVarint128N()
+// EncodeZigZagVarint128N()
+//
+// Write the encodings of `values[0, n)` back to back to `out` and return a
+// pointer past the last byte. `out` must have room for
+// `n * kMaxVarint128Bytes` bytes. The `int128_t` overload zigzag-encodes each
+// value first.
+uint8_t* EncodeVarint128N(const uint128_t* values, size_t n, uint8_t* out);
+uint8_t* EncodeZigZagVarint128N(const int128_t* values, size_t n,
+                                uint8_t* out);
+
+// DecodeVarint128N()
+// DecodeZigZagVarint128N()
+//
+// Decode `n` consecutive values starting at `p` into `values[0, n)` and return
+// a pointer past the last one, or `nullptr` under the conditions of
+// `DecodeVarint128()`, in which case the contents of `values` are unspecified.
+const uint8_t* DecodeVarint128N(const uint8_t* p, const uint8_t* end,
+                                uint128_t* values, size_t n);
+const uint8_t* DecodeZigZagVarint128N(const uint8_t* p, const uint8_t* end,
+                                      int128_t* values, size_t n);
+
+}  // namespace absl
+
+#endif  // ABSL_INT128_VARINT_H_
@@ -0,0 +1,389 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_column_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ABSL_INT128_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define ABSL_INT128_HAVE_MMAP 0
+#endif
+
+namespace absl {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', '1', '2', '8', 'C', 'O', 'L', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderBytes = 64;
+constexpr uint8_t kChecksumFlag = 1;
+
+// The values converted per write.
+constexpr size_t kChunk = 4096;
+
+uint64_t Load64(const uint8_t* p) {
+  return int128_t_internal::LittleEndian64(int128_t_internal::LoadHost64(p));
+}
+
+uint32_t Load32(const uint8_t* p) {
+  return static_cast<uint32_t>(Load64(p));
+}
+
+void Store64(uint8_t* p, uint64_t v) {
+  int128_t_internal::StoreHost64(p, int128_t_internal::LittleEndian64(v));
+}
+
+bool Fail(std::string* error, const std::string& message) {
+  if (error != nullptr) *error = message;
+  return false;
+}
+
+bool FailErrno(std::string* error, const std::string& what,
+               const std::string& path) {
+  return Fail(error, what + " " + path + ": " + std::strerror(errno));
+}
+
+// XXH64, computed incrementally over 32-byte stripes.
+class Xxh64State {
+ public:
+  void Update(const uint8_t* p, size_t size) {
+    total_ += size;
+    if (buffered_ != 0) {
+      const size_t take = std::min(size, sizeof(buffer_) - buffered_);
+      std::memcpy(buffer_ + buffered_, p, take);
+      buffered_ += take;
+      p += take;
+      size -= take;
+      if (buffered_ < sizeof(buffer_)) return;
+      Stripe(buffer_);
+      buffered_ = 0;
+    }
+    for (; size >= 32; p += 32, size -= 32) Stripe(p);
+    std::memcpy(buffer_, p, size);
+    buffered_ = size;
+  }
+
+  uint64_t Finish() const {
+    uint64_t h;
+    if (total_ >= 32) {
+      h = Rotl(v_[0], 1) + Rotl(v_[1], 7) + Rotl(v_[2], 12) + Rotl(v_[3], 18);
+      for (uint64_t v : v_) h = (h ^ Round(0, v)) * kPrime1 + kPrime4;
+    } else {
+      h = kPrime5;
+    }
+    h += total_;
+    const uint8_t* p = buffer_;
+    size_t size = buffered_;
+    for (; size >= 8; p += 8, size -= 8) {
+      h = Rotl(h ^ Round(0, Load64(p)), 27) * kPrime1 + kPrime4;
+    }
+    if (size >= 4) {
+      uint32_t word = 0;
+      for (int i = 0; i < 4; ++i) word |= uint32_t{p[i]} << (8 * i);
+      h = Rotl(h ^ (word * kPrime1), 23) * kPrime2 + kPrime3;
+      p += 4;
+      size -= 4;
+    }
+    for (; size > 0; ++p, --size) h = Rotl(h ^ (*p * kPrime5), 11) * kPrime1;
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    return h ^ (h >> 32);
+  }
+
+ private:
+  static constexpr uint64_t kPrime1 = 0x9e3779b185ebca87u;
+  static constexpr uint64_t kPrime2 = 0xc2b2ae3d27d4eb4fu;
+  static constexpr uint64_t kPrime3 = 0x165667b19e3779f9u;
+  static constexpr uint64_t kPrime4 = 0x85ebca77c2b2ae63u;
+  static constexpr uint64_t kPrime5 = 0x27d4eb2f165667c5u;
+
+  static uint64_t Rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  static uint64_t Round(uint64_t acc, uint64_t input) {
+    return Rotl(acc + input * kPrime2, 31) * kPrime1;
+  }
+
+  void Stripe(const uint8_t* p) {
+    for (int i = 0; i < 4; ++i) v_[i] = Round(v_[i], Load64(p + 8 * i));
+  }
+
+  uint64_t v_[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+  uint8_t buffer_[32];
+  size_t buffered_ = 0;
+  uint64_t total_ = 0;
+};
+
+// Data sources for the writer: whole values in a byte order, or one limb.
+template <typename T>
+struct ArraySource {
+  void Values(size_t begin, size_t n, ColumnByteOrder order,
+              uint8_t* out) const {
+    if (order == ColumnByteOrder::kLittleEndian) {
+      StoreLE128N(out, values + begin, n);
+    } else {
+      StoreBE128N(out, values + begin, n);
+    }
+  }
+  uint64_t High(size_t i) const {
+    return static_cast<uint64_t>(int128_t_internal::ColumnTraits<T>::HighOf(
+        values[i]));
+  }
+  uint64_t Low(size_t i) const {
+    return int128_t_internal::ColumnTraits<T>::LowOf(values[i]);
+  }
+
+  const T* values;
+};
+
+template <typename T>
+struct ColumnSource {
+  void Values(size_t begin, size_t n, ColumnByteOrder order,
+              uint8_t* out) const {
+    for (size_t i = 0; i < n; ++i) {
+      if (order == ColumnByteOrder::kLittleEndian) {
+        StoreLE128(out + 16 * i, column[begin + i]);
+      } else {
+        StoreBE128(out + 16 * i, column[begin + i]);
+      }
+    }
+  }
+  uint64_t High(size_t i) const {
+    return static_cast<uint64_t>(column.hi()[i]);
+  }
+  uint64_t Low(size_t i) const { return column.lo()[i]; }
+
+  const BasicInt128Column<T>& column;
+};
+
+// Writes the header and data of a column file to `file`.
+template <typename Source>
+bool WriteContents(std::FILE* file, const Source& source, size_t n,
+                   bool is_signed, const ColumnFileOptions& options) {
+  uint8_t header[kHeaderBytes] = {};
+  if (std::fwrite(header, 1, kHeaderBytes, file) != kHeaderBytes) return false;
+
+  Xxh64State checksum;
+  std::vector<uint8_t> chunk(16 * kChunk);
+  auto write = [&](size_t bytes) {
+    if (options.checksum) checksum.Update(chunk.data(), bytes);
+    return std::fwrite(chunk.data(), 1, bytes, file) == bytes;
+  };
+  auto store_limb = [&](uint8_t* p, uint64_t v) {
+    int128_t_internal::StoreHost64(
+        p, options.byte_order == ColumnByteOrder::kLittleEndian
+               ? int128_t_internal::LittleEndian64(v)
+               : int128_t_internal::BigEndian64(v));
+  };
+  if (options.layout == ColumnLayout::kInterleaved) {
+    for (size_t begin = 0; begin < n; begin += kChunk) {
+      const size_t count = std::min(kChunk, n - begin);
+      source.Values(begin, count, options.byte_order, chunk.data());
+      if (!write(16 * count)) return false;
+    }
+  } else {
+    for (int half = 0; half < 2; ++half) {
+      for (size_t begin = 0; begin < n; begin += 2 * kChunk) {
+        const size_t count = std::min(2 * kChunk, n - begin);
+        for (size_t i = 0; i < count; ++i) {
+          store_limb(chunk.data() + 8 * i, half == 0 ? source.High(begin + i)
+                                                     : source.Low(begin + i));
+        }
+        if (!write(8 * count)) return false;
+      }
+    }
+  }
+
+  std::memcpy(header, kMagic, sizeof(kMagic));
+  header[8] = static_cast<uint8_t>(kVersion);
+  header[12] = static_cast<uint8_t>(options.byte_order);
+  header[13] = is_signed ? 1 : 0;
+  header[14] = static_cast<uint8_t>(options.layout);
+  header[15] = options.checksum ? kChecksumFlag : 0;
+  Store64(header + 16, n);
+  Store64(header + 24, options.checksum ? checksum.Finish() : 0);
+  return std::fseek(file, 0, SEEK_SET) == 0 &&
+         std::fwrite(header, 1, kHeaderBytes, file) == kHeaderBytes;
+}
+
+template <typename Source>
+bool Write(const std::string& path, const Source& source, size_t n,
+           bool is_signed, const ColumnFileOptions& options,
+           std::string* error) {
+  const std::string temp = path + ".tmp";
+  std::FILE* file = std::fopen(temp.c_str(), "wb");
+  if (file == nullptr) return FailErrno(error, "cannot create", temp);
+  if (!WriteContents(file, source, n, is_signed, options)) {
+    const bool failed = FailErrno(error, "cannot write", temp);
+    std::fclose(file);
+    std::remove(temp.c_str());
+    return failed;
+  }
+  if (std::fclose(file) != 0) {
+    const bool failed = FailErrno(error, "cannot write", temp);
+    std::remove(temp.c_str());
+    return failed;
+  }
+  if (std::rename(temp.c_str(), path.c_str()) != 0) {
+    const bool failed = FailErrno(error, "cannot rename to", path);
+    std::remove(temp.c_str());
+    return failed;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool WriteColumnFile(const std::string& path, const uint128_t* values,
+                     size_t n, const ColumnFileOptions& options,
+                     std::string* error) {
+  return Write(path, ArraySource<uint128_t>{values}, n, false, options, error);
+}
+
+bool WriteColumnFile(const std::string& path, const int128_t* values, size_t n,
+                     const ColumnFileOptions& options, std::string* error) {
+  return Write(path, ArraySource<int128_t>{values}, n, true, options, error);
+}
+
+bool WriteColumnFile(const std::string& path, const Uint128Column& column,
+                     const ColumnFileOptions& options, std::string* error) {
+  return Write(path, ColumnSource<uint128_t>{column}, column.size(), false,
+               options, error);
+}
+
+bool WriteColumnFile(const std::string& path, const Int128Column& column,
+                     const ColumnFileOptions& options, std::string* error) {
+  return Write(path, ColumnSource<int128_t>{column}, column.size(), true,
+               options, error);
+}
+
+namespace int128_t_internal {
+
+uint64_t Xxh64(const void* data, size_t size) {
+  Xxh64State state;
+  state.Update(static_cast<const uint8_t*>(data), size);
+  return state.Finish();
+}
+
+bool MappedColumnFile::Open(const std::string& path, bool is_signed,
+                            std::string* error) {
+  Close();
+#if ABSL_INT128_HAVE_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return FailErrno(error, "cannot open", path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    const bool failed = FailErrno(error, "cannot stat", path);
+    ::close(fd);
+    return failed;
+  }
+  const size_t file_size = static_cast<size_t>(st.st_size);
+  if (file_size < kHeaderBytes) {
+    ::close(fd);
+    return Fail(error, path + " is not a column file");
+  }
+  void* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return FailErrno(error, "cannot map", path);
+#else
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) return FailErrno(error, "cannot open", path);
+  std::vector<uint8_t> contents;
+  uint8_t buffer[1 << 16];
+  for (size_t got; (got = std::fread(buffer, 1, sizeof(buffer), file)) != 0;) {
+    contents.insert(contents.end(), buffer, buffer + got);
+  }
+  const bool read_error = std::ferror(file) != 0;
+  std::fclose(file);
+  if (read_error) return Fail(error, "cannot read " + path);
+  const size_t file_size = contents.size();
+  if (file_size < kHeaderBytes) {
+    return Fail(error, path + " is not a column file");
+  }
+  // Without mmap the file is read into memory aligned as a mapping would be.
+  void* mapping = ::operator new(file_size, std::align_val_t(kHeaderBytes));
+  std::memcpy(mapping, contents.data(), file_size);
+#endif  // ABSL_INT128_HAVE_MMAP
+  mapping_ = mapping;
+  mapping_size_ = file_size;
+
+  const uint8_t* header = static_cast<const uint8_t*>(mapping);
+  bool reserved_zero = true;
+  for (size_t i = 32; i < kHeaderBytes; ++i) reserved_zero &= header[i] == 0;
+  const uint64_t count = Load64(header + 16);
+  std::string problem;
+  if (std::memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+    problem = " is not a column file";
+  } else if (Load32(header + 8) != kVersion) {
+    problem = " has an unsupported format version";
+  } else if (header[12] > 1 || header[13] > 1 || header[14] > 1 ||
+             (header[15] & ~kChecksumFlag) != 0 || !reserved_zero) {
+    problem = " has an invalid header";
+  } else if (count > (file_size - kHeaderBytes) / 16 ||
+             kHeaderBytes + 16 * count != file_size) {
+    problem = " has the wrong size for its number of values";
+  } else if ((header[13] == 1) != is_signed) {
+    problem = is_signed ? " holds uint128_t values, not int128_t"
+                        : " holds int128_t values, not uint128_t";
+  }
+  if (!problem.empty()) {
+    Close();
+    return Fail(error, path + problem);
+  }
+  data_ = header + kHeaderBytes;
+  size_ = static_cast<size_t>(count);
+  byte_order_ = static_cast<ColumnByteOrder>(header[12]);
+  layout_ = static_cast<ColumnLayout>(header[14]);
+  has_checksum_ = (header[15] & kChecksumFlag) != 0;
+  checksum_ = Load64(header + 24);
+  return true;
+}
+
+void MappedColumnFile::Close() {
+  if (mapping_ != nullptr) {
+#if ABSL_INT128_HAVE_MMAP
+    ::munmap(mapping_, mapping_size_);
+#else
+    ::operator delete(mapping_, std::align_val_t(kHeaderBytes));
+#endif
+  }
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  data_ = nullptr;
+  size_ = 0;
+  has_checksum_ = false;
+  checksum_ = 0;
+}
+
+bool MappedColumnFile::VerifyChecksum() const {
+  return !has_checksum_ || Xxh64(data_, 16 * size_) == checksum_;
+}
+
+}  // namespace int128_t_internal
+
+}  // namespace absl
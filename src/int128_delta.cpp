@@ -0,0 +1,257 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_delta.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "int128_endian.h"
+#include "int128_kernels.h"
+
+// The packed words are little-endian, so the vector unpacker loads them
+// directly on little-endian hosts only.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && \
+    defined(ABSL_IS_LITTLE_ENDIAN)
+#define ABSL_INT128_DELTA_AVX2 1
+#include <immintrin.h>
+#define ABSL_INT128_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ABSL_INT128_DELTA_AVX2 0
+#endif
+
+namespace absl {
+
+namespace {
+
+constexpr size_t kLanes = 4;
+constexpr size_t kHeaderBytes = 40;
+
+inline uint64_t Load64(const uint8_t* p) {
+  return int128_t_internal::LittleEndian64(int128_t_internal::LoadHost64(p));
+}
+
+inline void Store64(uint8_t* p, uint64_t v) {
+  int128_t_internal::StoreHost64(p, int128_t_internal::LittleEndian64(v));
+}
+
+// Returns a mask of the low `bits` bits, for `bits` in [0, 64].
+inline uint64_t LowMask(int bits) {
+  return bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+}
+
+// Returns the number of rows of four differences in a block of `n` values.
+constexpr size_t Rows(size_t n) { return (n + 2) / kLanes; }
+
+// Returns the number of packed words of each lane.
+inline size_t LaneWords(size_t n, int width) {
+  return (Rows(n) * static_cast<size_t>(width) + 63) / 64;
+}
+
+// Unpacks the four differences of `row` into `lo[0, 4)` and, when `width`
+// exceeds 64, `hi[0, 4)`. A difference starting at bit `s` of a word
+// continues into the same lane of the next word only if `s + width > 64`,
+// so no word past the end of the lane is read.
+void UnpackRow(const uint8_t* packed, int width, size_t row, uint64_t* lo,
+               uint64_t* hi) {
+  const size_t bit = row * static_cast<size_t>(width);
+  const int s = static_cast<int>(bit % 64);
+  const uint8_t* words = packed + bit / 64 * kLanes * 8;
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    const uint8_t* w = words + 8 * lane;
+    uint64_t low = Load64(w) >> s;
+    if (s != 0 && s + width > 64) low |= Load64(w + 8 * kLanes) << (64 - s);
+    if (width <= 64) {
+      lo[lane] = low & LowMask(width);
+      continue;
+    }
+    uint64_t high = Load64(w + 8 * kLanes) >> s;
+    if (s != 0 && s + width > 128) {
+      high |= Load64(w + 16 * kLanes) << (64 - s);
+    }
+    lo[lane] = low;
+    hi[lane] = high & LowMask(width - 64);
+  }
+}
+
+#if ABSL_INT128_DELTA_AVX2
+
+// Unpacks whole rows with one shift pair per 64-bit limb for all four lanes,
+// as long as the words after the row's first one lie within the lanes, and
+// returns the number of rows unpacked.
+ABSL_INT128_TARGET_AVX2 size_t Unpack256(const uint8_t* packed,
+                                         size_t lane_words, int width,
+                                         size_t rows, uint64_t* lo,
+                                         uint64_t* hi) {
+  const auto* words = reinterpret_cast<const __m256i*>(packed);
+  const size_t reach = width > 64 ? 2 : 1;
+  const __m256i low_mask =
+      _mm256_set1_epi64x(static_cast<int64_t>(LowMask(std::min(width, 64))));
+  const __m256i high_mask = _mm256_set1_epi64x(
+      static_cast<int64_t>(width > 64 ? LowMask(width - 64) : 0));
+  size_t row = 0;
+  for (; row < rows; ++row) {
+    const size_t bit = row * static_cast<size_t>(width);
+    const size_t q = bit / 64;
+    if (q + reach >= lane_words) break;
+    // A left shift by 64 gives zero, as needed when the row starts a word.
+    const __m128i right = _mm_cvtsi32_si128(static_cast<int>(bit % 64));
+    const __m128i left = _mm_cvtsi32_si128(static_cast<int>(64 - bit % 64));
+    const __m256i a = _mm256_loadu_si256(words + q);
+    const __m256i b = _mm256_loadu_si256(words + q + 1);
+    const __m256i low =
+        _mm256_or_si256(_mm256_srl_epi64(a, right), _mm256_sll_epi64(b, left));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lo + kLanes * row),
+                        _mm256_and_si256(low, low_mask));
+    if (width > 64) {
+      const __m256i c = _mm256_loadu_si256(words + q + 2);
+      const __m256i high = _mm256_or_si256(_mm256_srl_epi64(b, right),
+                                           _mm256_sll_epi64(c, left));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(hi + kLanes * row),
+                          _mm256_and_si256(high, high_mask));
+    }
+  }
+  return row;
+}
+
+#endif  // ABSL_INT128_DELTA_AVX2
+
+// The layout has four lanes of 64-bit words, which is one AVX2 vector, so the
+// AVX-512 level uses the AVX2 unpacker too.
+size_t UnpackVector(const uint8_t* packed, size_t lane_words, int width,
+                    size_t rows, uint64_t* lo, uint64_t* hi) {
+#if ABSL_INT128_DELTA_AVX2
+  if (int128_t_internal::ActiveKernelLevel() !=
+      int128_t_internal::KernelLevel::kPortable) {
+    return Unpack256(packed, lane_words, width, rows, lo, hi);
+  }
+#endif  // ABSL_INT128_DELTA_AVX2
+  static_cast<void>(packed);
+  static_cast<void>(lane_words);
+  static_cast<void>(width);
+  static_cast<void>(rows);
+  static_cast<void>(lo);
+  static_cast<void>(hi);
+  return 0;
+}
+
+template <typename T>
+size_t Encode(const T* values, size_t n, uint8_t* out) {
+  assert(n >= 1 && n <= kDeltaBlockSize);
+  uint128_t deltas[kDeltaBlockSize];
+  int128_t min = 0;
+  int128_t max = 0;
+  for (size_t i = 0; i + 1 < n; ++i) {
+    deltas[i] = static_cast<uint128_t>(values[i + 1]) -
+                static_cast<uint128_t>(values[i]);
+    const int128_t d = static_cast<int128_t>(deltas[i]);
+    if (i == 0 || d < min) min = d;
+    if (i == 0 || d > max) max = d;
+  }
+  const uint128_t reference = static_cast<uint128_t>(min);
+  const int width = BitWidth(static_cast<uint128_t>(max) - reference);
+  Store64(out, static_cast<uint64_t>(width) | static_cast<uint64_t>(n) << 8);
+  StoreLE128(out + 8, static_cast<uint128_t>(values[0]));
+  StoreLE128(out + 24, reference);
+
+  const size_t words = kLanes * LaneWords(n, width);
+  uint64_t packed[kLanes * 2 * Rows(kDeltaBlockSize)] = {};
+  for (size_t i = 0; width != 0 && i + 1 < n; ++i) {
+    const uint128_t r = deltas[i] - reference;
+    const size_t bit = i / kLanes * static_cast<size_t>(width);
+    const int s = static_cast<int>(bit % 64);
+    uint64_t* w = packed + bit / 64 * kLanes + i % kLanes;
+    const uint64_t low = Uint128Low64(r);
+    const uint64_t high = Uint128High64(r);
+    w[0] |= low << s;
+    if (s != 0 && s + width > 64) w[kLanes] |= low >> (64 - s);
+    if (width > 64) {
+      w[kLanes] |= high << s;
+      if (s != 0 && s + width > 128) w[2 * kLanes] |= high >> (64 - s);
+    }
+  }
+  for (size_t k = 0; k < words; ++k) {
+    Store64(out + kHeaderBytes + 8 * k, packed[k]);
+  }
+  return kHeaderBytes + 8 * words;
+}
+
+template <typename T>
+void Decode(const uint8_t* block, T* out) {
+  const uint64_t header = Load64(block);
+  const int width = static_cast<int>(header & 0xff);
+  const size_t n = static_cast<size_t>(header >> 8 & 0xff);
+  const uint128_t reference = LoadLE128(block + 24);
+  uint128_t v = LoadLE128(block + 8);
+  out[0] = static_cast<T>(v);
+  if (width == 0) {
+    for (size_t i = 1; i < n; ++i) out[i] = static_cast<T>(v += reference);
+    return;
+  }
+
+  const uint8_t* packed = block + kHeaderBytes;
+  const size_t rows = Rows(n);
+  uint64_t lo[kDeltaBlockSize];
+  uint64_t hi[kDeltaBlockSize];
+  size_t row = UnpackVector(packed, LaneWords(n, width), width, rows, lo, hi);
+  for (; row < rows; ++row) {
+    UnpackRow(packed, width, row, lo + kLanes * row, hi + kLanes * row);
+  }
+  if (width <= 64) {
+    for (size_t i = 1; i < n; ++i) {
+      v += reference + lo[i - 1];
+      out[i] = static_cast<T>(v);
+    }
+  } else {
+    for (size_t i = 1; i < n; ++i) {
+      v += reference + MakeUint128(hi[i - 1], lo[i - 1]);
+      out[i] = static_cast<T>(v);
+    }
+  }
+}
+
+}  // namespace
+
+size_t EncodeDeltaBlock(const uint128_t* values, size_t n, uint8_t* out) {
+  return Encode(values, n, out);
+}
+
+size_t EncodeDeltaBlock(const int128_t* values, size_t n, uint8_t* out) {
+  return Encode(values, n, out);
+}
+
+size_t DeltaBlockBytes(const uint8_t* block, size_t size, size_t* n) {
+  if (size < kHeaderBytes) return 0;
+  const uint64_t header = Load64(block);
+  const int width = static_cast<int>(header & 0xff);
+  const size_t count = static_cast<size_t>(header >> 8 & 0xff);
+  if (header >> 16 != 0 || width > 128 || count == 0 ||
+      count > kDeltaBlockSize) {
+    return 0;
+  }
+  const size_t bytes = kHeaderBytes + 8 * kLanes * LaneWords(count, width);
+  if (bytes > size) return 0;
+  *n = count;
+  return bytes;
+}
+
+void DecodeDeltaBlock(const uint8_t* block, uint128_t* out) {
+  Decode(block, out);
+}
+
+void DecodeDeltaBlock(const uint8_t* block, int128_t* out) {
+  Decode(block, out);
+}
+
+}  // namespace absl
@@ -0,0 +1,142 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_endian.h"
+
+#include <cstring>
+
+#include "int128_kernels.h"
+
+// The bulk byte swap has an AVX2 kernel, selected at the vector kernel level.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ABSL_INT128_ENDIAN_AVX2 1
+#include <immintrin.h>
+#define ABSL_INT128_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ABSL_INT128_ENDIAN_AVX2 0
+#endif
+
+namespace absl {
+
+namespace {
+
+#if ABSL_INT128_ENDIAN_AVX2
+
+// Reverses the 16 bytes of two values per iteration and returns how many
+// values were processed.
+ABSL_INT128_TARGET_AVX2 size_t Byteswap256(void* dst, const void* src,
+                                           size_t n) {
+  const __m256i reverse =
+      _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                       15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  auto* out = static_cast<__m256i*>(dst);
+  const auto* in = static_cast<const __m256i*>(src);
+  const size_t vectors = n / 2;
+  for (size_t i = 0; i < vectors; ++i) {
+    const __m256i v = _mm256_loadu_si256(in + i);
+    _mm256_storeu_si256(out + i, _mm256_shuffle_epi8(v, reverse));
+  }
+  return vectors * 2;
+}
+
+#endif  // ABSL_INT128_ENDIAN_AVX2
+
+// A 512-bit byte shuffle needs AVX512BW, which kAvx512 does not imply, so
+// both vector levels use the AVX2 kernel.
+size_t ByteswapVector(void* dst, const void* src, size_t n) {
+#if ABSL_INT128_ENDIAN_AVX2
+  switch (int128_t_internal::ActiveKernelLevel()) {
+    case int128_t_internal::KernelLevel::kAvx512:
+    case int128_t_internal::KernelLevel::kAvx2:
+      return Byteswap256(dst, src, n);
+    case int128_t_internal::KernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_ENDIAN_AVX2
+  static_cast<void>(dst);
+  static_cast<void>(src);
+  static_cast<void>(n);
+  return 0;
+}
+
+// Reverses the bytes of `n` 16-byte values.
+void ByteswapValues(void* dst, const void* src, size_t n) {
+  auto* out = static_cast<unsigned char*>(dst);
+  const auto* in = static_cast<const unsigned char*>(src);
+  for (size_t i = ByteswapVector(dst, src, n); i < n; ++i) {
+    StoreBE128(out + 16 * i, LoadLE128(in + 16 * i));
+  }
+}
+
+// A uint128_t or int128_t is stored in host byte order, so converting between
+// an array and a buffer in that order is a copy, and in the other a swap.
+void ConvertLittleEndian(void* dst, const void* src, size_t n) {
+#if defined(ABSL_IS_LITTLE_ENDIAN)
+  if (dst != src && n != 0) std::memcpy(dst, src, 16 * n);
+#else
+  ByteswapValues(dst, src, n);
+#endif
+}
+
+void ConvertBigEndian(void* dst, const void* src, size_t n) {
+#if defined(ABSL_IS_BIG_ENDIAN)
+  if (dst != src && n != 0) std::memcpy(dst, src, 16 * n);
+#else
+  ByteswapValues(dst, src, n);
+#endif
+}
+
+}  // namespace
+
+void LoadLE128N(uint128_t* dst, const void* src, size_t n) {
+  ConvertLittleEndian(dst, src, n);
+}
+
+void LoadLE128N(int128_t* dst, const void* src, size_t n) {
+  ConvertLittleEndian(dst, src, n);
+}
+
+void LoadBE128N(uint128_t* dst, const void* src, size_t n) {
+  ConvertBigEndian(dst, src, n);
+}
+
+void LoadBE128N(int128_t* dst, const void* src, size_t n) {
+  ConvertBigEndian(dst, src, n);
+}
+
+void StoreLE128N(void* dst, const uint128_t* src, size_t n) {
+  ConvertLittleEndian(dst, src, n);
+}
+
+void StoreLE128N(void* dst, const int128_t* src, size_t n) {
+  ConvertLittleEndian(dst, src, n);
+}
+
+void StoreBE128N(void* dst, const uint128_t* src, size_t n) {
+  ConvertBigEndian(dst, src, n);
+}
+
+void StoreBE128N(void* dst, const int128_t* src, size_t n) {
+  ConvertBigEndian(dst, src, n);
+}
+
+void ByteswapN(uint128_t* dst, const uint128_t* src, size_t n) {
+  ByteswapValues(dst, src, n);
+}
+
+void ByteswapN(int128_t* dst, const int128_t* src, size_t n) {
+  ByteswapValues(dst, src, n);
+}
+
+}  // namespace absl
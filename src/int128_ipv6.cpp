@@ -0,0 +1,437 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_ipv6.h"
+
+#include <cstring>
+
+#include "int128_endian.h"
+#include "int128_kernels.h"
+
+// SSE2 finds the digits and colons of a whole address with a few compares.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ABSL_INT128_IPV6_SSE2 1
+#include <emmintrin.h>
+#else
+#define ABSL_INT128_IPV6_SSE2 0
+#endif
+
+namespace absl {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+// Returns the value of hex digit `c`, or -1.
+inline int HexDigit(char c) {
+  const unsigned digit = static_cast<unsigned char>(c) - unsigned{'0'};
+  if (digit < 10) return static_cast<int>(digit);
+  const unsigned letter = (static_cast<unsigned char>(c) | 0x20u) - 'a';
+  return letter < 6 ? static_cast<int>(letter) + 10 : -1;
+}
+
+inline const char* Find(const char* p, const char* end, char c) {
+  return p == end ? nullptr
+                  : static_cast<const char*>(
+                        std::memchr(p, c, static_cast<size_t>(end - p)));
+}
+
+// Parses a dotted-quad IPv4 address that spans all of `[p, end)`. As in
+// `inet_pton()`, each part is a decimal number up to 255 without leading
+// zeros.
+bool ParseIpv4(const char* p, const char* end, uint32_t* value) {
+  uint32_t result = 0;
+  for (int part = 0; part < 4; ++part) {
+    if (part != 0) {
+      if (p == end || *p != '.') return false;
+      ++p;
+    }
+    const char* start = p;
+    uint32_t octet = 0;
+    for (; p != end && p - start < 3; ++p) {
+      const unsigned digit = static_cast<unsigned char>(*p) - unsigned{'0'};
+      if (digit >= 10) break;
+      octet = 10 * octet + digit;
+    }
+    if (p == start || octet > 255 || (p - start > 1 && *start == '0')) {
+      return false;
+    }
+    result = result << 8 | octet;
+  }
+  *value = result;
+  return p == end;
+}
+
+// Parses `[p, end)`, which holds no zone ID, one character at a time. Groups
+// are collected in order, and those after a "::" are moved to the end once
+// their number is known. This handles every form, but takes a poorly
+// predicted branch at the end of each group.
+bool ParseGroups(const char* p, const char* end, uint128_t* value) {
+  uint32_t groups[8];
+  int count = 0;
+  int gap = -1;
+  if (p != end && *p == ':') {
+    if (end - p < 2 || p[1] != ':') return false;
+    p += 2;
+    gap = 0;
+  }
+  while (p != end) {
+    if (count == 8) return false;
+    const char* start = p;
+    uint32_t group = 0;
+    for (int digit; p != end && p - start < 5 && (digit = HexDigit(*p)) >= 0;
+         ++p) {
+      group = group << 4 | static_cast<uint32_t>(digit);
+    }
+    if (p != end && *p == '.') {
+      // A trailing IPv4 address fills the last two groups.
+      uint32_t ipv4;
+      if (count > 6 || !ParseIpv4(start, end, &ipv4)) return false;
+      groups[count++] = ipv4 >> 16;
+      groups[count++] = ipv4 & 0xffff;
+      break;
+    }
+    if (p == start || p - start > 4) return false;
+    groups[count++] = group;
+    if (p == end) break;
+    if (*p != ':' || ++p == end) return false;
+    if (*p == ':') {
+      if (gap >= 0) return false;
+      gap = count;
+      ++p;
+    }
+  }
+  if (gap < 0 ? count != 8 : count == 8) return false;
+
+  uint64_t halves[2] = {0, 0};
+  for (int i = 0; i < count; ++i) {
+    const int position = gap < 0 || i < gap ? i : 8 - count + i;
+    halves[position / 4] |= uint64_t{groups[i]} << (48 - 16 * (position % 4));
+  }
+  *value = MakeUint128(halves[0], halves[1]);
+  return true;
+}
+
+// The longest text of an address without a zone ID, as in
+// "0000:0000:0000:0000:0000:0000:255.255.255.255".
+constexpr size_t kMaxTextLength = 45;
+
+// The number of bytes from the start of an address that a parse may read.
+constexpr size_t kReadBytes = 56;
+
+enum CharClass : uint8_t { kOther = 0, kHex = 1, kColon = 2, kDot = 4 };
+
+struct ClassTable {
+  uint8_t classes[256];
+
+  constexpr ClassTable() : classes() {
+    for (int c = 0; c < 256; ++c) {
+      classes[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+                           (c >= 'A' && c <= 'F')
+                       ? kHex
+                   : c == ':' ? kColon
+                   : c == '.' ? kDot
+                              : kOther;
+    }
+  }
+};
+
+constexpr ClassTable kClassTable;
+
+inline uint64_t LowMask(size_t bits) {
+  return bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+}
+
+// The masks of the positions of hex digits, colons and dots in a text.
+struct CharMasks {
+  uint64_t hex;
+  uint64_t colon;
+  uint64_t dot;
+};
+
+// Classifies the `size` bytes at `text` one at a time.
+inline CharMasks ClassifyPortable(const uint8_t* text, size_t size) {
+  CharMasks masks = {0, 0, 0};
+  for (size_t i = 0; i < size; ++i) {
+    const uint8_t c = kClassTable.classes[text[i]];
+    masks.hex |= static_cast<uint64_t>(c & kHex) << i;
+    masks.colon |= static_cast<uint64_t>(c >> 1 & 1) << i;
+    masks.dot |= static_cast<uint64_t>(c >> 2 & 1) << i;
+  }
+  return masks;
+}
+
+#if ABSL_INT128_IPV6_SSE2
+
+// Classifies the 48 bytes at `text` 16 at a time. Bytes at or above 0x80
+// compare as negative, so they fail the range checks.
+inline CharMasks ClassifySse2(const uint8_t* text) {
+  CharMasks masks = {0, 0, 0};
+  for (int i = 0; i < 3; ++i) {
+    const __m128i c =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + 16 * i));
+    const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    const __m128i decimal =
+        _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+    const __m128i letter =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+    const int shift = 16 * i;
+    masks.hex |= static_cast<uint64_t>(_mm_movemask_epi8(
+                     _mm_or_si128(decimal, letter)))
+                 << shift;
+    masks.colon |= static_cast<uint64_t>(_mm_movemask_epi8(
+                       _mm_cmpeq_epi8(c, _mm_set1_epi8(':'))))
+                   << shift;
+    masks.dot |= static_cast<uint64_t>(_mm_movemask_epi8(
+                     _mm_cmpeq_epi8(c, _mm_set1_epi8('.'))))
+                 << shift;
+  }
+  return masks;
+}
+
+#endif  // ABSL_INT128_IPV6_SSE2
+
+// Returns masks whose bits past `size` are unspecified.
+inline CharMasks Classify(const uint8_t* text, size_t size) {
+#if ABSL_INT128_IPV6_SSE2
+  if (int128_t_internal::ActiveKernelLevel() !=
+      int128_t_internal::KernelLevel::kPortable) {
+    return ClassifySse2(text);
+  }
+#endif  // ABSL_INT128_IPV6_SSE2
+  return ClassifyPortable(text, size);
+}
+
+// Parses `[p, end)`, which holds no zone ID, from bitmasks of the positions
+// of hex digits and colons: group boundaries and the "::" are found with
+// bit operations, and each group is converted from one 8-byte load, so no
+// branch depends on the lengths of the groups. Falls back to
+// `ParseGroups()` for a trailing IPv4 address.
+//
+// The masks cover 48 bytes, and a group's load may reach 8 bytes past its
+// start, so the text is read in place if `limit` allows 56 bytes, and from a
+// padded copy otherwise.
+bool ParseAddress(const char* p, const char* end, const char* limit,
+                  uint128_t* value) {
+  const size_t size = static_cast<size_t>(end - p);
+  if (size > kMaxTextLength) return false;
+  uint8_t copy[kReadBytes] = {};
+  const uint8_t* text = reinterpret_cast<const uint8_t*>(p);
+  if (static_cast<size_t>(limit - p) < kReadBytes) {
+    std::memcpy(copy, p, size);
+    text = copy;
+  }
+  const CharMasks masks = Classify(text, size);
+  const uint64_t hex = masks.hex & LowMask(size);
+  const uint64_t colon = masks.colon & LowMask(size);
+  if ((masks.dot & LowMask(size)) != 0) return ParseGroups(p, end, value);
+  if ((hex | colon) != LowMask(size) || size < 2) return false;
+
+  // A "::" is a pair of colons; there may be one, not within ":::". Any
+  // other colon lies between two digits.
+  const uint64_t pair = colon & (colon >> 1);
+  const uint64_t single = colon & ~(pair | (pair << 1));
+  const uint64_t starts = hex & ~(hex << 1);
+  const uint64_t ends = hex & ~(hex >> 1);
+  if ((pair & (pair - 1)) != 0 ||
+      (single & ~((ends << 1) & (starts >> 1))) != 0) {
+    return false;
+  }
+
+  // Groups are collected in order, and those after the "::" moved to the
+  // end once their number is known.
+  uint32_t groups[8] = {};
+  int count = 0;
+  int before_pair = 0;
+  for (uint64_t next_starts = starts, next_ends = ends; next_starts != 0;
+       next_starts &= next_starts - 1, next_ends &= next_ends - 1) {
+    const int start = int128_t_internal::CountTrailingZeros64(next_starts);
+    const int length =
+        int128_t_internal::CountTrailingZeros64(next_ends) - start + 1;
+    if (count == 8 || length > 4) return false;
+    // Digit values in the low `length` bytes, first digit lowest, moved up
+    // so that the last digit is in byte 3.
+    const uint64_t chars = int128_t_internal::LittleEndian64(
+        int128_t_internal::LoadHost64(text + start));
+    uint64_t digits =
+        (chars & 0x0f0f0f0fu) + 9 * (chars >> 6 & 0x01010101u);
+    digits = (digits & LowMask(8 * static_cast<size_t>(length)))
+             << (8 * (4 - length));
+    groups[count++] =
+        static_cast<uint32_t>((digits & 0xf) << 12 | (digits >> 8 & 0xf) << 8 |
+                              (digits >> 16 & 0xf) << 4 | (digits >> 24 & 0xf));
+    before_pair += (uint64_t{1} << start) < pair;
+  }
+  if (pair == 0 ? count != 8 : count == 8) return false;
+  for (int i = count - 1; pair != 0 && i >= before_pair; --i) {
+    groups[8 - count + i] = groups[i];
+    groups[i] = 0;
+  }
+  *value = MakeUint128(
+      uint64_t{groups[0]} << 48 | uint64_t{groups[1]} << 32 |
+          uint64_t{groups[2]} << 16 | groups[3],
+      uint64_t{groups[4]} << 48 | uint64_t{groups[5]} << 32 |
+          uint64_t{groups[6]} << 16 | groups[7]);
+  return true;
+}
+
+// Parses `[p, end)` as `int128_t_internal::ParseIpv6()` does, reading no
+// byte at or past `limit`.
+bool ParseWithin(const char* p, const char* end, const char* limit,
+                 uint128_t* value, const char** zone) {
+  const char* percent = Find(p, end, '%');
+  if (percent == nullptr) {
+    *zone = end;
+    return ParseAddress(p, end, limit, value);
+  }
+  // The zone ID may be anything but empty.
+  *zone = percent + 1;
+  return percent + 1 != end && ParseAddress(p, percent, limit, value);
+}
+
+// Writes `group` in hex without leading zeros. All four bytes at `out` are
+// written, however many digits there are.
+inline char* WriteGroup(uint32_t group, char* out) {
+  const int bits = 64 - int128_t_internal::CountLeadingZeros64(group | 1);
+  const int digits = (bits + 3) / 4;
+  // The digits, first in the lowest byte, then '0' + d or 'a' + d - 10.
+  uint32_t nibbles = (group >> 12 & 0xf) | (group >> 8 & 0xf) << 8 |
+                     (group >> 4 & 0xf) << 16 | (group & 0xf) << 24;
+  nibbles >>= 8 * (4 - digits);
+  const uint32_t chars = nibbles + 0x30303030u +
+                         0x27 * ((nibbles + 0x06060606u) >> 4 & 0x01010101u);
+  for (int i = 0; i < 4; ++i) out[i] = static_cast<char>(chars >> (8 * i));
+  return out + digits;
+}
+
+inline char* WriteOctet(uint32_t octet, char* out) {
+  if (octet >= 100) {
+    *out++ = static_cast<char>('0' + octet / 100);
+    *out++ = static_cast<char>('0' + octet / 10 % 10);
+  } else if (octet >= 10) {
+    *out++ = static_cast<char>('0' + octet / 10);
+  }
+  *out++ = static_cast<char>('0' + octet % 10);
+  return out;
+}
+
+inline uint128_t ToValue(uint128_t v) { return v; }
+inline uint128_t ToValue(Ipv6Address v) { return v.value(); }
+inline void FromValue(uint128_t v, uint128_t* out) { *out = v; }
+inline void FromValue(uint128_t v, Ipv6Address* out) { *out = Ipv6Address(v); }
+
+template <typename T>
+const char* ParseN(const char* p, const char* end, char separator, T* values,
+                   size_t n) {
+  uint128_t v;
+  const char* zone;
+  for (size_t i = 0; i < n; ++i) {
+    const char* next = Find(p, end, separator);
+    if (!ParseWithin(p, next == nullptr ? end : next, end, &v, &zone)) {
+      return nullptr;
+    }
+    FromValue(v, values + i);
+    p = next == nullptr ? end : next + 1;
+  }
+  return p;
+}
+
+template <typename T>
+char* FormatN(const T* values, size_t n, char separator, char* out) {
+  for (size_t i = 0; i < n; ++i) {
+    out += int128_t_internal::FormatIpv6(ToValue(values[i]), out);
+    *out++ = separator;
+  }
+  return out;
+}
+
+}  // namespace
+
+namespace int128_t_internal {
+
+bool ParseIpv6(const char* p, const char* end, uint128_t* value,
+               const char** zone) {
+  return ParseWithin(p, end, end, value, zone);
+}
+
+size_t FormatIpv6(uint128_t value, char* out) {
+  const uint64_t high = Uint128High64(value);
+  const uint64_t low = Uint128Low64(value);
+  char* p = out;
+  if (high == 0 && low >> 32 == 0xffff) {
+    std::memcpy(p, "::ffff:", 7);
+    p += 7;
+    for (int i = 3; i >= 0; --i) {
+      p = WriteOctet(static_cast<uint32_t>(low >> (8 * i) & 0xff), p);
+      if (i != 0) *p++ = '.';
+    }
+    return static_cast<size_t>(p - out);
+  }
+
+  uint32_t groups[8];
+  uint32_t zeros = 0;
+  for (int i = 0; i < 8; ++i) {
+    groups[i] = static_cast<uint32_t>((i < 4 ? high : low) >>
+                                      (48 - 16 * (i % 4)) & 0xffff);
+    zeros |= static_cast<uint32_t>(groups[i] == 0) << i;
+  }
+  // Bit i of `runs` is set while groups i to i + run_length - 1 are zero, so
+  // the last nonzero value marks the first of the longest runs.
+  int run = -1;
+  int run_length = 0;
+  for (uint32_t runs = zeros; runs != 0; runs &= runs >> 1) {
+    run = int128_t_internal::CountTrailingZeros64(runs);
+    ++run_length;
+  }
+  if (run_length < 2) run = -1;
+  // Each group is followed by a colon but the last; the compressed run adds
+  // one more, or two at the start.
+  for (int i = 0; i < 8; ++i) {
+    if (i == run) {
+      if (i == 0) *p++ = ':';
+      *p++ = ':';
+      i += run_length - 1;
+      continue;
+    }
+    p = WriteGroup(groups[i], p);
+    if (i != 7) *p++ = ':';
+  }
+  return static_cast<size_t>(p - out);
+}
+
+}  // namespace int128_t_internal
+
+const char* ParseIpv6Addresses(const char* p, const char* end, char separator,
+                               uint128_t* values, size_t n) {
+  return ParseN(p, end, separator, values, n);
+}
+
+const char* ParseIpv6Addresses(const char* p, const char* end, char separator,
+                               Ipv6Address* values, size_t n) {
+  return ParseN(p, end, separator, values, n);
+}
+
+char* FormatIpv6Addresses(const uint128_t* values, size_t n, char separator,
+                          char* out) {
+  return FormatN(values, n, separator, out);
+}
+
+char* FormatIpv6Addresses(const Ipv6Address* values, size_t n, char separator,
+                          char* out) {
+  return FormatN(values, n, separator, out);
+}
+
+}  // namespace absl
@@ -0,0 +1,1381 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_kernels.h"
+
+#include <stddef.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "int128_parallel.h"
+
+// The vector and multiply kernels are compiled with per-function target
+// attributes, so the library itself needs no -mavx2, -mavx512f or -mbmi2 and
+// still runs on any x86-64.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && \
+    defined(ABSL_IS_LITTLE_ENDIAN)
+#define ABSL_INT128_X86_KERNELS 1
+#include <cpuid.h>
+#include <immintrin.h>
+#define ABSL_INT128_TARGET_AVX2 __attribute__((target("avx2")))
+#define ABSL_INT128_TARGET_AVX512 __attribute__((target("avx512f")))
+#define ABSL_INT128_TARGET_BMI2 __attribute__((target("bmi2")))
+#define ABSL_INT128_TARGET_ADX __attribute__((target("bmi2,adx")))
+#else
+#define ABSL_INT128_X86_KERNELS 0
+#endif
+
+namespace absl {
+
+namespace int128_t_internal {
+
+namespace {
+
+KernelLevel Detect() {
+#if ABSL_INT128_X86_KERNELS
+  // __builtin_cpu_supports also checks that the OS saves the vector state.
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return KernelLevel::kAvx512;
+  if (__builtin_cpu_supports("avx2")) return KernelLevel::kAvx2;
+#endif  // ABSL_INT128_X86_KERNELS
+  return KernelLevel::kPortable;
+}
+
+std::atomic<KernelLevel>& Level() {
+  static std::atomic<KernelLevel> level{DetectedKernelLevel()};
+  return level;
+}
+
+MulKernelLevel DetectMul() {
+#if ABSL_INT128_X86_KERNELS
+  // BMI2 and ADX are bits 8 and 19 of EBX in leaf 7, and need no OS support.
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx >> 8 & 1)) {
+    return ebx >> 19 & 1 ? MulKernelLevel::kBmi2Adx : MulKernelLevel::kBmi2;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  return MulKernelLevel::kPortable;
+}
+
+std::atomic<MulKernelLevel>& MulLevel() {
+  static std::atomic<MulKernelLevel> level{DetectedMulKernelLevel()};
+  return level;
+}
+
+}  // namespace
+
+KernelLevel DetectedKernelLevel() {
+  static const KernelLevel level = Detect();
+  return level;
+}
+
+KernelLevel ActiveKernelLevel() {
+  return Level().load(std::memory_order_relaxed);
+}
+
+void SetKernelLevel(KernelLevel level) {
+  const KernelLevel detected = DetectedKernelLevel();
+  Level().store(level < detected ? level : detected,
+                std::memory_order_relaxed);
+}
+
+MulKernelLevel DetectedMulKernelLevel() {
+  static const MulKernelLevel level = DetectMul();
+  return level;
+}
+
+MulKernelLevel ActiveMulKernelLevel() {
+  return MulLevel().load(std::memory_order_relaxed);
+}
+
+void SetMulKernelLevel(MulKernelLevel level) {
+  const MulKernelLevel detected = DetectedMulKernelLevel();
+  MulLevel().store(level < detected ? level : detected,
+                   std::memory_order_relaxed);
+}
+
+bool UsePdep() {
+#if ABSL_INT128_X86_KERNELS
+  // pext and pdep are slower there than the portable shifts.
+  static const bool fast_pdep = [] {
+    __builtin_cpu_init();
+    return !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+  }();
+  return fast_pdep && ActiveMulKernelLevel() != MulKernelLevel::kPortable;
+#else
+  return false;
+#endif  // ABSL_INT128_X86_KERNELS
+}
+
+}  // namespace int128_t_internal
+
+namespace {
+
+using int128_t_internal::KernelLevel;
+using int128_t_internal::MulKernelLevel;
+
+#if ABSL_INT128_X86_KERNELS
+
+// Each vector holds whole 128-bit values as (low, high) pairs of 64-bit lanes.
+// The low lanes are added with plain 64-bit adds and the carry out of each
+// low lane is then propagated into the high lane next to it.
+
+// AVX2 has no unsigned 64-bit compare, so carries are detected with a signed
+// compare after flipping the sign bits. The resulting all-ones mask in a low
+// lane is moved into the high lane with a byte shift within each 128-bit
+// half and subtracted, adding one.
+ABSL_INT128_TARGET_AVX2 inline __m256i Add256(__m256i a, __m256i b) {
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i sum = _mm256_add_epi64(a, b);
+  const __m256i carry = _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign),
+                                           _mm256_xor_si256(sum, sign));
+  return _mm256_sub_epi64(sum, _mm256_slli_si256(carry, 8));
+}
+
+ABSL_INT128_TARGET_AVX2 inline __m256i Sub256(__m256i a, __m256i b) {
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i borrow = _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign),
+                                            _mm256_xor_si256(a, sign));
+  return _mm256_add_epi64(_mm256_sub_epi64(a, b),
+                          _mm256_slli_si256(borrow, 8));
+}
+
+// AVX-512 compares straight into a mask register (vpcmpuq). Shifting the mask
+// left by one moves each low lane's carry onto its high lane, and a masked add
+// applies it.
+constexpr __mmask8 kHighLanes = 0xaa;
+
+ABSL_INT128_TARGET_AVX512 inline __m512i Add512(__m512i a, __m512i b) {
+  const __m512i sum = _mm512_add_epi64(a, b);
+  const __mmask8 carry = static_cast<__mmask8>(
+      (_mm512_cmplt_epu64_mask(sum, a) << 1) & kHighLanes);
+  return _mm512_mask_add_epi64(sum, carry, sum, _mm512_set1_epi64(1));
+}
+
+ABSL_INT128_TARGET_AVX512 inline __m512i Sub512(__m512i a, __m512i b) {
+  const __m512i diff = _mm512_sub_epi64(a, b);
+  const __mmask8 borrow = static_cast<__mmask8>(
+      (_mm512_cmplt_epu64_mask(a, b) << 1) & kHighLanes);
+  return _mm512_mask_sub_epi64(diff, borrow, diff, _mm512_set1_epi64(1));
+}
+
+struct AddOp {
+  ABSL_INT128_TARGET_AVX2 static __m256i Apply(__m256i a, __m256i b) {
+    return Add256(a, b);
+  }
+  ABSL_INT128_TARGET_AVX512 static __m512i Apply(__m512i a, __m512i b) {
+    return Add512(a, b);
+  }
+};
+
+struct SubOp {
+  ABSL_INT128_TARGET_AVX2 static __m256i Apply(__m256i a, __m256i b) {
+    return Sub256(a, b);
+  }
+  ABSL_INT128_TARGET_AVX512 static __m512i Apply(__m512i a, __m512i b) {
+    return Sub512(a, b);
+  }
+};
+
+// Computes b - a, so that negation is a broadcast of zero.
+struct ReverseSubOp {
+  ABSL_INT128_TARGET_AVX2 static __m256i Apply(__m256i a, __m256i b) {
+    return Sub256(b, a);
+  }
+  ABSL_INT128_TARGET_AVX512 static __m512i Apply(__m512i a, __m512i b) {
+    return Sub512(b, a);
+  }
+};
+
+// Applies `Op` to two values per iteration and returns how many values were
+// processed. With `kBroadcast`, `b` points to a single value used for every
+// element.
+template <typename Op, bool kBroadcast>
+ABSL_INT128_TARGET_AVX2 size_t Run256(void* dst, const void* a, const void* b,
+                                      size_t n) {
+  auto* out = static_cast<__m256i*>(dst);
+  const auto* in_a = static_cast<const __m256i*>(a);
+  const auto* in_b = static_cast<const __m256i*>(b);
+  const __m256i scalar =
+      kBroadcast ? _mm256_broadcastsi128_si256(
+                       _mm_loadu_si128(static_cast<const __m128i*>(b)))
+                 : _mm256_setzero_si256();
+  const size_t vectors = n / 2;
+  for (size_t i = 0; i < vectors; ++i) {
+    const __m256i rhs = kBroadcast ? scalar : _mm256_loadu_si256(in_b + i);
+    _mm256_storeu_si256(out + i, Op::Apply(_mm256_loadu_si256(in_a + i), rhs));
+  }
+  return vectors * 2;
+}
+
+template <typename Op, bool kBroadcast>
+ABSL_INT128_TARGET_AVX512 size_t Run512(void* dst, const void* a,
+                                        const void* b, size_t n) {
+  auto* out = static_cast<__m512i*>(dst);
+  const auto* in_a = static_cast<const __m512i*>(a);
+  const auto* in_b = static_cast<const __m512i*>(b);
+  // The zero-masked broadcast, with every lane selected, because GCC's plain
+  // _mm512_broadcast_i32x4 starts from an undefined vector and so warns
+  // under -Wuninitialized.
+  const __m512i scalar =
+      kBroadcast ? _mm512_maskz_broadcast_i32x4(
+                       0xffff, _mm_loadu_si128(static_cast<const __m128i*>(b)))
+                 : _mm512_setzero_si512();
+  const size_t vectors = n / 4;
+  for (size_t i = 0; i < vectors; ++i) {
+    const __m512i rhs = kBroadcast ? scalar : _mm512_loadu_si512(in_b + i);
+    _mm512_storeu_si512(out + i, Op::Apply(_mm512_loadu_si512(in_a + i), rhs));
+  }
+  return vectors * 4;
+}
+
+#endif  // ABSL_INT128_X86_KERNELS
+
+// Runs the best available vector kernel over a prefix of the arrays and
+// returns its length. The caller finishes the remaining elements with the
+// scalar operators.
+template <typename Op, bool kBroadcast>
+size_t RunVector(void* dst, const void* a, const void* b, size_t n) {
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveKernelLevel()) {
+    case KernelLevel::kAvx512:
+      return Run512<Op, kBroadcast>(dst, a, b, n);
+    case KernelLevel::kAvx2:
+      return Run256<Op, kBroadcast>(dst, a, b, n);
+    case KernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  static_cast<void>(dst);
+  static_cast<void>(a);
+  static_cast<void>(b);
+  static_cast<void>(n);
+  return 0;
+}
+
+#if !ABSL_INT128_X86_KERNELS
+struct AddOp {};
+struct SubOp {};
+struct ReverseSubOp {};
+#endif  // !ABSL_INT128_X86_KERNELS
+
+template <typename T>
+void AddImpl(T* dst, const T* a, const T* b, size_t n) {
+  for (size_t i = RunVector<AddOp, false>(dst, a, b, n); i < n; ++i) {
+    dst[i] = a[i] + b[i];
+  }
+}
+
+template <typename T>
+void SubImpl(T* dst, const T* a, const T* b, size_t n) {
+  for (size_t i = RunVector<SubOp, false>(dst, a, b, n); i < n; ++i) {
+    dst[i] = a[i] - b[i];
+  }
+}
+
+template <typename T>
+void NegImpl(T* dst, const T* a, size_t n) {
+  const T zero = 0;
+  for (size_t i = RunVector<ReverseSubOp, true>(dst, a, &zero, n); i < n;
+       ++i) {
+    dst[i] = -a[i];
+  }
+}
+
+template <typename T>
+void AddScalarImpl(T* dst, const T* a, T b, size_t n) {
+  for (size_t i = RunVector<AddOp, true>(dst, a, &b, n); i < n; ++i) {
+    dst[i] = a[i] + b;
+  }
+}
+
+template <typename T>
+void SubScalarImpl(T* dst, const T* a, T b, size_t n) {
+  for (size_t i = RunVector<SubOp, true>(dst, a, &b, n); i < n; ++i) {
+    dst[i] = a[i] - b;
+  }
+}
+
+template <typename T>
+void HashImpl(uint64_t* out, const T* values, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint128_t v(values[i]);
+    out[i] = int128_t_internal::Hash128(Uint128High64(v), Uint128Low64(v));
+  }
+}
+
+// The multiply and divide loops are each written once, inline, and compiled
+// again with BMI2 enabled. Their 64x64->128 products then use mulx, which
+// takes its operands in any register and leaves the flags alone, and their
+// variable shifts shlx and shrx, which need no count in CL.
+
+// The portable operator* multiplies in 32-bit pieces so that it works in
+// constant expressions, so the loop spells out the one full product of the
+// low halves and the two cross products that reach the high half. The same
+// bits make the product of two int128_t values.
+template <typename T, bool kBroadcast>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline void MulLoop(T* dst, const T* a,
+                                                 const T* b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint128_t x(a[i]);
+    const uint128_t y(b[kBroadcast ? 0 : i]);
+    const uint128_t low =
+        int128_t_internal::Multiply64To128(Uint128Low64(x), Uint128Low64(y));
+    dst[i] = T(MakeUint128(Uint128High64(low) +
+                               Uint128Low64(x) * Uint128High64(y) +
+                               Uint128High64(x) * Uint128Low64(y),
+                           Uint128Low64(low)));
+  }
+}
+
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline void MulWideLoop(uint128_t* high,
+                                                     uint128_t* low,
+                                                     const uint128_t* a,
+                                                     const uint128_t* b,
+                                                     size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    uint128_t h;
+    const uint128_t l = int128_t_internal::Multiply128To256(a[i], b[i], &h);
+    high[i] = h;
+    low[i] = l;
+  }
+}
+
+// A 64-bit divisor and its reciprocal, which turn the division of a two-word
+// value by it into two multiplications (Moller and Granlund, "Improved
+// division by invariant integers", algorithm 4).
+struct Reciprocal64 {
+  explicit Reciprocal64(uint64_t d)
+      : shift(int128_t_internal::CountLeadingZeros64(d)),
+        divisor(d << shift),
+        inverse(Uint128Low64(Uint128Max() / divisor)) {}
+
+  // Returns the quotient of `high:low` by the normalized divisor, which must
+  // be greater than `high`, and stores the remainder in `*remainder`.
+  ABSL_ATTRIBUTE_ALWAYS_INLINE uint64_t Divide(uint64_t high, uint64_t low,
+                                               uint64_t* remainder) const {
+    const uint128_t q =
+        int128_t_internal::Multiply64To128(inverse, high) +
+        MakeUint128(high, low);
+    uint64_t quotient = Uint128High64(q) + 1;
+    uint64_t r = low - quotient * divisor;
+    // Taken about half the time, so done with a mask rather than a branch.
+    const uint64_t mask = uint64_t{0} - (r > Uint128Low64(q));
+    quotient += mask;
+    r += mask & divisor;
+    if (r >= divisor) {
+      ++quotient;
+      r -= divisor;
+    }
+    *remainder = r;
+    return quotient;
+  }
+
+  int shift;         // leading zeros of the divisor
+  uint64_t divisor;  // shifted left until its top bit is set
+  uint64_t inverse;  // floor((2^128 - 1) / divisor) - 2^64
+};
+
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline void DivModLoop(uint128_t* quotient,
+                                                    uint64_t* remainder,
+                                                    const uint128_t* a,
+                                                    const Reciprocal64& d,
+                                                    size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t high = Uint128High64(a[i]);
+    const uint64_t low = Uint128Low64(a[i]);
+    // The dividend is shifted left along with the divisor, into three words.
+    // Bits move right in two steps so that a zero shift needs no branch.
+    const uint64_t u2 = (high >> 1) >> (63 - d.shift);
+    const uint64_t u1 = high << d.shift | (low >> 1) >> (63 - d.shift);
+    const uint64_t u0 = low << d.shift;
+    uint64_t r;
+    const uint64_t q1 = d.Divide(u2, u1, &r);
+    const uint64_t q0 = d.Divide(r, u0, &r);
+    quotient[i] = MakeUint128(q1, q0);
+    remainder[i] = r >> d.shift;
+  }
+}
+
+#if ABSL_INT128_X86_KERNELS
+
+template <typename T, bool kBroadcast>
+ABSL_INT128_TARGET_BMI2 void MulBmi2(T* dst, const T* a, const T* b,
+                                     size_t n) {
+  MulLoop<T, kBroadcast>(dst, a, b, n);
+}
+
+ABSL_INT128_TARGET_BMI2 void MulWideBmi2(uint128_t* high, uint128_t* low,
+                                         const uint128_t* a,
+                                         const uint128_t* b, size_t n) {
+  MulWideLoop(high, low, a, b, n);
+}
+
+// Sums the partial products of `a[i]` and the low half of `b[i]` in the
+// carry flag chain (adcx) and those of the high half in the overflow flag
+// chain (adox), so that the two chains of additions can run side by side.
+// Compilers do not keep two flag chains apart on their own.
+ABSL_INT128_TARGET_ADX void MulWideAdx(uint128_t* high, uint128_t* low,
+                                       const uint128_t* a, const uint128_t* b,
+                                       size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t a0 = Uint128Low64(a[i]);
+    const uint64_t a1 = Uint128High64(a[i]);
+    const uint64_t b1 = Uint128High64(b[i]);
+    uint64_t rdx = Uint128Low64(b[i]);
+    uint64_t r0, r1, r2, r3, lo, hi, zero;
+    // The high half of a 64x64 product is at most 2^64 - 2, so adding a carry
+    // to it leaves the carry flag clear for the second multiplication.
+    __asm__(
+        "xorl %k[zero], %k[zero]\n\t"
+        "mulxq %[a0], %[r0], %[r1]\n\t"
+        "mulxq %[a1], %[lo], %[r2]\n\t"
+        "adcxq %[lo], %[r1]\n\t"
+        "adcxq %[zero], %[r2]\n\t"
+        "movq %[b1], %[rdx]\n\t"
+        "mulxq %[a0], %[lo], %[hi]\n\t"
+        "adoxq %[lo], %[r1]\n\t"
+        "adoxq %[hi], %[r2]\n\t"
+        "mulxq %[a1], %[lo], %[r3]\n\t"
+        "adcxq %[lo], %[r2]\n\t"
+        "adoxq %[zero], %[r3]\n\t"
+        "adcxq %[zero], %[r3]"
+        : [r0] "=&r"(r0), [r1] "=&r"(r1), [r2] "=&r"(r2), [r3] "=&r"(r3),
+          [lo] "=&r"(lo), [hi] "=&r"(hi), [zero] "=&r"(zero), [rdx] "+&d"(rdx)
+        : [a0] "r"(a0), [a1] "r"(a1), [b1] "r"(b1)
+        : "cc");
+    high[i] = MakeUint128(r3, r2);
+    low[i] = MakeUint128(r1, r0);
+  }
+}
+
+ABSL_INT128_TARGET_BMI2 void DivModBmi2(uint128_t* quotient,
+                                        uint64_t* remainder,
+                                        const uint128_t* a,
+                                        const Reciprocal64& d, size_t n) {
+  DivModLoop(quotient, remainder, a, d, n);
+}
+
+#endif  // ABSL_INT128_X86_KERNELS
+
+template <typename T, bool kBroadcast>
+void MulImpl(T* dst, const T* a, const T* b, size_t n) {
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveMulKernelLevel()) {
+    case MulKernelLevel::kBmi2Adx:
+    case MulKernelLevel::kBmi2:
+      return MulBmi2<T, kBroadcast>(dst, a, b, n);
+    case MulKernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  MulLoop<T, kBroadcast>(dst, a, b, n);
+}
+
+void MulWideImpl(uint128_t* high, uint128_t* low, const uint128_t* a,
+                 const uint128_t* b, size_t n) {
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveMulKernelLevel()) {
+    case MulKernelLevel::kBmi2Adx:
+      return MulWideAdx(high, low, a, b, n);
+    case MulKernelLevel::kBmi2:
+      return MulWideBmi2(high, low, a, b, n);
+    case MulKernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  MulWideLoop(high, low, a, b, n);
+}
+
+void DivModImpl(uint128_t* quotient, uint64_t* remainder, const uint128_t* a,
+                uint64_t divisor, size_t n) {
+  assert(divisor != 0);
+  const Reciprocal64 d(divisor);
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveMulKernelLevel()) {
+    case MulKernelLevel::kBmi2Adx:
+    case MulKernelLevel::kBmi2:
+      return DivModBmi2(quotient, remainder, a, d, n);
+    case MulKernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  DivModLoop(quotient, remainder, a, d, n);
+}
+
+// Filters reduce every predicate to a closed range test, lower <= x <= upper,
+// optionally inverted. Limbs are biased so that a signed 64-bit compare orders
+// them: the low limb always has its sign bit flipped, and the high limb too
+// for unsigned values. x is below the range when its high limb is smaller
+// than lower's, or equal with a smaller low limb, and likewise above it.
+constexpr uint64_t kSignBit = uint64_t{1} << 63;
+
+struct RangeFilter {
+  uint64_t hi_bias;
+  int64_t lower_hi;
+  int64_t lower_lo;
+  int64_t upper_hi;
+  int64_t upper_lo;
+  bool empty;
+  bool invert;
+};
+
+template <typename T>
+RangeFilter MakeRangeFilter(T lower, T upper, bool invert) {
+  RangeFilter f;
+  f.hi_bias = std::is_same<T, uint128_t>::value ? kSignBit : 0;
+  const uint128_t l(lower), u(upper);
+  f.lower_hi = static_cast<int64_t>(Uint128High64(l) ^ f.hi_bias);
+  f.lower_lo = static_cast<int64_t>(Uint128Low64(l) ^ kSignBit);
+  f.upper_hi = static_cast<int64_t>(Uint128High64(u) ^ f.hi_bias);
+  f.upper_lo = static_cast<int64_t>(Uint128Low64(u) ^ kSignBit);
+  f.empty = upper < lower;
+  f.invert = invert;
+  return f;
+}
+
+template <typename T>
+RangeFilter MakeCompareFilter(CompareOp op, T c) {
+  const T min = (std::numeric_limits<T>::min)();
+  const T max = (std::numeric_limits<T>::max)();
+  switch (op) {
+    case CompareOp::kEq:
+      return MakeRangeFilter(c, c, false);
+    case CompareOp::kNe:
+      return MakeRangeFilter(c, c, true);
+    case CompareOp::kLt:
+      return MakeRangeFilter(c, max, true);  // not c <= x
+    case CompareOp::kLe:
+      return MakeRangeFilter(min, c, false);
+    case CompareOp::kGt:
+      return MakeRangeFilter(min, c, true);  // not x <= c
+    case CompareOp::kGe:
+      return MakeRangeFilter(c, max, false);
+  }
+  assert(false);
+  return MakeRangeFilter(max, min, false);
+}
+
+// lower <= x < upper, as lower <= x <= upper - 1.
+template <typename T>
+RangeFilter MakeBetweenFilter(T lower, T upper) {
+  if (upper <= lower) {
+    RangeFilter f = MakeRangeFilter(lower, lower, false);
+    f.empty = true;
+    return f;
+  }
+  return MakeRangeFilter(lower, upper - 1, false);
+}
+
+inline bool InRange(const RangeFilter& f, uint64_t hi, uint64_t lo) {
+  const int64_t h = static_cast<int64_t>(hi ^ f.hi_bias);
+  const int64_t l = static_cast<int64_t>(lo ^ kSignBit);
+  const bool below = h < f.lower_hi || (h == f.lower_hi && l < f.lower_lo);
+  const bool above = h > f.upper_hi || (h == f.upper_hi && l > f.upper_lo);
+  return !below && !above;
+}
+
+// Interleaved values, as in a `uint128_t` array.
+template <typename T>
+struct AosSource {
+  const T* values;
+
+  void Get(size_t i, uint64_t* hi, uint64_t* lo) const {
+    const uint128_t v(values[i]);
+    *hi = Uint128High64(v);
+    *lo = Uint128Low64(v);
+  }
+
+#if ABSL_INT128_X86_KERNELS
+  // Loads values [i, i + 4) and deinterleaves their limbs. The unpacks work
+  // within 128-bit halves, leaving elements in the order 0 2 1 3.
+  ABSL_INT128_TARGET_AVX2 void Load(size_t i, __m256i* hi, __m256i* lo) const {
+    const auto* p = reinterpret_cast<const __m256i*>(values + i);
+    const __m256i a = _mm256_loadu_si256(p);
+    const __m256i b = _mm256_loadu_si256(p + 1);
+    *lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8);
+    *hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8);
+  }
+
+  // Loads values [i, i + 8).
+  ABSL_INT128_TARGET_AVX512 void Load(size_t i, __m512i* hi,
+                                      __m512i* lo) const {
+    const auto* p = reinterpret_cast<const __m512i*>(values + i);
+    const __m512i a = _mm512_loadu_si512(p);
+    const __m512i b = _mm512_loadu_si512(p + 1);
+    *lo = _mm512_permutex2var_epi64(
+        a, _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14), b);
+    *hi = _mm512_permutex2var_epi64(
+        a, _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15), b);
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+};
+
+// Separate limb arrays, as in a column.
+struct SoaSource {
+  const uint64_t* hi;
+  const uint64_t* lo;
+
+  void Get(size_t i, uint64_t* h, uint64_t* l) const {
+    *h = hi[i];
+    *l = lo[i];
+  }
+
+#if ABSL_INT128_X86_KERNELS
+  ABSL_INT128_TARGET_AVX2 void Load(size_t i, __m256i* h, __m256i* l) const {
+    *h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi + i));
+    *l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo + i));
+  }
+
+  ABSL_INT128_TARGET_AVX512 void Load(size_t i, __m512i* h, __m512i* l) const {
+    *h = _mm512_loadu_si512(hi + i);
+    *l = _mm512_loadu_si512(lo + i);
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+};
+
+template <typename T>
+SoaSource ColumnSource(const BasicInt128Column<T>& column) {
+  // The signed high limbs may be read as uint64_t.
+  return {reinterpret_cast<const uint64_t*>(column.hi()), column.lo()};
+}
+
+// Returns the bits for `count` values starting at `begin`.
+template <typename Source>
+uint64_t FilterScalar(const Source& src, const RangeFilter& f, size_t begin,
+                      size_t count) {
+  uint64_t bits = 0;
+  for (size_t j = 0; j < count; ++j) {
+    uint64_t hi, lo;
+    src.Get(begin + j, &hi, &lo);
+    bits |= uint64_t{InRange(f, hi, lo)} << j;
+  }
+  return bits;
+}
+
+#if ABSL_INT128_X86_KERNELS
+
+// Fills `words` whole bitmap words, 64 values each.
+template <typename Source>
+ABSL_INT128_TARGET_AVX2 void Filter256(const Source& src, const RangeFilter& f,
+                                       size_t words, uint64_t* bitmap) {
+  const __m256i hi_bias = _mm256_set1_epi64x(static_cast<int64_t>(f.hi_bias));
+  const __m256i lo_bias = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i lower_hi = _mm256_set1_epi64x(f.lower_hi);
+  const __m256i lower_lo = _mm256_set1_epi64x(f.lower_lo);
+  const __m256i upper_hi = _mm256_set1_epi64x(f.upper_hi);
+  const __m256i upper_lo = _mm256_set1_epi64x(f.upper_lo);
+  for (size_t w = 0; w < words; ++w) {
+    uint64_t rejected = 0;
+    for (size_t j = 0; j < 64; j += 4) {
+      __m256i hi, lo;
+      src.Load(w * 64 + j, &hi, &lo);
+      hi = _mm256_xor_si256(hi, hi_bias);
+      lo = _mm256_xor_si256(lo, lo_bias);
+      const __m256i below = _mm256_or_si256(
+          _mm256_cmpgt_epi64(lower_hi, hi),
+          _mm256_and_si256(_mm256_cmpeq_epi64(hi, lower_hi),
+                           _mm256_cmpgt_epi64(lower_lo, lo)));
+      const __m256i above = _mm256_or_si256(
+          _mm256_cmpgt_epi64(hi, upper_hi),
+          _mm256_and_si256(_mm256_cmpeq_epi64(hi, upper_hi),
+                           _mm256_cmpgt_epi64(lo, upper_lo)));
+      const int mask = _mm256_movemask_pd(
+          _mm256_castsi256_pd(_mm256_or_si256(below, above)));
+      rejected |= static_cast<uint64_t>(mask) << j;
+    }
+    bitmap[w] = ~rejected;
+  }
+}
+
+// The low-limb compares run under the mask of equal high limbs.
+template <typename Source>
+ABSL_INT128_TARGET_AVX512 void Filter512(const Source& src,
+                                         const RangeFilter& f, size_t words,
+                                         uint64_t* bitmap) {
+  const __m512i hi_bias = _mm512_set1_epi64(static_cast<int64_t>(f.hi_bias));
+  const __m512i lo_bias = _mm512_set1_epi64(INT64_MIN);
+  const __m512i lower_hi = _mm512_set1_epi64(f.lower_hi);
+  const __m512i lower_lo = _mm512_set1_epi64(f.lower_lo);
+  const __m512i upper_hi = _mm512_set1_epi64(f.upper_hi);
+  const __m512i upper_lo = _mm512_set1_epi64(f.upper_lo);
+  for (size_t w = 0; w < words; ++w) {
+    uint64_t rejected = 0;
+    for (size_t j = 0; j < 64; j += 8) {
+      __m512i hi, lo;
+      src.Load(w * 64 + j, &hi, &lo);
+      hi = _mm512_xor_si512(hi, hi_bias);
+      lo = _mm512_xor_si512(lo, lo_bias);
+      const __mmask8 below =
+          _mm512_cmplt_epi64_mask(hi, lower_hi) |
+          _mm512_mask_cmplt_epi64_mask(_mm512_cmpeq_epi64_mask(hi, lower_hi),
+                                       lo, lower_lo);
+      const __mmask8 above =
+          _mm512_cmpgt_epi64_mask(hi, upper_hi) |
+          _mm512_mask_cmpgt_epi64_mask(_mm512_cmpeq_epi64_mask(hi, upper_hi),
+                                       lo, upper_lo);
+      rejected |= static_cast<uint64_t>(below | above) << j;
+    }
+    bitmap[w] = ~rejected;
+  }
+}
+
+#endif  // ABSL_INT128_X86_KERNELS
+
+// Fills a prefix of the `words` whole bitmap words with the best available
+// vector kernel and returns its length.
+template <typename Source>
+size_t FilterVector(const Source& src, const RangeFilter& f, size_t words,
+                    uint64_t* bitmap) {
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveKernelLevel()) {
+    case KernelLevel::kAvx512:
+      Filter512(src, f, words, bitmap);
+      return words;
+    case KernelLevel::kAvx2:
+      Filter256(src, f, words, bitmap);
+      return words;
+    case KernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  static_cast<void>(src);
+  static_cast<void>(f);
+  static_cast<void>(words);
+  static_cast<void>(bitmap);
+  return 0;
+}
+
+template <typename Source>
+size_t FilterImpl(const Source& src, size_t n, const RangeFilter& f,
+                  uint64_t* bitmap) {
+  const size_t full = n / 64;
+  const size_t words = (n + 63) / 64;
+  if (f.empty) {
+    for (size_t w = 0; w < words; ++w) bitmap[w] = 0;
+  } else {
+    for (size_t w = FilterVector(src, f, full, bitmap); w < full; ++w) {
+      bitmap[w] = FilterScalar(src, f, w * 64, 64);
+    }
+    if (full < words) bitmap[full] = FilterScalar(src, f, full * 64, n % 64);
+  }
+  size_t count = 0;
+  for (size_t w = 0; w < words; ++w) {
+    if (f.invert) {
+      bitmap[w] = ~bitmap[w];
+      if (w == full) bitmap[w] &= (uint64_t{1} << (n % 64)) - 1;
+    }
+    count += static_cast<size_t>(int128_t_internal::Popcount64(bitmap[w]));
+  }
+  return count;
+}
+
+// Splits [0, n) into one contiguous chunk per OpenMP thread, applies
+// `reduce(begin, end)` to each and returns the results in order.
+template <typename Partial, typename Reduce>
+std::vector<Partial> ReduceChunks(size_t n, Execution execution,
+                                  Reduce reduce) {
+  const size_t chunks = int128_t_internal::ChunkCount(n, execution);
+  std::vector<Partial> partial(chunks);
+  int128_t_internal::ForEachChunk(
+      n, chunks, [&](size_t c, size_t begin, size_t end) {
+        partial[c] = reduce(begin, end);
+      });
+  return partial;
+}
+
+// A wrapping 192-bit accumulator, least significant limb first.
+struct Acc192 {
+  uint64_t limb[3] = {0, 0, 0};
+
+  void Add(uint64_t a0, uint64_t a1, uint64_t a2) {
+    const uint64_t r0 = limb[0] + a0;
+    const uint64_t c0 = r0 < a0;
+    const uint64_t r1 = limb[1] + a1;
+    const uint64_t c1 = (r1 < a1) + (r1 + c0 < c0);
+    limb[0] = r0;
+    limb[1] = r1 + c0;
+    limb[2] += a2 + c1;
+  }
+
+  // Adds `v * 2^(64 * pos)` for `pos` 0 or 1.
+  void AddUnsigned(uint64_t v, int pos) {
+    pos == 0 ? Add(v, 0, 0) : Add(0, v, 0);
+  }
+  void AddSigned(int64_t v, int pos) {
+    const uint64_t u = static_cast<uint64_t>(v);
+    const uint64_t ext = v < 0 ? ~uint64_t{0} : 0;
+    pos == 0 ? Add(u, ext, ext) : Add(0, u, ext);
+  }
+
+  void Add(const Acc192& other) {
+    Add(other.limb[0], other.limb[1], other.limb[2]);
+  }
+
+  template <typename T>
+  void Add(T value) {
+    const uint128_t v(value);
+    const uint64_t ext = std::is_same<T, int128_t>::value &&
+                                 (Uint128High64(v) >> 63) != 0
+                             ? ~uint64_t{0}
+                             : 0;
+    Add(Uint128Low64(v), Uint128High64(v), ext);
+  }
+};
+
+// The vector sums keep one 64-bit accumulator per limb lane, plus a counter
+// per lane that is incremented for each carry out of the lane and, in the
+// high lanes of signed values, decremented for each negative value, whose
+// high limb was added as if it were 2^64 larger. The lanes never interact, so
+// interleaved values are summed without shuffles. The counters cannot
+// overflow, since fewer than 2^60 values fit in memory.
+//
+// Adds the lane sums and counters to `acc`. Even lanes hold low limbs.
+inline void AddLanes(const uint64_t* sums, const int64_t* counts, int lanes,
+                     Acc192* acc) {
+  for (int i = 0; i < lanes; ++i) {
+    acc->AddUnsigned(sums[i], i & 1);
+    // A count in lane i weighs 2^64 times the lane's sum.
+    if ((i & 1) == 0) {
+      acc->AddUnsigned(static_cast<uint64_t>(counts[i]), 1);
+    } else {
+      acc->Add(0, 0, static_cast<uint64_t>(counts[i]));
+    }
+  }
+}
+
+#if ABSL_INT128_X86_KERNELS
+
+template <bool kSigned>
+ABSL_INT128_TARGET_AVX2 size_t Sum256(const void* values, size_t n,
+                                      Acc192* acc) {
+  const auto* in = static_cast<const __m256i*>(values);
+  const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i high_lanes =
+      kSigned ? _mm256_setr_epi64x(0, -1, 0, -1) : _mm256_setzero_si256();
+  __m256i sum = _mm256_setzero_si256();
+  __m256i count = _mm256_setzero_si256();
+  const size_t vectors = n / 2;
+  for (size_t i = 0; i < vectors; ++i) {
+    const __m256i x = _mm256_loadu_si256(in + i);
+    sum = _mm256_add_epi64(sum, x);
+    const __m256i carry = _mm256_cmpgt_epi64(_mm256_xor_si256(x, bias),
+                                             _mm256_xor_si256(sum, bias));
+    const __m256i negative = _mm256_and_si256(
+        _mm256_cmpgt_epi64(_mm256_setzero_si256(), x), high_lanes);
+    // Both masks are -1 where set.
+    count = _mm256_add_epi64(_mm256_sub_epi64(count, carry), negative);
+  }
+  uint64_t sums[4];
+  int64_t counts[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), sum);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(counts), count);
+  AddLanes(sums, counts, 4, acc);
+  return vectors * 2;
+}
+
+template <bool kSigned>
+ABSL_INT128_TARGET_AVX512 size_t Sum512(const void* values, size_t n,
+                                        Acc192* acc) {
+  const auto* in = static_cast<const __m512i*>(values);
+  const __m512i one = _mm512_set1_epi64(1);
+  const __mmask8 high_lanes = kSigned ? kHighLanes : 0;
+  __m512i sum = _mm512_setzero_si512();
+  __m512i count = _mm512_setzero_si512();
+  const size_t vectors = n / 4;
+  for (size_t i = 0; i < vectors; ++i) {
+    const __m512i x = _mm512_loadu_si512(in + i);
+    sum = _mm512_add_epi64(sum, x);
+    const __mmask8 carry = _mm512_cmplt_epu64_mask(sum, x);
+    const __mmask8 negative = _mm512_mask_cmplt_epi64_mask(
+        high_lanes, x, _mm512_setzero_si512());
+    count = _mm512_mask_add_epi64(count, carry, count, one);
+    count = _mm512_mask_sub_epi64(count, negative, count, one);
+  }
+  uint64_t sums[8];
+  int64_t counts[8];
+  _mm512_storeu_si512(sums, sum);
+  _mm512_storeu_si512(counts, count);
+  AddLanes(sums, counts, 8, acc);
+  return vectors * 4;
+}
+
+// Per-lane running minimum and maximum of biased limbs, as in the filters.
+template <bool kMin, bool kMax>
+struct Extremes256 {
+  __m256i min_hi, min_lo, max_hi, max_lo;
+
+  // Limbs compare as (hi, lo) pairs; returns the mask of lanes where
+  // a < b.
+  ABSL_INT128_TARGET_AVX2 static __m256i Less(__m256i a_hi, __m256i a_lo,
+                                              __m256i b_hi, __m256i b_lo) {
+    return _mm256_or_si256(
+        _mm256_cmpgt_epi64(b_hi, a_hi),
+        _mm256_and_si256(_mm256_cmpeq_epi64(a_hi, b_hi),
+                         _mm256_cmpgt_epi64(b_lo, a_lo)));
+  }
+
+  ABSL_INT128_TARGET_AVX2 void Update(__m256i hi, __m256i lo) {
+    if (kMin) {
+      const __m256i less = Less(hi, lo, min_hi, min_lo);
+      min_hi = _mm256_blendv_epi8(min_hi, hi, less);
+      min_lo = _mm256_blendv_epi8(min_lo, lo, less);
+    }
+    if (kMax) {
+      const __m256i greater = Less(max_hi, max_lo, hi, lo);
+      max_hi = _mm256_blendv_epi8(max_hi, hi, greater);
+      max_lo = _mm256_blendv_epi8(max_lo, lo, greater);
+    }
+  }
+};
+
+template <bool kMin, bool kMax>
+struct Extremes512 {
+  __m512i min_hi, min_lo, max_hi, max_lo;
+
+  ABSL_INT128_TARGET_AVX512 static __mmask8 Less(__m512i a_hi, __m512i a_lo,
+                                                 __m512i b_hi, __m512i b_lo) {
+    return _mm512_cmplt_epi64_mask(a_hi, b_hi) |
+           _mm512_mask_cmplt_epi64_mask(_mm512_cmpeq_epi64_mask(a_hi, b_hi),
+                                        a_lo, b_lo);
+  }
+
+  ABSL_INT128_TARGET_AVX512 void Update(__m512i hi, __m512i lo) {
+    if (kMin) {
+      const __mmask8 less = Less(hi, lo, min_hi, min_lo);
+      min_hi = _mm512_mask_mov_epi64(min_hi, less, hi);
+      min_lo = _mm512_mask_mov_epi64(min_lo, less, lo);
+    }
+    if (kMax) {
+      const __mmask8 greater = Less(max_hi, max_lo, hi, lo);
+      max_hi = _mm512_mask_mov_epi64(max_hi, greater, hi);
+      max_lo = _mm512_mask_mov_epi64(max_lo, greater, lo);
+    }
+  }
+};
+
+// Folds the lanes, unbiased, into `result`.
+template <typename T, bool kMin, bool kMax>
+void FoldExtremes(const uint64_t* min_hi, const uint64_t* min_lo,
+                  const uint64_t* max_hi, const uint64_t* max_lo, int lanes,
+                  uint64_t hi_bias, std::pair<T, T>* result) {
+  for (int i = 0; i < lanes; ++i) {
+    if (kMin) {
+      const T v(MakeUint128(min_hi[i] ^ hi_bias, min_lo[i] ^ kSignBit));
+      if (v < result->first) result->first = v;
+    }
+    if (kMax) {
+      const T v(MakeUint128(max_hi[i] ^ hi_bias, max_lo[i] ^ kSignBit));
+      if (result->second < v) result->second = v;
+    }
+  }
+}
+
+// The vector kernels start from the first vector of values and leave the
+// caller's `result`, which already holds values[0], to absorb the lanes.
+template <typename T, bool kMin, bool kMax>
+ABSL_INT128_TARGET_AVX2 size_t MinMax256(const T* values, size_t n,
+                                         std::pair<T, T>* result) {
+  const size_t vectors = n / 4;
+  if (vectors == 0) return 0;
+  const uint64_t hi_bias = std::is_same<T, uint128_t>::value ? kSignBit : 0;
+  const __m256i hi_biases = _mm256_set1_epi64x(static_cast<int64_t>(hi_bias));
+  const __m256i lo_bias = _mm256_set1_epi64x(INT64_MIN);
+  const AosSource<T> src{values};
+  __m256i hi, lo;
+  src.Load(0, &hi, &lo);
+  hi = _mm256_xor_si256(hi, hi_biases);
+  lo = _mm256_xor_si256(lo, lo_bias);
+  Extremes256<kMin, kMax> e{hi, lo, hi, lo};
+  for (size_t i = 1; i < vectors; ++i) {
+    src.Load(i * 4, &hi, &lo);
+    e.Update(_mm256_xor_si256(hi, hi_biases), _mm256_xor_si256(lo, lo_bias));
+  }
+  uint64_t lanes[4][4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[0]), e.min_hi);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[1]), e.min_lo);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[2]), e.max_hi);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[3]), e.max_lo);
+  FoldExtremes<T, kMin, kMax>(lanes[0], lanes[1], lanes[2], lanes[3], 4,
+                              hi_bias, result);
+  return vectors * 4;
+}
+
+template <typename T, bool kMin, bool kMax>
+ABSL_INT128_TARGET_AVX512 size_t MinMax512(const T* values, size_t n,
+                                           std::pair<T, T>* result) {
+  const size_t vectors = n / 8;
+  if (vectors == 0) return 0;
+  const uint64_t hi_bias = std::is_same<T, uint128_t>::value ? kSignBit : 0;
+  const __m512i hi_biases = _mm512_set1_epi64(static_cast<int64_t>(hi_bias));
+  const __m512i lo_bias = _mm512_set1_epi64(INT64_MIN);
+  const AosSource<T> src{values};
+  __m512i hi, lo;
+  src.Load(0, &hi, &lo);
+  hi = _mm512_xor_si512(hi, hi_biases);
+  lo = _mm512_xor_si512(lo, lo_bias);
+  Extremes512<kMin, kMax> e{hi, lo, hi, lo};
+  for (size_t i = 1; i < vectors; ++i) {
+    src.Load(i * 8, &hi, &lo);
+    e.Update(_mm512_xor_si512(hi, hi_biases), _mm512_xor_si512(lo, lo_bias));
+  }
+  uint64_t lanes[4][8];
+  _mm512_storeu_si512(lanes[0], e.min_hi);
+  _mm512_storeu_si512(lanes[1], e.min_lo);
+  _mm512_storeu_si512(lanes[2], e.max_hi);
+  _mm512_storeu_si512(lanes[3], e.max_lo);
+  FoldExtremes<T, kMin, kMax>(lanes[0], lanes[1], lanes[2], lanes[3], 8,
+                              hi_bias, result);
+  return vectors * 8;
+}
+
+#endif  // ABSL_INT128_X86_KERNELS
+
+// Sums a prefix of `values` into `acc` with the best available vector kernel
+// and returns its length.
+template <typename T>
+size_t SumVector(const T* values, size_t n, Acc192* acc) {
+  constexpr bool kSigned = std::is_same<T, int128_t>::value;
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveKernelLevel()) {
+    case KernelLevel::kAvx512:
+      return Sum512<kSigned>(values, n, acc);
+    case KernelLevel::kAvx2:
+      return Sum256<kSigned>(values, n, acc);
+    case KernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  static_cast<void>(kSigned);
+  static_cast<void>(values);
+  static_cast<void>(n);
+  static_cast<void>(acc);
+  return 0;
+}
+
+template <typename T, bool kMin, bool kMax>
+size_t MinMaxVector(const T* values, size_t n, std::pair<T, T>* result) {
+#if ABSL_INT128_X86_KERNELS
+  switch (int128_t_internal::ActiveKernelLevel()) {
+    case KernelLevel::kAvx512:
+      return MinMax512<T, kMin, kMax>(values, n, result);
+    case KernelLevel::kAvx2:
+      return MinMax256<T, kMin, kMax>(values, n, result);
+    case KernelLevel::kPortable:
+      break;
+  }
+#endif  // ABSL_INT128_X86_KERNELS
+  static_cast<void>(values);
+  static_cast<void>(n);
+  static_cast<void>(result);
+  return 0;
+}
+
+template <typename T>
+BasicInt192<T> SumImpl(const T* values, size_t n, Execution execution) {
+  const std::vector<Acc192> partial =
+      ReduceChunks<Acc192>(n, execution, [values](size_t begin, size_t end) {
+        Acc192 acc;
+        for (size_t i = begin + SumVector(values + begin, end - begin, &acc);
+             i < end; ++i) {
+          acc.Add(values[i]);
+        }
+        return acc;
+      });
+  Acc192 total;
+  for (const Acc192& acc : partial) total.Add(acc);
+  BasicInt192<T> result;
+  result.high = static_cast<typename BasicInt192<T>::High>(total.limb[2]);
+  result.low = MakeUint128(total.limb[1], total.limb[0]);
+  return result;
+}
+
+// Scans `a[0, n)` into `dst` starting from `sum`.
+template <typename T, bool kInclusive>
+void Scan(T* dst, const T* a, size_t n, T sum) {
+  for (size_t i = 0; i < n; ++i) {
+    const T value = a[i];  // dst may alias a
+    if (kInclusive) sum += value;
+    dst[i] = sum;
+    if (!kInclusive) sum += value;
+  }
+}
+
+template <typename T, bool kInclusive>
+void PrefixSumImpl(T* dst, const T* a, size_t n, Execution execution) {
+  const size_t chunks = int128_t_internal::ChunkCount(n, execution);
+  if (chunks == 1) {
+    Scan<T, kInclusive>(dst, a, n, T(0));
+    return;
+  }
+  // The chunk totals only need the low 128 bits of the vector sums.
+  std::vector<T> start(chunks);
+  int128_t_internal::ForEachChunk(
+      n, chunks, [&](size_t c, size_t begin, size_t end) {
+        Acc192 acc;
+        for (size_t i = begin + SumVector(a + begin, end - begin, &acc);
+             i < end; ++i) {
+          acc.Add(a[i]);
+        }
+        start[c] = T(MakeUint128(acc.limb[1], acc.limb[0]));
+      });
+  T sum = 0;
+  for (T& s : start) {
+    const T total = s;
+    s = sum;
+    sum += total;
+  }
+  int128_t_internal::ForEachChunk(
+      n, chunks, [&](size_t c, size_t begin, size_t end) {
+        Scan<T, kInclusive>(dst + begin, a + begin, end - begin, start[c]);
+      });
+}
+
+// With only one of kMin and kMax, the other half of the result is unused.
+template <typename T, bool kMin, bool kMax>
+std::pair<T, T> MinMaxImpl(const T* values, size_t n, Execution execution) {
+  assert(n > 0);
+  using Result = std::pair<T, T>;
+  const std::vector<Result> partial =
+      ReduceChunks<Result>(n, execution, [values](size_t begin, size_t end) {
+        Result r(values[begin], values[begin]);
+        for (size_t i = begin + MinMaxVector<T, kMin, kMax>(
+                                    values + begin, end - begin, &r);
+             i < end; ++i) {
+          if (kMin && values[i] < r.first) r.first = values[i];
+          if (kMax && r.second < values[i]) r.second = values[i];
+        }
+        return r;
+      });
+  Result result = partial[0];
+  for (const Result& r : partial) {
+    if (r.first < result.first) result.first = r.first;
+    if (result.second < r.second) result.second = r.second;
+  }
+  return result;
+}
+
+}  // namespace
+
+void AddN(uint128_t* dst, const uint128_t* a, const uint128_t* b, size_t n) {
+  AddImpl(dst, a, b, n);
+}
+
+void AddN(int128_t* dst, const int128_t* a, const int128_t* b, size_t n) {
+  AddImpl(dst, a, b, n);
+}
+
+void SubN(uint128_t* dst, const uint128_t* a, const uint128_t* b, size_t n) {
+  SubImpl(dst, a, b, n);
+}
+
+void SubN(int128_t* dst, const int128_t* a, const int128_t* b, size_t n) {
+  SubImpl(dst, a, b, n);
+}
+
+void NegN(uint128_t* dst, const uint128_t* a, size_t n) { NegImpl(dst, a, n); }
+
+void NegN(int128_t* dst, const int128_t* a, size_t n) { NegImpl(dst, a, n); }
+
+void AddScalarN(uint128_t* dst, const uint128_t* a, uint128_t b, size_t n) {
+  AddScalarImpl(dst, a, b, n);
+}
+
+void AddScalarN(int128_t* dst, const int128_t* a, int128_t b, size_t n) {
+  AddScalarImpl(dst, a, b, n);
+}
+
+void SubScalarN(uint128_t* dst, const uint128_t* a, uint128_t b, size_t n) {
+  SubScalarImpl(dst, a, b, n);
+}
+
+void SubScalarN(int128_t* dst, const int128_t* a, int128_t b, size_t n) {
+  SubScalarImpl(dst, a, b, n);
+}
+
+void HashN(uint64_t* out, const uint128_t* values, size_t n) {
+  HashImpl(out, values, n);
+}
+
+void HashN(uint64_t* out, const int128_t* values, size_t n) {
+  HashImpl(out, values, n);
+}
+
+void MulN(uint128_t* dst, const uint128_t* a, const uint128_t* b, size_t n) {
+  MulImpl<uint128_t, false>(dst, a, b, n);
+}
+
+void MulN(int128_t* dst, const int128_t* a, const int128_t* b, size_t n) {
+  MulImpl<int128_t, false>(dst, a, b, n);
+}
+
+void MulScalarN(uint128_t* dst, const uint128_t* a, uint128_t b, size_t n) {
+  MulImpl<uint128_t, true>(dst, a, &b, n);
+}
+
+void MulScalarN(int128_t* dst, const int128_t* a, int128_t b, size_t n) {
+  MulImpl<int128_t, true>(dst, a, &b, n);
+}
+
+void MulWideN(uint128_t* high, uint128_t* low, const uint128_t* a,
+              const uint128_t* b, size_t n) {
+  MulWideImpl(high, low, a, b, n);
+}
+
+void DivModScalarN(uint128_t* quotient, uint64_t* remainder,
+                   const uint128_t* a, uint64_t divisor, size_t n) {
+  DivModImpl(quotient, remainder, a, divisor, n);
+}
+
+std::string ActiveKernelVariants() {
+  static const char* const kVector[] = {"portable", "avx2", "avx512"};
+  static const char* const kMultiply[] = {"portable", "bmi2", "bmi2+adx"};
+  std::string variants = "vector=";
+  variants += kVector[static_cast<int>(
+      int128_t_internal::ActiveKernelLevel())];
+  variants += " multiply=";
+  variants += kMultiply[static_cast<int>(
+      int128_t_internal::ActiveMulKernelLevel())];
+  variants += " varint=";
+  variants += int128_t_internal::UsePdep() ? "bmi2" : "portable";
+  return variants;
+}
+
+size_t CompareN(const uint128_t* values, size_t n, CompareOp op, uint128_t c,
+                uint64_t* bitmap) {
+  return FilterImpl(AosSource<uint128_t>{values}, n, MakeCompareFilter(op, c),
+                    bitmap);
+}
+
+size_t CompareN(const int128_t* values, size_t n, CompareOp op, int128_t c,
+                uint64_t* bitmap) {
+  return FilterImpl(AosSource<int128_t>{values}, n, MakeCompareFilter(op, c),
+                    bitmap);
+}
+
+size_t CompareN(const Uint128Column& column, CompareOp op, uint128_t c,
+                uint64_t* bitmap) {
+  return FilterImpl(ColumnSource(column), column.size(),
+                    MakeCompareFilter(op, c), bitmap);
+}
+
+size_t CompareN(const Int128Column& column, CompareOp op, int128_t c,
+                uint64_t* bitmap) {
+  return FilterImpl(ColumnSource(column), column.size(),
+                    MakeCompareFilter(op, c), bitmap);
+}
+
+size_t BetweenN(const uint128_t* values, size_t n, uint128_t lower,
+                uint128_t upper, uint64_t* bitmap) {
+  return FilterImpl(AosSource<uint128_t>{values}, n,
+                    MakeBetweenFilter(lower, upper), bitmap);
+}
+
+size_t BetweenN(const int128_t* values, size_t n, int128_t lower,
+                int128_t upper, uint64_t* bitmap) {
+  return FilterImpl(AosSource<int128_t>{values}, n,
+                    MakeBetweenFilter(lower, upper), bitmap);
+}
+
+size_t BetweenN(const Uint128Column& column, uint128_t lower, uint128_t upper,
+                uint64_t* bitmap) {
+  return FilterImpl(ColumnSource(column), column.size(),
+                    MakeBetweenFilter(lower, upper), bitmap);
+}
+
+size_t BetweenN(const Int128Column& column, int128_t lower, int128_t upper,
+                uint64_t* bitmap) {
+  return FilterImpl(ColumnSource(column), column.size(),
+                    MakeBetweenFilter(lower, upper), bitmap);
+}
+
+Uint192 Sum(const uint128_t* values, size_t n, Execution execution) {
+  return SumImpl(values, n, execution);
+}
+
+Int192 Sum(const int128_t* values, size_t n, Execution execution) {
+  return SumImpl(values, n, execution);
+}
+
+uint128_t Min(const uint128_t* values, size_t n, Execution execution) {
+  return MinMaxImpl<uint128_t, true, false>(values, n, execution).first;
+}
+
+int128_t Min(const int128_t* values, size_t n, Execution execution) {
+  return MinMaxImpl<int128_t, true, false>(values, n, execution).first;
+}
+
+uint128_t Max(const uint128_t* values, size_t n, Execution execution) {
+  return MinMaxImpl<uint128_t, false, true>(values, n, execution).second;
+}
+
+int128_t Max(const int128_t* values, size_t n, Execution execution) {
+  return MinMaxImpl<int128_t, false, true>(values, n, execution).second;
+}
+
+std::pair<uint128_t, uint128_t> MinMax(const uint128_t* values, size_t n,
+                                       Execution execution) {
+  return MinMaxImpl<uint128_t, true, true>(values, n, execution);
+}
+
+std::pair<int128_t, int128_t> MinMax(const int128_t* values, size_t n,
+                                     Execution execution) {
+  return MinMaxImpl<int128_t, true, true>(values, n, execution);
+}
+
+void InclusivePrefixSum(uint128_t* dst, const uint128_t* a, size_t n,
+                        Execution execution) {
+  PrefixSumImpl<uint128_t, true>(dst, a, n, execution);
+}
+
+void InclusivePrefixSum(int128_t* dst, const int128_t* a, size_t n,
+                        Execution execution) {
+  PrefixSumImpl<int128_t, true>(dst, a, n, execution);
+}
+
+void ExclusivePrefixSum(uint128_t* dst, const uint128_t* a, size_t n,
+                        Execution execution) {
+  PrefixSumImpl<uint128_t, false>(dst, a, n, execution);
+}
+
+void ExclusivePrefixSum(int128_t* dst, const int128_t* a, size_t n,
+                        Execution execution) {
+  PrefixSumImpl<int128_t, false>(dst, a, n, execution);
+}
+
+size_t BitmapToSelection(const uint64_t* bitmap, size_t n,
+                         uint32_t* selection) {
+  assert(n <= (std::numeric_limits<uint32_t>::max)());
+  size_t count = 0;
+  for (size_t w = 0; w * 64 < n; ++w) {
+    uint64_t bits = bitmap[w];
+    const size_t left = n - w * 64;
+    if (left < 64) bits &= (uint64_t{1} << left) - 1;
+    while (bits != 0) {
+      selection[count++] = static_cast<uint32_t>(
+          w * 64 + int128_t_internal::CountTrailingZeros64(bits));
+      bits &= bits - 1;
+    }
+  }
+  return count;
+}
+
+}  // namespace absl
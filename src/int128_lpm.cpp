@@ -0,0 +1,294 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_lpm.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+
+#include "int128_kernels.h"
+
+// The lookups are also compiled for CPUs with a popcnt instruction, which
+// every CPU with AVX2 has; otherwise each bitmap count is a library call.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ABSL_INT128_LPM_POPCNT 1
+#define ABSL_INT128_TARGET_POPCNT __attribute__((target("popcnt")))
+#else
+#define ABSL_INT128_LPM_POPCNT 0
+#endif
+
+namespace absl {
+
+namespace {
+
+// 18 + 5 * 6 = 48, so a /48 ends at the fifth node level.
+constexpr int kDirectBits = 18;
+constexpr int kStride = 6;
+constexpr size_t kBatch = 32;
+
+// Returns bits [depth, depth + bits) of `v`, counting from the top. Bits past
+// the end of `v` read as zero. Down to /64 only the high half is shifted.
+inline uint32_t Bits(uint128_t v, int depth, int bits) {
+  if (depth + bits <= 64) {
+    return static_cast<uint32_t>((Uint128High64(v) << depth) >> (64 - bits));
+  }
+  return static_cast<uint32_t>(Uint128Low64((v << depth) >> (128 - bits)));
+}
+
+// Returns a mask of slots [0, slot].
+inline uint64_t UpTo(uint32_t slot) { return (uint64_t{2} << slot) - 1; }
+
+bool UsePopcnt() {
+#if ABSL_INT128_LPM_POPCNT
+  return int128_t_internal::ActiveKernelLevel() !=
+         int128_t_internal::KernelLevel::kPortable;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+constexpr uint32_t LpmTable128::kNoMatch;
+constexpr uint32_t LpmTable128::kValueFlag;
+
+// Builds the trie top-down. The routes of a subtree are a contiguous range of
+// a copy of the input sorted by prefix; each node moves the routes that end
+// within it to the front of its range and passes the rest down.
+class LpmTable128::Builder {
+ public:
+  explicit Builder(LpmTable128* table) : table_(*table) {}
+
+  void Build(LpmRoute128* begin, LpmRoute128* end) {
+    std::vector<uint32_t> slots(size_t{1} << kDirectBits, kNoMatch);
+    LpmRoute128* longer = FillSlots(begin, end, 0, kDirectBits, slots.data());
+    table_.direct_.resize(slots.size());
+    for (size_t s = 0; s < slots.size(); ++s) {
+      table_.direct_[s] = slots[s] | kValueFlag;
+    }
+    while (longer != end) {
+      const uint32_t s = Bits(longer->prefix, 0, kDirectBits);
+      LpmRoute128* next = SameSlot(longer, end, 0, kDirectBits);
+      table_.direct_[s] = static_cast<uint32_t>(table_.nodes_.size());
+      table_.nodes_.emplace_back();
+      BuildNode(table_.direct_[s], longer, next, kDirectBits, slots[s]);
+      longer = next;
+    }
+  }
+
+ private:
+  // Moves the routes of `[begin, end)` that end within bits
+  // `[depth, depth + bits)` to the front, and writes their values to the
+  // 2^bits `slots` they cover, shorter routes first so that longer ones
+  // override them. Returns the end of those routes. The longer routes that
+  // remain stay sorted by prefix.
+  static LpmRoute128* FillSlots(LpmRoute128* begin, LpmRoute128* end,
+                                int depth, int bits, uint32_t* slots) {
+    LpmRoute128* longer =
+        std::stable_partition(begin, end, [depth, bits](const LpmRoute128& r) {
+          return r.length <= depth + bits;
+        });
+    std::stable_sort(begin, longer,
+                     [](const LpmRoute128& a, const LpmRoute128& b) {
+                       return a.length < b.length;
+                     });
+    for (const LpmRoute128* r = begin; r != longer; ++r) {
+      const uint32_t first = Bits(r->prefix, depth, bits);
+      const uint32_t count = uint32_t{1} << (depth + bits - r->length);
+      std::fill(slots + first, slots + first + count, r->value);
+    }
+    return longer;
+  }
+
+  // Returns the end of the routes starting at `begin` that fall in the same
+  // slot.
+  static LpmRoute128* SameSlot(LpmRoute128* begin, LpmRoute128* end,
+                               int depth, int bits) {
+    const uint32_t s = Bits(begin->prefix, depth, bits);
+    LpmRoute128* next = begin + 1;
+    while (next != end && Bits(next->prefix, depth, bits) == s) ++next;
+    return next;
+  }
+
+  // Builds node `index` at `depth` from routes longer than `depth` that share
+  // its prefix. Keys the routes do not cover get `inherited`.
+  void BuildNode(uint32_t index, LpmRoute128* begin, LpmRoute128* end,
+                 int depth, uint32_t inherited) {
+    uint32_t slots[1 << kStride];
+    std::fill(slots, slots + (1 << kStride), inherited);
+    LpmRoute128* longer = FillSlots(begin, end, depth, kStride, slots);
+
+    Node node = {};
+    for (LpmRoute128* r = longer; r != end; ++r) {
+      node.children |= uint64_t{1} << Bits(r->prefix, depth, kStride);
+    }
+    // Children are allocated together, before any of them is built, so that
+    // they are contiguous.
+    node.child_base = static_cast<uint32_t>(table_.nodes_.size());
+    table_.nodes_.resize(table_.nodes_.size() + Popcount(node.children));
+    node.value_base = static_cast<uint32_t>(table_.values_.size());
+    bool first = true;
+    for (uint32_t s = 0; s < (1 << kStride); ++s) {
+      if ((node.children >> s) & 1) continue;
+      if (first || slots[s] != table_.values_.back()) {
+        node.runs |= uint64_t{1} << s;
+        table_.values_.push_back(slots[s]);
+        first = false;
+      }
+    }
+    table_.nodes_[index] = node;
+
+    uint32_t child = node.child_base;
+    while (longer != end) {
+      LpmRoute128* next = SameSlot(longer, end, depth, kStride);
+      BuildNode(child++, longer, next, depth + kStride,
+                slots[Bits(longer->prefix, depth, kStride)]);
+      longer = next;
+    }
+  }
+
+  LpmTable128& table_;
+};
+
+// The lookups. The portable entry points and the popcnt ones share these
+// bodies, which are inlined into each so that the popcnt versions count bits
+// with the instruction.
+struct LpmTable128::Walker {
+  ABSL_ATTRIBUTE_ALWAYS_INLINE static uint32_t Lookup(const LpmTable128& t,
+                                                      uint128_t key) {
+    const uint32_t entry = t.direct_[Bits(key, 0, kDirectBits)];
+    if (entry & kValueFlag) return entry & ~kValueFlag;
+    const Node* node = &t.nodes_[entry];
+    for (int depth = kDirectBits;; depth += kStride) {
+      const uint32_t s = Bits(key, depth, kStride);
+      if (((node->children >> s) & 1) == 0) {
+        return t.values_[node->value_base + Popcount(node->runs & UpTo(s)) -
+                         1];
+      }
+      node = &t.nodes_[node->child_base +
+                       Popcount(node->children & UpTo(s)) - 1];
+    }
+  }
+
+  ABSL_ATTRIBUTE_ALWAYS_INLINE static void LookupN(const LpmTable128& t,
+                                                   const uint128_t* keys,
+                                                   size_t n,
+                                                   uint32_t* values) {
+    for (size_t begin = 0; begin < n; begin += kBatch) {
+      const size_t count = std::min(kBatch, n - begin);
+      const uint128_t* batch = keys + begin;
+      uint32_t* out = values + begin;
+
+      for (size_t j = 0; j < count; ++j) {
+        int128_t_internal::Prefetch(&t.direct_[Bits(batch[j], 0, kDirectBits)]);
+      }
+      // The node a lookup is at, and once it leaves the trie the index of its
+      // value.
+      uint32_t index[kBatch];
+      uint32_t pending[kBatch];  // the lookups still walking the trie
+      uint32_t found[kBatch];    // the lookups waiting for their value
+      size_t active = 0;
+      size_t done = 0;
+      for (size_t j = 0; j < count; ++j) {
+        const uint32_t entry = t.direct_[Bits(batch[j], 0, kDirectBits)];
+        if (entry & kValueFlag) {
+          out[j] = entry & ~kValueFlag;
+        } else {
+          index[j] = entry;
+          int128_t_internal::Prefetch(&t.nodes_[entry]);
+          pending[active++] = static_cast<uint32_t>(j);
+        }
+      }
+      // All pending lookups are at the same depth, so each round takes one
+      // step of every one of them.
+      for (int depth = kDirectBits; active != 0; depth += kStride) {
+        size_t kept = 0;
+        for (size_t p = 0; p < active; ++p) {
+          const uint32_t j = pending[p];
+          const Node& node = t.nodes_[index[j]];
+          const uint32_t s = Bits(batch[j], depth, kStride);
+          if (((node.children >> s) & 1) == 0) {
+            index[j] = node.value_base + Popcount(node.runs & UpTo(s)) - 1;
+            found[done++] = j;
+          } else {
+            index[j] = node.child_base + Popcount(node.children & UpTo(s)) - 1;
+            int128_t_internal::Prefetch(&t.nodes_[index[j]]);
+            pending[kept++] = j;
+          }
+        }
+        active = kept;
+      }
+      // The values are read last, as one run of independent loads.
+      for (size_t p = 0; p < done; ++p) {
+        out[found[p]] = t.values_[index[found[p]]];
+      }
+    }
+  }
+
+#if ABSL_INT128_LPM_POPCNT
+  ABSL_INT128_TARGET_POPCNT static uint32_t LookupPopcnt(const LpmTable128& t,
+                                                         uint128_t key) {
+    return Lookup(t, key);
+  }
+
+  ABSL_INT128_TARGET_POPCNT static void LookupNPopcnt(const LpmTable128& t,
+                                                      const uint128_t* keys,
+                                                      size_t n,
+                                                      uint32_t* values) {
+    LookupN(t, keys, n, values);
+  }
+#endif  // ABSL_INT128_LPM_POPCNT
+};
+
+LpmTable128::LpmTable128()
+    : direct_(size_t{1} << kDirectBits, kNoMatch | kValueFlag) {}
+
+LpmTable128::LpmTable128(const LpmRoute128* routes, size_t n) {
+  std::vector<LpmRoute128> sorted(routes, routes + n);
+  for (LpmRoute128& r : sorted) {
+    assert(r.length >= 0 && r.length <= 128);
+    assert(r.value < kNoMatch);
+    r.prefix &= PrefixMask(r.length);
+  }
+  // Stable, so that of two equal routes the later one is applied last.
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const LpmRoute128& a, const LpmRoute128& b) {
+                     return a.prefix < b.prefix;
+                   });
+  Builder(this).Build(sorted.data(), sorted.data() + sorted.size());
+}
+
+uint32_t LpmTable128::Lookup(uint128_t key) const {
+#if ABSL_INT128_LPM_POPCNT
+  if (UsePopcnt()) return Walker::LookupPopcnt(*this, key);
+#endif
+  return Walker::Lookup(*this, key);
+}
+
+void LpmTable128::LookupN(const uint128_t* keys, size_t n,
+                          uint32_t* values) const {
+#if ABSL_INT128_LPM_POPCNT
+  if (UsePopcnt()) return Walker::LookupNPopcnt(*this, keys, n, values);
+#endif
+  Walker::LookupN(*this, keys, n, values);
+}
+
+size_t LpmTable128::MemoryUsage() const {
+  return sizeof(*this) + direct_.capacity() * sizeof(direct_[0]) +
+         nodes_.capacity() * sizeof(nodes_[0]) +
+         values_.capacity() * sizeof(values_[0]);
+}
+
+}  // namespace absl
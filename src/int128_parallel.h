@@ -0,0 +1,80 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Helpers shared by the library sources for splitting array operations
+// across OpenMP threads. Not part of the public interface.
+
+#ifndef ABSL_INT128_PARALLEL_H_
+#define ABSL_INT128_PARALLEL_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "int128_kernels.h"
+
+namespace absl {
+namespace int128_t_internal {
+
+// Below this many elements per thread, starting threads costs more than it
+// saves.
+constexpr size_t kMinParallelChunk = size_t{1} << 16;
+
+// Returns the number of contiguous chunks to split `n` elements into: one per
+// OpenMP thread for `Execution::kParallel`, and one otherwise.
+inline size_t ChunkCount(size_t n, Execution execution) {
+  size_t chunks = 1;
+#ifdef _OPENMP
+  if (execution == Execution::kParallel) {
+    chunks = std::min(static_cast<size_t>(omp_get_max_threads()),
+                      n / kMinParallelChunk);
+    if (chunks == 0) chunks = 1;
+  }
+#endif  // _OPENMP
+  static_cast<void>(n);
+  static_cast<void>(execution);
+  return chunks;
+}
+
+// Calls `f(i)` for each `i` in [0, count), on up to `threads` threads.
+template <typename F>
+void ParallelFor(size_t count, size_t threads, F f) {
+  if (threads <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; ++i) f(i);
+    return;
+  }
+  const long end = static_cast<long>(count);  // NOLINT(runtime/int)
+  const int num_threads = static_cast<int>(std::min(threads, count));
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (long i = 0; i < end; ++i) {  // NOLINT(runtime/int)
+    f(static_cast<size_t>(i));
+  }
+}
+
+// Calls `f(c, begin, end)` for each of `chunks` contiguous chunks of [0, n),
+// one thread per chunk.
+template <typename F>
+void ForEachChunk(size_t n, size_t chunks, F f) {
+  ParallelFor(chunks, chunks,
+              [&](size_t c) { f(c, n * c / chunks, n * (c + 1) / chunks); });
+}
+
+}  // namespace int128_t_internal
+}  // namespace absl
+
+#endif  // ABSL_INT128_PARALLEL_H_
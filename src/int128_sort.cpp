@@ -0,0 +1,338 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_sort.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "int128_parallel.h"
+
+namespace absl {
+
+namespace {
+
+using int128_t_internal::ChunkCount;
+using int128_t_internal::ForEachChunk;
+using int128_t_internal::ParallelFor;
+
+// Each 64-bit limb splits into six digits of 11, 11, 11, 11, 10 and 10 bits,
+// so that no digit straddles the limbs. That is 12 passes instead of the 16
+// that 8-bit digits take, for histograms that still fit in L2.
+constexpr int kDigitsPerLimb = 6;
+constexpr int kDigits = 2 * kDigitsPerLimb;
+constexpr int kRadix = 1 << 11;
+constexpr int kDigitShift[kDigitsPerLimb] = {0, 11, 22, 33, 44, 54};
+constexpr uint64_t kDigitMask[kDigitsPerLimb] = {0x7ff, 0x7ff, 0x7ff,
+                                                 0x7ff, 0x3ff, 0x3ff};
+
+// Below this many keys, insertion sort beats the fixed cost of the passes.
+constexpr size_t kInsertionSortThreshold = 64;
+
+using Histogram = std::array<size_t, kRadix>;
+using DigitHistograms = std::array<Histogram, kDigits>;
+
+// Stands in for the values array of a keys-only sort.
+struct NoValue {};
+
+// The digit of int128_t keys holding the sign bit is flipped, so that
+// negative keys order before non-negative ones.
+template <typename T>
+constexpr unsigned TopDigitFlip() {
+  return std::is_same<T, int128_t>::value
+             ? static_cast<unsigned>(kDigitMask[kDigitsPerLimb - 1] / 2 + 1)
+             : 0;
+}
+
+// Extracts digit `d`, counting from the least significant, of a key.
+template <typename T>
+class DigitOf {
+ public:
+  explicit DigitOf(int d)
+      : high_(d >= kDigitsPerLimb),
+        shift_(kDigitShift[d % kDigitsPerLimb]),
+        mask_(kDigitMask[d % kDigitsPerLimb]),
+        flip_(d == kDigits - 1 ? TopDigitFlip<T>() : 0) {}
+
+  unsigned operator()(T key) const {
+    const uint128_t v(key);
+    const uint64_t limb = high_ ? Uint128High64(v) : Uint128Low64(v);
+    return static_cast<unsigned>((limb >> shift_) & mask_) ^ flip_;
+  }
+
+ private:
+  bool high_;
+  int shift_;
+  uint64_t mask_;
+  unsigned flip_;
+};
+
+// Counts every digit of `keys[begin, end)` in one read.
+template <typename T>
+void CountDigits(const T* keys, size_t begin, size_t end,
+                 DigitHistograms* histograms) {
+  DigitHistograms& h = *histograms;
+  for (size_t i = begin; i < end; ++i) {
+    const uint128_t v(keys[i]);
+    const uint64_t lo = Uint128Low64(v);
+    const uint64_t hi = Uint128High64(v);
+    for (int d = 0; d < kDigitsPerLimb; ++d) {
+      ++h[d][(lo >> kDigitShift[d]) & kDigitMask[d]];
+      ++h[kDigitsPerLimb + d][(hi >> kDigitShift[d]) & kDigitMask[d]];
+    }
+  }
+  if (TopDigitFlip<T>() != 0) {
+    // Counted unflipped above; swap the two halves of the top histogram.
+    Histogram& top = h[kDigits - 1];
+    const unsigned half = TopDigitFlip<T>();
+    std::swap_ranges(top.begin(), top.begin() + half, top.begin() + half);
+  }
+}
+
+// Stable insertion sort, for inputs too small to be worth the passes.
+template <typename T, typename V>
+void InsertionSort(T* keys, V* values, size_t n) {
+  constexpr bool kHasValues = !std::is_same<V, NoValue>::value;
+  for (size_t i = 1; i < n; ++i) {
+    const T key = keys[i];
+    size_t j = i;
+    if (kHasValues) {
+      const V value = values[i];
+      for (; j > 0 && key < keys[j - 1]; --j) {
+        keys[j] = keys[j - 1];
+        values[j] = values[j - 1];
+      }
+      values[j] = value;
+    } else {
+      for (; j > 0 && key < keys[j - 1]; --j) keys[j] = keys[j - 1];
+    }
+    keys[j] = key;
+  }
+}
+
+// With several chunks, each chunk scatters its keys into its own slice of
+// every bucket, and the slices are laid out in chunk order, which keeps the
+// sort stable. Each pass recounts its digit per chunk, since the previous
+// pass moved keys between chunks.
+template <typename T, typename V>
+void RadixSortImpl(T* keys, V* values, size_t n, Execution execution) {
+  constexpr bool kHasValues = !std::is_same<V, NoValue>::value;
+  if (n < kInsertionSortThreshold) {
+    InsertionSort(keys, values, n);
+    return;
+  }
+  const size_t chunks = ChunkCount(n, execution);
+
+  std::vector<DigitHistograms> chunk_histograms(chunks);
+  ForEachChunk(n, chunks, [&](size_t c, size_t begin, size_t end) {
+    DigitHistograms& h = chunk_histograms[c];
+    for (Histogram& digit : h) digit.fill(0);
+    CountDigits(keys, begin, end, &h);
+  });
+  DigitHistograms total = chunk_histograms[0];
+  for (size_t c = 1; c < chunks; ++c) {
+    for (int d = 0; d < kDigits; ++d) {
+      for (int b = 0; b < kRadix; ++b) {
+        total[d][b] += chunk_histograms[c][d][b];
+      }
+    }
+  }
+
+  std::unique_ptr<T[]> key_buffer(new T[n]);
+  std::unique_ptr<V[]> value_buffer(kHasValues ? new V[n] : nullptr);
+  T* src = keys;
+  T* dst = key_buffer.get();
+  V* src_values = values;
+  V* dst_values = value_buffer.get();
+
+  std::vector<Histogram> offsets(chunks);
+  for (int d = 0; d < kDigits; ++d) {
+    const Histogram& digit_total = total[d];
+    if (std::find(digit_total.begin(), digit_total.end(), n) !=
+        digit_total.end()) {
+      continue;  // All keys share this digit.
+    }
+    const DigitOf<T> digit(d);
+
+    if (chunks == 1) {
+      offsets[0] = digit_total;
+    } else {
+      ForEachChunk(n, chunks, [&](size_t c, size_t begin, size_t end) {
+        Histogram& h = offsets[c];
+        h.fill(0);
+        for (size_t i = begin; i < end; ++i) ++h[digit(src[i])];
+      });
+    }
+    size_t sum = 0;
+    for (int b = 0; b < kRadix; ++b) {
+      for (size_t c = 0; c < chunks; ++c) {
+        const size_t count = offsets[c][b];
+        offsets[c][b] = sum;
+        sum += count;
+      }
+    }
+
+    ForEachChunk(n, chunks, [&](size_t c, size_t begin, size_t end) {
+      Histogram& next = offsets[c];
+      for (size_t i = begin; i < end; ++i) {
+        const size_t to = next[digit(src[i])]++;
+        dst[to] = src[i];
+        if (kHasValues) dst_values[to] = src_values[i];
+      }
+    });
+    std::swap(src, dst);
+    std::swap(src_values, dst_values);
+  }
+
+  if (src != keys) {
+    ForEachChunk(n, chunks, [&](size_t, size_t begin, size_t end) {
+      std::copy(src + begin, src + end, keys + begin);
+      if (kHasValues) {
+        std::copy(src_values + begin, src_values + end, values + begin);
+      }
+    });
+  }
+}
+
+// Returns how many elements of `a` are among the first `diagonal` outputs of
+// a stable merge of `a` and `b`, where ties take `a` first.
+template <typename T>
+size_t MergePathSplit(const T* a, size_t a_size, const T* b, size_t b_size,
+                      size_t diagonal) {
+  size_t lo = diagonal > b_size ? diagonal - b_size : 0;
+  size_t hi = std::min(diagonal, a_size);
+  while (lo < hi) {
+    const size_t i = lo + (hi - lo) / 2;
+    if (b[diagonal - i - 1] < a[i]) {
+      hi = i;
+    } else {
+      lo = i + 1;
+    }
+  }
+  return lo;
+}
+
+// One piece of a merge round: merges a[0, a_size) and b[0, b_size) into out.
+template <typename T>
+struct MergeTask {
+  const T* a;
+  size_t a_size;
+  const T* b;
+  size_t b_size;
+  T* out;
+};
+
+template <typename T>
+void SortImpl(T* keys, size_t n, Execution execution) {
+  const size_t chunks = ChunkCount(n, execution);
+  std::vector<size_t> runs;  // run r is [runs[r], runs[r + 1])
+  for (size_t c = 0; c <= chunks; ++c) runs.push_back(n * c / chunks);
+  ForEachChunk(n, chunks, [&](size_t, size_t begin, size_t end) {
+    std::sort(keys + begin, keys + end);
+  });
+  if (chunks == 1) return;
+
+  std::unique_ptr<T[]> buffer(new T[n]);
+  T* src = keys;
+  T* dst = buffer.get();
+  std::vector<MergeTask<T>> tasks;
+  while (runs.size() > 2) {
+    const size_t pairs = (runs.size() - 1) / 2;
+    const size_t pieces = (chunks + pairs - 1) / pairs;
+    tasks.clear();
+    std::vector<size_t> merged;
+    for (size_t r = 0; r + 1 < runs.size(); r += 2) {
+      merged.push_back(runs[r]);
+      const T* a = src + runs[r];
+      const size_t a_size = runs[r + 1] - runs[r];
+      if (r + 2 >= runs.size()) {
+        // An odd run out is copied as it is.
+        tasks.push_back({a, a_size, a + a_size, 0, dst + runs[r]});
+        continue;
+      }
+      const T* b = src + runs[r + 1];
+      const size_t b_size = runs[r + 2] - runs[r + 1];
+      const size_t total = a_size + b_size;
+      size_t from = 0;
+      size_t from_a = 0;
+      for (size_t p = 1; p <= pieces; ++p) {
+        const size_t to = total * p / pieces;
+        const size_t to_a = MergePathSplit(a, a_size, b, b_size, to);
+        tasks.push_back({a + from_a, to_a - from_a, b + (from - from_a),
+                         (to - to_a) - (from - from_a), dst + runs[r] + from});
+        from = to;
+        from_a = to_a;
+      }
+    }
+    merged.push_back(n);
+    ParallelFor(tasks.size(), chunks, [&](size_t t) {
+      const MergeTask<T>& task = tasks[t];
+      std::merge(task.a, task.a + task.a_size, task.b, task.b + task.b_size,
+                 task.out);
+    });
+    runs.swap(merged);
+    std::swap(src, dst);
+  }
+  if (src != keys) {
+    ForEachChunk(n, chunks, [&](size_t, size_t begin, size_t end) {
+      std::copy(src + begin, src + end, keys + begin);
+    });
+  }
+}
+
+}  // namespace
+
+void RadixSort(uint128_t* keys, size_t n, Execution execution) {
+  RadixSortImpl(keys, static_cast<NoValue*>(nullptr), n, execution);
+}
+
+void RadixSort(int128_t* keys, size_t n, Execution execution) {
+  RadixSortImpl(keys, static_cast<NoValue*>(nullptr), n, execution);
+}
+
+void RadixSortByKey(uint128_t* keys, uint32_t* values, size_t n,
+                    Execution execution) {
+  RadixSortImpl(keys, values, n, execution);
+}
+
+void RadixSortByKey(uint128_t* keys, uint64_t* values, size_t n,
+                    Execution execution) {
+  RadixSortImpl(keys, values, n, execution);
+}
+
+void RadixSortByKey(int128_t* keys, uint32_t* values, size_t n,
+                    Execution execution) {
+  RadixSortImpl(keys, values, n, execution);
+}
+
+void RadixSortByKey(int128_t* keys, uint64_t* values, size_t n,
+                    Execution execution) {
+  RadixSortImpl(keys, values, n, execution);
+}
+
+void Sort(uint128_t* keys, size_t n, Execution execution) {
+  SortImpl(keys, n, execution);
+}
+
+void Sort(int128_t* keys, size_t n, Execution execution) {
+  SortImpl(keys, n, execution);
+}
+
+}  // namespace absl
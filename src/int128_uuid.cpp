@@ -0,0 +1,294 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_uuid.h"
+
+#include "int128_kernels.h"
+
+// Every kernel level above the portable one implies SSSE3, which provides
+// the byte shuffles the vector paths are built on.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ABSL_INT128_UUID_SSSE3 1
+#include <immintrin.h>
+#define ABSL_INT128_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define ABSL_INT128_UUID_SSSE3 0
+#endif
+
+namespace absl {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+// The positions of the 32 hex digits in the canonical form, in order.
+constexpr uint8_t kDigitPositions[32] = {
+    0,  1,  2,  3,  4,  5,  6,  7,  9,  10, 11, 12, 14, 15, 16, 17,
+    19, 20, 21, 22, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35};
+
+// The value of each hex digit by character, and -1 for other characters. A
+// table avoids the poorly predicted branches between digits and letters.
+struct HexTable {
+  int8_t values[256];
+
+  constexpr HexTable() : values() {
+    for (int c = 0; c < 256; ++c) {
+      values[c] = c >= '0' && c <= '9'   ? static_cast<int8_t>(c - '0')
+                  : c >= 'a' && c <= 'f' ? static_cast<int8_t>(c - 'a' + 10)
+                  : c >= 'A' && c <= 'F' ? static_cast<int8_t>(c - 'A' + 10)
+                                         : int8_t{-1};
+    }
+  }
+};
+
+constexpr HexTable kHexTable;
+
+inline bool HasHyphens(const char* text) {
+  return text[8] == '-' && text[13] == '-' && text[18] == '-' &&
+         text[23] == '-';
+}
+
+struct PortableCodec {
+  static bool Parse(const char* text, uint128_t* value) {
+    if (!HasHyphens(text)) return false;
+    uint64_t halves[2] = {0, 0};
+    int invalid = 0;
+    for (int i = 0; i < 32; ++i) {
+      const int digit =
+          kHexTable.values[static_cast<uint8_t>(text[kDigitPositions[i]])];
+      invalid |= digit;
+      halves[i / 16] = halves[i / 16] << 4 | static_cast<uint64_t>(digit & 0xf);
+    }
+    if (invalid < 0) return false;
+    *value = MakeUint128(halves[0], halves[1]);
+    return true;
+  }
+
+  static void Format(uint128_t value, char* out) {
+    const uint64_t halves[2] = {Uint128High64(value), Uint128Low64(value)};
+    for (int i = 0; i < 32; ++i) {
+      const int shift = 60 - 4 * (i % 16);
+      out[kDigitPositions[i]] = kHexDigits[halves[i / 16] >> shift & 0xf];
+    }
+    out[8] = out[13] = out[18] = out[23] = '-';
+  }
+};
+
+#if ABSL_INT128_UUID_SSSE3
+
+// Reverses the bytes of each 64-bit half.
+#define ABSL_INT128_UUID_BSWAP64 \
+  7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+
+struct Ssse3Codec {
+  // Gathers the 32 digits into two vectors with one shuffle per load: the
+  // first holds text [0, 8), [9, 13), [14, 18), and the second [19, 23),
+  // [24, 36). The last load ends at the last character, so nothing past the
+  // UUID is read.
+  ABSL_INT128_TARGET_SSSE3 static bool Parse(const char* text,
+                                             uint128_t* value) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + 16));
+    const __m128i c =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + 20));
+    const __m128i hyphen = _mm_set1_epi8('-');
+    const int hyphens_a = _mm_movemask_epi8(_mm_cmpeq_epi8(a, hyphen));
+    const int hyphens_b = _mm_movemask_epi8(_mm_cmpeq_epi8(b, hyphen));
+    if ((hyphens_a & 0x2100) != 0x2100 || (hyphens_b & 0x84) != 0x84) {
+      return false;
+    }
+    const __m128i first = _mm_or_si128(
+        _mm_shuffle_epi8(a, _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 9, 10, 11,
+                                          12, 14, 15, -1, -1)),
+        _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                          -1, -1, -1, -1, -1, 0, 1)));
+    const __m128i second = _mm_or_si128(
+        _mm_shuffle_epi8(b, _mm_setr_epi8(3, 4, 5, 6, -1, -1, -1, -1, -1, -1,
+                                          -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, 4, 5, 6, 7, 8, 9,
+                                          10, 11, 12, 13, 14, 15)));
+    __m128i high_digits;
+    __m128i low_digits;
+    if (!Digits(first, &high_digits) || !Digits(second, &low_digits)) {
+      return false;
+    }
+    // Each pair of digits becomes 16 * first + second, then a byte.
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    const __m128i bytes =
+        _mm_packus_epi16(_mm_maddubs_epi16(high_digits, weights),
+                         _mm_maddubs_epi16(low_digits, weights));
+    const __m128i halves = _mm_shuffle_epi8(
+        bytes, _mm_setr_epi8(ABSL_INT128_UUID_BSWAP64));
+    *value = MakeUint128(
+        static_cast<uint64_t>(_mm_cvtsi128_si64(halves)),
+        static_cast<uint64_t>(
+            _mm_cvtsi128_si64(_mm_unpackhi_epi64(halves, halves))));
+    return true;
+  }
+
+  // Writes text [0, 16) and [20, 36) with a shuffle each, and the four
+  // characters between them one by one.
+  ABSL_INT128_TARGET_SSSE3 static void Format(uint128_t value, char* out) {
+    const __m128i bytes = _mm_shuffle_epi8(
+        _mm_set_epi64x(static_cast<int64_t>(Uint128Low64(value)),
+                       static_cast<int64_t>(Uint128High64(value))),
+        _mm_setr_epi8(ABSL_INT128_UUID_BSWAP64));
+    const __m128i nibble = _mm_set1_epi8(0xf);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+    const __m128i low = _mm_and_si128(bytes, nibble);
+    const __m128i table = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(kHexDigits));
+    const __m128i first =
+        _mm_shuffle_epi8(table, _mm_unpacklo_epi8(high, low));
+    const __m128i second =
+        _mm_shuffle_epi8(table, _mm_unpackhi_epi8(high, low));
+    const __m128i head = _mm_or_si128(
+        _mm_shuffle_epi8(first, _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, -1, 8,
+                                              9, 10, 11, -1, 12, 13)),
+        _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, '-', 0, 0, 0, 0, '-', 0, 0));
+    const __m128i tail = _mm_or_si128(
+        _mm_shuffle_epi8(second, _mm_setr_epi8(1, 2, 3, -1, 4, 5, 6, 7, 8, 9,
+                                               10, 11, 12, 13, 14, 15)),
+        _mm_setr_epi8(0, 0, 0, '-', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 20), tail);
+    const int middle = _mm_extract_epi16(first, 7);
+    out[16] = static_cast<char>(middle);
+    out[17] = static_cast<char>(middle >> 8);
+    out[18] = '-';
+    out[19] = static_cast<char>(_mm_cvtsi128_si32(second));
+  }
+
+ private:
+  // Converts 16 hex digits to their values, returning false if any character
+  // is not one. Bytes at or above 0x80 compare as negative, so they fail both
+  // range checks.
+  ABSL_INT128_TARGET_SSSE3 static bool Digits(__m128i text, __m128i* values) {
+    const __m128i lower = _mm_or_si128(text, _mm_set1_epi8(0x20));
+    const __m128i decimal =
+        _mm_and_si128(_mm_cmpgt_epi8(text, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), text));
+    const __m128i letter =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+    if (_mm_movemask_epi8(_mm_or_si128(decimal, letter)) != 0xffff) {
+      return false;
+    }
+    *values = _mm_or_si128(
+        _mm_and_si128(decimal, _mm_sub_epi8(text, _mm_set1_epi8('0'))),
+        _mm_and_si128(letter,
+                      _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    return true;
+  }
+};
+
+#undef ABSL_INT128_UUID_BSWAP64
+
+#endif  // ABSL_INT128_UUID_SSSE3
+
+inline uint128_t ToValue(uint128_t v) { return v; }
+inline uint128_t ToValue(Uuid v) { return v.value(); }
+inline void FromValue(uint128_t v, uint128_t* out) { *out = v; }
+inline void FromValue(uint128_t v, Uuid* out) { *out = Uuid(v); }
+
+template <typename Codec, typename T>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline size_t ParseLoop(const char* text,
+                                                     size_t stride, size_t n,
+                                                     T* out) {
+  uint128_t v;
+  for (size_t i = 0; i < n; ++i, text += stride) {
+    if (!Codec::Parse(text, &v)) return i;
+    FromValue(v, out + i);
+  }
+  return n;
+}
+
+template <typename Codec, typename T>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline void FormatLoop(const T* values, size_t n,
+                                                    char* out, size_t stride) {
+  for (size_t i = 0; i < n; ++i, out += stride) {
+    Codec::Format(ToValue(values[i]), out);
+  }
+}
+
+#if ABSL_INT128_UUID_SSSE3
+
+template <typename T>
+ABSL_INT128_TARGET_SSSE3 size_t ParseSsse3(const char* text, size_t stride,
+                                           size_t n, T* out) {
+  return ParseLoop<Ssse3Codec>(text, stride, n, out);
+}
+
+template <typename T>
+ABSL_INT128_TARGET_SSSE3 void FormatSsse3(const T* values, size_t n,
+                                          char* out, size_t stride) {
+  FormatLoop<Ssse3Codec>(values, n, out, stride);
+}
+
+#endif  // ABSL_INT128_UUID_SSSE3
+
+template <typename T>
+size_t Parse(const char* text, size_t stride, size_t n, T* out) {
+#if ABSL_INT128_UUID_SSSE3
+  if (int128_t_internal::ActiveKernelLevel() !=
+      int128_t_internal::KernelLevel::kPortable) {
+    return ParseSsse3(text, stride, n, out);
+  }
+#endif  // ABSL_INT128_UUID_SSSE3
+  return ParseLoop<PortableCodec>(text, stride, n, out);
+}
+
+template <typename T>
+void Format(const T* values, size_t n, char* out, size_t stride) {
+#if ABSL_INT128_UUID_SSSE3
+  if (int128_t_internal::ActiveKernelLevel() !=
+      int128_t_internal::KernelLevel::kPortable) {
+    return FormatSsse3(values, n, out, stride);
+  }
+#endif  // ABSL_INT128_UUID_SSSE3
+  FormatLoop<PortableCodec>(values, n, out, stride);
+}
+
+}  // namespace
+
+namespace int128_t_internal {
+
+bool ParseUuid(const char* text, uint128_t* value) {
+  return Parse(text, kUuidStringLength, 1, value) == 1;
+}
+
+void FormatUuid(uint128_t value, char* out) {
+  Format(&value, 1, out, kUuidStringLength);
+}
+
+}  // namespace int128_t_internal
+
+size_t ParseUuids(const char* text, size_t stride, size_t n, uint128_t* out) {
+  return Parse(text, stride, n, out);
+}
+
+size_t ParseUuids(const char* text, size_t stride, size_t n, Uuid* out) {
+  return Parse(text, stride, n, out);
+}
+
+void FormatUuids(const uint128_t* values, size_t n, char* out, size_t stride) {
+  Format(values, n, out, stride);
+}
+
+void FormatUuids(const Uuid* uuids, size_t n, char* out, size_t stride) {
+  Format(uuids, n, out, stride);
+}
+
+}  // namespace absl
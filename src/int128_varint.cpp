@@ -0,0 +1,255 @@
+// Copyright 2017 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "int128_varint.h"
+
+#include <cstring>
+
+#include "int128_endian.h"
+#include "int128_kernels.h"
+
+// With BMI2, gathering and scattering the 7-bit groups of a word are single
+// pext and pdep instructions.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ABSL_INT128_VARINT_BMI2 1
+#include <immintrin.h>
+#define ABSL_INT128_TARGET_BMI2 __attribute__((target("bmi2")))
+#else
+#define ABSL_INT128_VARINT_BMI2 0
+#endif
+
+namespace absl {
+
+namespace {
+
+constexpr uint64_t kHighBits = 0x8080808080808080u;
+constexpr uint64_t kLowBits = 0x7f7f7f7f7f7f7f7fu;
+constexpr uint64_t kLow56 = (uint64_t{1} << 56) - 1;
+
+// The number of bytes from the start of a value that a decode may read: the
+// three words that cover `kMaxVarint128Bytes`.
+constexpr size_t kReadBytes = 24;
+
+inline uint64_t Load64(const uint8_t* p) {
+  return int128_t_internal::LittleEndian64(int128_t_internal::LoadHost64(p));
+}
+
+inline void Store64(uint8_t* p, uint64_t v) {
+  int128_t_internal::StoreHost64(p, int128_t_internal::LittleEndian64(v));
+}
+
+// Returns the bits of `x` up to and including its lowest set bit.
+inline uint64_t Through(uint64_t x) { return x ^ (x - 1); }
+
+// Returns the high bits of bytes [first, length - 1) of an encoding of
+// `length` bytes, of which the word starting at byte `first` holds 8.
+inline uint64_t Continuation(size_t length, size_t first) {
+  const size_t count = length - 1 - first;
+  return count >= 8 ? kHighBits
+                    : kHighBits & ((uint64_t{1} << (8 * count)) - 1);
+}
+
+// Gather() packs the low 7 bits of each byte of `x` into 56 bits; Scatter()
+// is its inverse.
+struct PortableBits {
+  static uint64_t Gather(uint64_t x) {
+    x &= kLowBits;
+    x = (x & 0x007f007f007f007fu) | ((x & 0x7f007f007f007f00u) >> 1);
+    x = (x & 0x00003fff00003fffu) | ((x & 0x3fff00003fff0000u) >> 2);
+    return (x & 0x000000000fffffffu) | ((x & 0x0fffffff00000000u) >> 4);
+  }
+
+  static uint64_t Scatter(uint64_t x) {
+    x = (x & 0x000000000fffffffu) | ((x & 0x00fffffff0000000u) << 4);
+    x = (x & 0x00003fff00003fffu) | ((x & 0x0fffc0000fffc000u) << 2);
+    return (x & 0x007f007f007f007fu) | ((x & 0x3f803f803f803f80u) << 1);
+  }
+};
+
+#if ABSL_INT128_VARINT_BMI2
+
+struct Bmi2Bits {
+  ABSL_INT128_TARGET_BMI2 static uint64_t Gather(uint64_t x) {
+    return _pext_u64(x, kLowBits);
+  }
+
+  ABSL_INT128_TARGET_BMI2 static uint64_t Scatter(uint64_t x) {
+    return _pdep_u64(x, kLowBits);
+  }
+};
+
+#endif  // ABSL_INT128_VARINT_BMI2
+
+template <typename Bits>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline uint8_t* EncodeOne(uint128_t v,
+                                                       uint8_t* out) {
+  const size_t length = Varint128Length(v);
+  const uint64_t low = Uint128Low64(v);
+  const uint64_t high = Uint128High64(v);
+  Store64(out, Bits::Scatter(low & kLow56) | Continuation(length, 0));
+  if (length > 8) {
+    const uint64_t middle = ((low >> 56) | (high << 8)) & kLow56;
+    Store64(out + 8, Bits::Scatter(middle) | Continuation(length, 8));
+    if (length > 16) {
+      const uint64_t top = Bits::Scatter(high >> 48) | Continuation(length, 16);
+      for (size_t i = 0; i < 3; ++i) {
+        out[16 + i] = static_cast<uint8_t>(top >> (8 * i));
+      }
+    }
+  }
+  return out + length;
+}
+
+// Decodes the value at `p`, which must be followed by `kReadBytes` readable
+// bytes. Each word's terminating byte, if any, is the lowest byte with a
+// clear high bit.
+template <typename Bits>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline const uint8_t* DecodeUnchecked(
+    const uint8_t* p, uint128_t* value) {
+  uint64_t word = Load64(p);
+  uint64_t stop = ~word & kHighBits;
+  if (stop != 0) {
+    *value = Bits::Gather(word & Through(stop));
+    return p + int128_t_internal::CountTrailingZeros64(stop) / 8 + 1;
+  }
+  const uint64_t low = Bits::Gather(word);
+  word = Load64(p + 8);
+  stop = ~word & kHighBits;
+  if (stop != 0) {
+    const uint64_t middle = Bits::Gather(word & Through(stop));
+    *value = MakeUint128(middle >> 8, low | (middle << 56));
+    return p + 8 + int128_t_internal::CountTrailingZeros64(stop) / 8 + 1;
+  }
+  const uint64_t middle = Bits::Gather(word);
+  // Only the last three bytes may hold bits, and only 16 of them.
+  word = Load64(p + 16);
+  stop = ~word & (kHighBits & 0xffffffu);
+  if (stop == 0) return nullptr;
+  const uint64_t top = Bits::Gather(word & Through(stop));
+  if (top >> 16 != 0) return nullptr;
+  *value = MakeUint128((middle >> 8) | (top << 48), low | (middle << 56));
+  return p + 16 + int128_t_internal::CountTrailingZeros64(stop) / 8 + 1;
+}
+
+// Near the end of the input, decodes from a zero-padded copy: a padding byte
+// terminates a truncated value, which is then detected by its length.
+template <typename Bits>
+const uint8_t* DecodeNearEnd(const uint8_t* p, const uint8_t* end,
+                             uint128_t* value) {
+  uint8_t buffer[kReadBytes] = {};
+  const size_t size = static_cast<size_t>(end - p);
+  std::memcpy(buffer, p, size);
+  const uint8_t* next = DecodeUnchecked<Bits>(buffer, value);
+  if (next == nullptr || static_cast<size_t>(next - buffer) > size) {
+    return nullptr;
+  }
+  return p + (next - buffer);
+}
+
+inline uint128_t ToWire(uint128_t v) { return v; }
+inline uint128_t ToWire(int128_t v) { return ZigZagEncode128(v); }
+inline void FromWire(uint128_t v, uint128_t* out) { *out = v; }
+inline void FromWire(uint128_t v, int128_t* out) { *out = ZigZagDecode128(v); }
+
+template <typename Bits, typename T>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline uint8_t* EncodeLoop(const T* values,
+                                                        size_t n,
+                                                        uint8_t* out) {
+  for (size_t i = 0; i < n; ++i) out = EncodeOne<Bits>(ToWire(values[i]), out);
+  return out;
+}
+
+template <typename Bits, typename T>
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline const uint8_t* DecodeLoop(
+    const uint8_t* p, const uint8_t* end, T* values, size_t n) {
+  uint128_t v;
+  size_t i = 0;
+  for (; i < n && static_cast<size_t>(end - p) >= kReadBytes; ++i) {
+    p = DecodeUnchecked<Bits>(p, &v);
+    if (p == nullptr) return nullptr;
+    FromWire(v, values + i);
+  }
+  for (; i < n; ++i) {
+    p = DecodeNearEnd<Bits>(p, end, &v);
+    if (p == nullptr) return nullptr;
+    FromWire(v, values + i);
+  }
+  return p;
+}
+
+#if ABSL_INT128_VARINT_BMI2
+
+template <typename T>
+ABSL_INT128_TARGET_BMI2 uint8_t* EncodeBmi2(const T* values, size_t n,
+                                            uint8_t* out) {
+  return EncodeLoop<Bmi2Bits>(values, n, out);
+}
+
+template <typename T>
+ABSL_INT128_TARGET_BMI2 const uint8_t* DecodeBmi2(const uint8_t* p,
+                                                  const uint8_t* end,
+                                                  T* values, size_t n) {
+  return DecodeLoop<Bmi2Bits>(p, end, values, n);
+}
+
+#endif  // ABSL_INT128_VARINT_BMI2
+
+template <typename T>
+uint8_t* Encode(const T* values, size_t n, uint8_t* out) {
+#if ABSL_INT128_VARINT_BMI2
+  if (int128_t_internal::UsePdep()) return EncodeBmi2(values, n, out);
+#endif
+  return EncodeLoop<PortableBits>(values, n, out);
+}
+
+template <typename T>
+const uint8_t* Decode(const uint8_t* p, const uint8_t* end, T* values,
+                      size_t n) {
+#if ABSL_INT128_VARINT_BMI2
+  if (int128_t_internal::UsePdep()) return DecodeBmi2(p, end, values, n);
+#endif
+  return DecodeLoop<PortableBits>(p, end, values, n);
+}
+
+}  // namespace
+
+uint8_t* EncodeVarint128(uint128_t v, uint8_t* out) {
+  return Encode(&v, 1, out);
+}
+
+const uint8_t* DecodeVarint128(const uint8_t* p, const uint8_t* end,
+                               uint128_t* value) {
+  return Decode(p, end, value, 1);
+}
+
+uint8_t* EncodeVarint128N(const uint128_t* values, size_t n, uint8_t* out) {
+  return Encode(values, n, out);
+}
+
+uint8_t* EncodeZigZagVarint128N(const int128_t* values, size_t n,
+                                uint8_t* out) {
+  return Encode(values, n, out);
+}
+
+const uint8_t* DecodeVarint128N(const uint8_t* p, const uint8_t* end,
+                                uint128_t* values, size_t n) {
+  return Decode(p, end, values, n);
+}
+
+const uint8_t* DecodeZigZagVarint128N(const uint8_t* p, const uint8_t* end,
+                                      int128_t* values, size_t n) {
+  return Decode(p, end, values, n);
+}
+
+}  // namespace absl
@@ -0,0 +1,233 @@
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "abslint128.h"
+
+using namespace absl;
+
+#if ABSL_INTERNAL_HAS_CONSTEXPR_CLZ
+static_assert(BitWidth(Uint128Max()) == 128, "");
+static_assert(Log2Floor(uint128_t(0)) == -1, "");
+static_assert(DecimalDigits(Uint128Max()) == 39, "");
+static_assert(DecimalDigits(Int128Min()) == 39, "");
+static_assert(Popcount(Uint128Max()) == 128, "");
+static_assert(CountrZero(MakeUint128(1, 0)) == 64, "");
+static_assert(Uint128Low64(BitCeil(MakeUint128(0, 5))) == 8, "");
+#endif
+static_assert(Uint128High64(Byteswap(MakeUint128(0, 0xff))) == 0xff00000000000000, "");
+static_assert(Uint128High64(BitReverse(uint128_t(1))) == uint64_t{1} << 63, "");
+static_assert(Uint128Low64(Rotl(MakeUint128(1, 0), 65)) == 2, "");
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what, uint128_t v)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s (%s)\n", what, uint128_t::ToString(v).c_str());
+    errors++;
+  }
+}
+
+static void CheckLog(uint128_t v)
+{
+  int digits = (int) uint128_t::ToString(v).size();
+  int width = 0;
+  for (uint128_t t = v; t != 0; t >>= 1)
+    width++;
+
+  Expect(DecimalDigits(v) == digits, "DecimalDigits", v);
+  Expect(Log10Floor(v) == (v == 0 ? -1 : digits - 1), "Log10Floor", v);
+  Expect(BitWidth(v) == width, "BitWidth", v);
+  Expect(Log2Floor(v) == width - 1, "Log2Floor", v);
+
+  int128_t s = -int128_t(v);
+  if (Int128High64(s) < 0)
+    Expect(DecimalDigits(s) + 1 == (int) int128_t::ToString(s).size(),
+      "DecimalDigits(int128_t)", v);
+}
+
+static bool Bit(uint128_t v, int i)
+{
+  return ((v >> i) & 1) != 0;
+}
+
+static void CheckBits(uint128_t v)
+{
+  int count = 0, leading = 128, trailing = 128;
+  uint128_t reversed = 0, swapped = 0;
+  for (int i = 0; i < 128; i++) {
+    if (Bit(v, i)) {
+      count++;
+      leading = 127 - i;
+      if (trailing == 128)
+        trailing = i;
+      reversed |= uint128_t(1) << (127 - i);
+    }
+  }
+  for (int i = 0; i < 16; i++)
+    swapped |= ((v >> (8 * i)) & 0xff) << (8 * (15 - i));
+
+  Expect(Popcount(v) == count, "Popcount", v);
+  Expect(CountlZero(v) == leading, "CountlZero", v);
+  Expect(CountrZero(v) == trailing, "CountrZero", v);
+  Expect(BitReverse(v) == reversed, "BitReverse", v);
+  Expect(Byteswap(v) == swapped, "Byteswap", v);
+  Expect(HasSingleBit(v) == (count == 1), "HasSingleBit", v);
+  Expect(BitFloor(v) == (v == 0 ? uint128_t(0) : uint128_t(1) << (127 - leading)),
+    "BitFloor", v);
+  if (v <= uint128_t(1) << 127) {
+    uint128_t ceil = BitCeil(v);
+    Expect(HasSingleBit(ceil) && ceil >= v && (ceil == 1 || ceil / 2 < v),
+      "BitCeil", v);
+  }
+  for (int s = -130; s <= 130; s += 7) {
+    int r = ((s % 128) + 128) % 128;
+    uint128_t expected = r == 0 ? v : (v << r) | (v >> (128 - r));
+    Expect(Rotl(v, s) == expected, "Rotl", v);
+    Expect(Rotr(expected, s) == v, "Rotr", v);
+  }
+  Expect(Rotl(v, INT_MIN) == v && Rotr(v, INT_MIN) == v, "Rotate INT_MIN", v);
+  Expect(Rotl(v, INT_MAX) == Rotr(v, 1) && Rotr(v, INT_MAX) == Rotl(v, 1),
+    "Rotate INT_MAX", v);
+}
+
+// Reference shifts, one bit at a time.
+static uint128_t ShiftLeftSlow(uint128_t v, int amount)
+{
+  for (int i = 0; i < amount; i++)
+    v = MakeUint128(Uint128High64(v) << 1 | Uint128Low64(v) >> 63,
+                    Uint128Low64(v) << 1);
+  return v;
+}
+
+static uint128_t ShiftRightSlow(uint128_t v, int amount, bool arithmetic)
+{
+  for (int i = 0; i < amount; i++) {
+    uint64_t fill = arithmetic ? Uint128High64(v) & (uint64_t{1} << 63) : 0;
+    v = MakeUint128(Uint128High64(v) >> 1 | fill,
+                    Uint128Low64(v) >> 1 | Uint128High64(v) << 63);
+  }
+  return v;
+}
+
+static void CheckShifts(uint128_t v, uint128_t w)
+{
+  int128_t sv = int128_t(v);
+  for (int s = 0; s < 128; s++) {
+    Expect((v << s) == ShiftLeftSlow(v, s), "operator<<", v);
+    Expect((v >> s) == ShiftRightSlow(v, s, false), "operator>>", v);
+    Expect(uint128_t(sv << s) == ShiftLeftSlow(v, s), "operator<<(int128_t)", v);
+    Expect(uint128_t(sv >> s) == ShiftRightSlow(v, s, true),
+      "operator>>(int128_t)", v);
+    uint128_t left = ShiftLeftSlow(v, s) | (s ? ShiftRightSlow(w, 128 - s, false) : 0);
+    uint128_t right = ShiftRightSlow(w, s, false) | (s ? ShiftLeftSlow(v, 128 - s) : 0);
+    Expect(FunnelShiftLeft(v, w, s) == left, "FunnelShiftLeft", v);
+    Expect(FunnelShiftRight(v, w, s) == right, "FunnelShiftRight", v);
+    Expect(FunnelShiftLeft(v, v, s) == Rotl(v, s), "FunnelShiftLeft(v, v)", v);
+  }
+}
+
+// The portable shifts as they were before they became branch-free, kept as a
+// baseline for shift amounts that vary unpredictably.
+static uint128_t BranchyShiftLeft(uint128_t v, int amount)
+{
+  if (amount < 64) {
+    if (amount != 0)
+      return MakeUint128(Uint128High64(v) << amount | Uint128Low64(v) >> (64 - amount),
+                         Uint128Low64(v) << amount);
+    return v;
+  }
+  return MakeUint128(Uint128Low64(v) << (amount - 64), 0);
+}
+
+static uint128_t BranchyShiftRight(uint128_t v, int amount)
+{
+  if (amount < 64) {
+    if (amount != 0)
+      return MakeUint128(Uint128High64(v) >> amount,
+                         Uint128Low64(v) >> amount | Uint128High64(v) << (64 - amount));
+    return v;
+  }
+  return MakeUint128(0, Uint128High64(v) >> (amount - 64));
+}
+
+// Times shifts by random amounts, which defeat branch prediction, against
+// the branchy baseline.
+static void BenchmarkShifts(std::mt19937_64 & random)
+{
+  // Small enough to stay in the cache, so that memory bandwidth does not hide
+  // the shifts, and too large for the branch predictor to learn.
+  const size_t n = 1 << 16, rounds = 16;
+  std::vector<std::pair<uint128_t, int>> values(n);
+  for (auto & v : values)
+    v = {uint128_t(random()) << 64 | random(), int(random() % 128)};
+  using Clock = std::chrono::steady_clock;
+  auto ns = [](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / (n * rounds);
+  };
+  uint128_t sink = 0;
+  auto t0 = Clock::now();
+  for (size_t r = 0; r < rounds; r++)
+    for (const auto & v : values) sink ^= v.first << v.second;
+  auto t1 = Clock::now();
+  for (size_t r = 0; r < rounds; r++)
+    for (const auto & v : values) sink ^= BranchyShiftLeft(v.first, v.second);
+  auto t2 = Clock::now();
+  for (size_t r = 0; r < rounds; r++)
+    for (const auto & v : values) sink ^= v.first >> v.second;
+  auto t3 = Clock::now();
+  for (size_t r = 0; r < rounds; r++)
+    for (const auto & v : values) sink ^= BranchyShiftRight(v.first, v.second);
+  auto t4 = Clock::now();
+  const uint64_t folded = Uint128High64(sink) ^ Uint128Low64(sink);
+  printf("random shift amounts: operator<< %.2f ns (branchy %.2f), "
+         "operator>> %.2f ns (branchy %.2f) (%llu)\n", ns(t1 - t0), ns(t2 - t1),
+         ns(t3 - t2), ns(t4 - t3), (unsigned long long)(folded & 1));
+}
+
+int main(int argc, char ** argv)
+{
+  uint128_t p = 1;
+  for (int k = 0; k <= 38; k++, p *= 10) {
+    CheckLog(p - 1);
+    CheckLog(p);
+    CheckLog(p + 1);
+  }
+  for (int b = 0; b < 128; b++) {
+    CheckLog(uint128_t(1) << b);
+    CheckLog((uint128_t(1) << b) - 1);
+  }
+  CheckLog(Uint128Max());
+
+  std::mt19937_64 random(1);
+  for (int i = 0; i < 100000; i++)
+    CheckLog((uint128_t(random()) << 64 | random()) >> (i % 128));
+
+  CheckBits(0);
+  CheckBits(Uint128Max());
+  for (int i = 0; i < 5000; i++) {
+    uint128_t v = (uint128_t(random()) << 64 | random()) >> (i % 128);
+    CheckBits(v);
+    CheckBits(BitFloor(v));
+  }
+
+  CheckShifts(Uint128Max(), 0);
+  CheckShifts(uint128_t(1) << 127, 1);
+  for (int i = 0; i < 200; i++)
+    CheckShifts(uint128_t(random()) << 64 | random(),
+                uint128_t(random()) << 64 | random());
+
+  BenchmarkShifts(random);
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <stdint.h>
+
+#include "abslint128.h"
+#include "int128_column.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what, size_t i)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s (element %zu)\n", what, i);
+    errors++;
+  }
+}
+
+// The columns allocate with the aligned forms of operator new. These count
+// the blocks live and fail the allocation that `fail_after` allocations
+// from now would make.
+static int live_blocks = 0;
+static int fail_after = -1;
+
+void * operator new(size_t size, std::align_val_t alignment)
+{
+  if (fail_after >= 0 && fail_after-- == 0)
+    throw std::bad_alloc();
+  const size_t align = static_cast<size_t>(alignment);
+  void * p = std::aligned_alloc(align, size == 0 ? align : (size + align - 1) / align * align);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  live_blocks++;
+  return p;
+}
+
+// Not inlined, so that GCC does not trace a pointer from operator new into
+// free() and warn of a mismatched deallocation.
+__attribute__((noinline)) void operator delete(void * p, std::align_val_t) noexcept
+{
+  if (p != nullptr) {
+    live_blocks--;
+    std::free(p);
+  }
+}
+
+void operator delete(void * p, size_t, std::align_val_t) noexcept
+{
+  operator delete(p, std::align_val_t(0));
+}
+
+// When the second of the two arrays of a reallocation cannot be allocated,
+// the first is freed and the column is left as it was.
+static void CheckAllocationFailure()
+{
+  Uint128Column column;
+  for (int i = 0; i < 8; i++)
+    column.push_back(i);
+  const int live = live_blocks;
+  fail_after = 1;
+  bool threw = false;
+  try {
+    column.reserve(1000);
+  } catch (const std::bad_alloc &) {
+    threw = true;
+  }
+  fail_after = -1;
+  Expect(threw && live_blocks == live, "allocation failure leak", 0);
+  Expect(column.size() == 8 && column[7] == 7, "allocation failure contents", 0);
+}
+
+template <typename T, typename Column>
+static void CheckColumn(const std::vector<T> & values)
+{
+  Column column(values);
+  Expect(column.size() == values.size(), "size", 0);
+  Expect(reinterpret_cast<uintptr_t>(column.hi()) % Column::kAlignment == 0 &&
+         reinterpret_cast<uintptr_t>(column.lo()) % Column::kAlignment == 0,
+    "alignment", 0);
+  for (size_t i = 0; i < values.size(); i++)
+    Expect(column[i] == values[i], "operator[]", i);
+  Expect(column.ToVector() == values, "ToVector", 0);
+
+  Column copy = column;
+  for (size_t i = 0; i < copy.size(); i++)
+    copy[i] += 1;
+  for (size_t i = 0; i < copy.size(); i++)
+    Expect(copy[i] == values[i] + 1 && column[i] == values[i], "Reference", i);
+
+  Column grown;
+  for (const T & v : values)
+    grown.push_back(v);
+  grown.resize(values.size() + 3);
+  for (size_t i = 0; i < values.size(); i++)
+    Expect(grown[i] == values[i], "push_back", i);
+  for (size_t i = values.size(); i < grown.size(); i++)
+    Expect(grown[i] == 0, "resize", i);
+}
+
+int main(int argc, char ** argv)
+{
+  std::mt19937_64 random(1);
+  for (size_t n : {0, 1, 7, 8, 9, 1000}) {
+    std::vector<uint128_t> u;
+    std::vector<int128_t> s;
+    for (size_t i = 0; i < n; i++) {
+      u.push_back(MakeUint128(random(), random()));
+      s.push_back(MakeInt128(static_cast<int64_t>(random()), random()));
+    }
+    CheckColumn<uint128_t, Uint128Column>(u);
+    CheckColumn<int128_t, Int128Column>(s);
+  }
+  CheckAllocationFailure();
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
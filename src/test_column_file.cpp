@@ -0,0 +1,233 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_column.h"
+#include "int128_column_file.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// The process ID keeps concurrent runs from sharing files.
+static std::string TempPath(const char * name)
+{
+  return "/tmp/test_column_file_" + std::to_string(getpid()) + "_" + name +
+         ".col";
+}
+
+static std::vector<uint8_t> ReadFile(const std::string & path)
+{
+  std::vector<uint8_t> contents;
+  if (FILE * file = fopen(path.c_str(), "rb")) {
+    uint8_t buffer[4096];
+    for (size_t got; (got = fread(buffer, 1, sizeof(buffer), file)) != 0;) {
+      contents.insert(contents.end(), buffer, buffer + got);
+    }
+    fclose(file);
+  }
+  return contents;
+}
+
+static void WriteFile(const std::string & path, const std::vector<uint8_t> & contents)
+{
+  FILE * file = fopen(path.c_str(), "wb");
+  fwrite(contents.data(), 1, contents.size(), file);
+  fclose(file);
+}
+
+static void CheckXxh64()
+{
+  using int128_t_internal::Xxh64;
+  const char * text = "Nobody inspects the spammish repetition";
+  Expect(Xxh64("", 0) == 0xef46db3751d8e999u, "Xxh64 empty");
+  Expect(Xxh64("a", 1) == 0xd24ec4f1a98c6e5bu, "Xxh64 a");
+  Expect(Xxh64("abc", 3) == 0x44bc2cf5ad770999u, "Xxh64 abc");
+  Expect(Xxh64(text, strlen(text)) == 0xfbcea83c8a378bf1u, "Xxh64 long");
+}
+
+template <typename T>
+static void CheckRoundTrip(const std::vector<T> & values, const ColumnFileOptions & options)
+{
+  const std::string path = TempPath("round_trip");
+  std::string error;
+  Expect(WriteColumnFile(path, values.data(), values.size(), options, &error),
+         "WriteColumnFile");
+  BasicMappedColumn<T> mapped;
+  Expect(mapped.Open(path, &error), error.c_str());
+  Expect(mapped.size() == values.size() && mapped.layout() == options.layout &&
+         mapped.byte_order() == options.byte_order, "BasicMappedColumn header");
+  Expect(mapped.VerifyChecksum(), "VerifyChecksum");
+
+  const bool host = options.byte_order == ColumnByteOrder::kHost;
+  const bool interleaved = options.layout == ColumnLayout::kInterleaved;
+  Expect(mapped.zero_copy() == host, "zero_copy");
+  Expect((mapped.data() != nullptr) == (host && interleaved), "data");
+  Expect((mapped.hi() != nullptr) == (host && !interleaved), "hi");
+  if (mapped.data() != nullptr && !values.empty()) {
+    Expect(std::memcmp(mapped.data(), values.data(), 16 * values.size()) == 0,
+           "data contents");
+    Expect(reinterpret_cast<uintptr_t>(mapped.data()) % 64 == 0, "data alignment");
+  }
+  if (mapped.hi() != nullptr) {
+    for (size_t i = 0; i < values.size(); i++) {
+      Expect(mapped.hi()[i] == int128_t_internal::ColumnTraits<T>::HighOf(values[i]) &&
+             mapped.lo()[i] == int128_t_internal::ColumnTraits<T>::LowOf(values[i]),
+             "hi/lo contents");
+    }
+  }
+  bool same = true;
+  for (size_t i = 0; i < values.size(); i++) same &= mapped[i] == values[i];
+  Expect(same, "operator[]");
+  if (values.size() > 10) {
+    std::vector<T> out(values.size() - 10);
+    mapped.Read(3, out.size(), out.data());
+    Expect(std::equal(out.begin(), out.end(), values.begin() + 3), "Read");
+  }
+
+  // The same values from a column.
+  BasicInt128Column<T> column(values);
+  Expect(WriteColumnFile(TempPath("column"), column, options, &error),
+         "WriteColumnFile(column)");
+  Expect(ReadFile(TempPath("column")) == ReadFile(path), "column file contents");
+}
+
+static void CheckFormat()
+{
+  // The documented layout, byte by byte.
+  const std::vector<uint128_t> values = {MakeUint128(0x0102030405060708u, 0x090a0b0c0d0e0f10u)};
+  const std::string path = TempPath("format");
+  ColumnFileOptions options;
+  options.byte_order = ColumnByteOrder::kBigEndian;
+  options.layout = ColumnLayout::kSplit;
+  Expect(WriteColumnFile(path, values.data(), 1, options), "WriteColumnFile format");
+  const std::vector<uint8_t> contents = ReadFile(path);
+  Expect(contents.size() == 64 + 16, "file size");
+  Expect(contents.size() == 80 && std::memcmp(contents.data(), "I128COL\0", 8) == 0 &&
+         contents[8] == 1 && contents[12] == 1 && contents[13] == 0 &&
+         contents[14] == 1 && contents[15] == 1 && contents[16] == 1,
+         "header bytes");
+  const uint8_t data[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  Expect(contents.size() == 80 && std::memcmp(contents.data() + 64, data, 16) == 0,
+         "big-endian split data");
+  uint64_t checksum = 0;
+  for (int i = 0; i < 8; i++) checksum |= uint64_t(contents[24 + i]) << (8 * i);
+  Expect(checksum == int128_t_internal::Xxh64(data, 16), "header checksum");
+}
+
+static void CheckErrors()
+{
+  std::string error;
+  MappedUint128Column mapped;
+  Expect(!mapped.Open("/nonexistent/file.col", &error) && !error.empty(), "missing file");
+
+  const std::vector<int128_t> values = {-1, 2, -3};
+  const std::string path = TempPath("errors");
+  Expect(WriteColumnFile(path, values.data(), values.size()), "WriteColumnFile errors");
+  Expect(!mapped.Open(path, &error) && error.find("int128_t") != std::string::npos,
+         "signedness mismatch");
+  MappedInt128Column good;
+  Expect(good.Open(path, &error) && good[0] == -1 && good.VerifyChecksum(), "Open");
+
+  const std::vector<uint8_t> contents = ReadFile(path);
+  struct Corruption { size_t offset; const char * what; bool opens; };
+  for (Corruption c : {Corruption{0, "magic", false}, Corruption{8, "version", false},
+                       Corruption{12, "byte order", true}, Corruption{14, "layout", true},
+                       Corruption{15, "flags", false}, Corruption{16, "count", false},
+                       Corruption{40, "reserved", false}, Corruption{70, "data", true}}) {
+    std::vector<uint8_t> bad(contents);
+    bad[c.offset] ^= c.offset == 12 || c.offset == 14 ? 1 : 0x40;
+    WriteFile(path, bad);
+    MappedInt128Column reopened;
+    const bool opened = reopened.Open(path, &error);
+    Expect(opened == c.opens, c.what);
+    // Flipping the byte order or layout, or any data byte, fails the checksum.
+    Expect(!opened || !reopened.VerifyChecksum() || c.offset == 12 || c.offset == 14,
+           c.what);
+    if (c.offset == 70) Expect(opened && !reopened.VerifyChecksum(), "data checksum");
+  }
+  std::vector<uint8_t> truncated(contents.begin(), contents.end() - 1);
+  WriteFile(path, truncated);
+  Expect(!good.Open(path, &error) && !good.is_open(), "truncated");
+
+  Expect(!WriteColumnFile("/nonexistent/dir/file.col", values.data(), values.size(),
+                          ColumnFileOptions(), &error) && !error.empty(),
+         "WriteColumnFile error");
+}
+
+static void Benchmark()
+{
+  const size_t n = 1 << 22;
+  std::mt19937_64 random(44);
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = MakeUint128(random(), random());
+  const std::string path = TempPath("benchmark");
+  using Clock = std::chrono::steady_clock;
+  auto ms = [](Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+  ColumnFileOptions swapped;
+  swapped.byte_order = ColumnByteOrder::kBigEndian;
+  for (const ColumnFileOptions & options : {ColumnFileOptions(), swapped}) {
+    WriteColumnFile(path, values.data(), n, options);
+    auto t0 = Clock::now();
+    MappedUint128Column mapped;
+    mapped.Open(path);
+    auto t1 = Clock::now();
+    std::vector<uint128_t> out(n);
+    mapped.Read(0, n, out.data());
+    auto t2 = Clock::now();
+    Expect(out == values, "benchmark round trip");
+    printf("%s, %zu values: open %.3f ms, read all %.1f ms\n",
+           mapped.zero_copy() ? "host order" : "swapped", n, ms(t1 - t0), ms(t2 - t1));
+  }
+  std::remove(path.c_str());
+}
+
+int main()
+{
+  CheckXxh64();
+  std::mt19937_64 random(44);
+  for (size_t n : {0, 1, 5, 10000}) {
+    std::vector<uint128_t> u(n);
+    std::vector<int128_t> s(n);
+    for (size_t i = 0; i < n; i++) {
+      u[i] = MakeUint128(random(), random());
+      s[i] = int128_t(u[i]);
+    }
+    for (ColumnByteOrder order : {ColumnByteOrder::kLittleEndian, ColumnByteOrder::kBigEndian}) {
+      for (ColumnLayout layout : {ColumnLayout::kInterleaved, ColumnLayout::kSplit}) {
+        for (bool checksum : {true, false}) {
+          ColumnFileOptions options;
+          options.byte_order = order;
+          options.layout = layout;
+          options.checksum = checksum;
+          CheckRoundTrip(u, options);
+          CheckRoundTrip(s, options);
+        }
+      }
+    }
+  }
+  CheckFormat();
+  CheckErrors();
+  Benchmark();
+  for (const char * name : {"round_trip", "column", "format", "errors"}) {
+    std::remove(TempPath(name).c_str());
+  }
+  printf("Done!\n");
+  return errors != 0;
+}
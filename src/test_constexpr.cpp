@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ios>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "abslint128.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// Tables derived by code at compile time.
+
+struct Pow10Table
+{
+  uint128_t values[39];
+};
+
+static constexpr Pow10Table MakePow10Table()
+{
+  Pow10Table table = {};
+  uint128_t power = 1;
+  for (int i = 0; i < 39; i++) {
+    table.values[i] = power;
+    power *= 10;
+  }
+  return table;
+}
+
+static constexpr Pow10Table kPow10 = MakePow10Table();
+
+static constexpr bool SameAsPowersOf10()
+{
+  for (int i = 0; i < 39; i++) {
+    if (kPow10.values[i] != int128_t_internal::kPowersOf10[i]) return false;
+    if (i > 0 && kPow10.values[i] / kPow10.values[i - 1] != 10) return false;
+    if (i > 0 && kPow10.values[i] % kPow10.values[i - 1] != 0) return false;
+  }
+  return true;
+}
+static_assert(SameAsPowersOf10(), "powers of 10");
+
+// floor((2^128 - 1) / 10^19), a reciprocal for dividing by 10^19.
+static constexpr uint128_t kReciprocal = Uint128Max() / kPow10.values[19];
+static_assert(kReciprocal == MakeUint128(0x1, 0xd83c94fb6d2ac34a), "reciprocal");
+static_assert(Uint128Max() % kPow10.values[19] == 0x2ed503946aefffffu, "remainder");
+static_assert(MakeUint128(0x123456789abcdef0, 0x0fedcba987654321) /
+              MakeUint128(0x1234, 0x5678) == 0x10004c016906bu, "quotient below 2^64");
+static_assert(int128_t(-7) / 2 == -3 && int128_t(-7) % 2 == -1, "truncation");
+static_assert(Int128Min() / -2 == MakeInt128(0x4000000000000000, 0), "Int128Min");
+
+// Formatted text, checked at compile time.
+
+struct Text
+{
+  char data[130];
+  int size;
+};
+
+template <typename T>
+static constexpr Text Format(T v, int base)
+{
+  Text text = {};
+  char * end = ToChars(text.data, text.data + sizeof(text.data), v, base);
+  text.size = end == nullptr ? -1 : static_cast<int>(end - text.data);
+  return text;
+}
+
+static constexpr bool Equals(const Text & text, const char * expected)
+{
+  int size = 0;
+  while (expected[size] != '\0') size++;
+  if (text.size != size) return false;
+  for (int i = 0; i < size; i++) {
+    if (text.data[i] != expected[i]) return false;
+  }
+  return true;
+}
+
+static_assert(Equals(Format(Uint128Max(), 10), "340282366920938463463374607431768211455"),
+              "Uint128Max");
+static_assert(Equals(Format(Int128Min(), 10), "-170141183460469231731687303715884105728"),
+              "Int128Min");
+static_assert(Equals(Format(Int128Max(), 16), "7fffffffffffffffffffffffffffffff"), "hex");
+static_assert(Equals(Format(uint128_t(0), 10), "0"), "zero");
+static_assert(Equals(Format(kPow10.values[19], 10), "10000000000000000000"), "10^19");
+static_assert(Equals(Format(Uint128Max(), 36), "f5lxx1zz5pnorynqglhzmsp33"), "base 36");
+static_assert(Format(Uint128Max(), 2).size == 128, "base 2");
+
+static void CheckDivision(std::mt19937_64 & random)
+{
+#if defined(__SIZEOF_INT128__)
+  // Operands of every width, so that each path of DivMod is taken.
+  bool same = true;
+  for (int i = 0; i < 200000; i++) {
+    const int a_bits = static_cast<int>(random() % 129);
+    const int b_bits = static_cast<int>(random() % 128) + 1;
+    uint128_t a = MakeUint128(random(), random());
+    uint128_t b = MakeUint128(random(), random());
+    a = a_bits == 0 ? uint128_t(0) : a >> (128 - a_bits);
+    b = b >> (128 - b_bits) | 1;
+    uint128_t q, r;
+    uint128_t::DivMod(a, b, &q, &r);
+    const unsigned __int128 wa = static_cast<unsigned __int128>(Uint128High64(a)) << 64 |
+                                 Uint128Low64(a);
+    const unsigned __int128 wb = static_cast<unsigned __int128>(Uint128High64(b)) << 64 |
+                                 Uint128Low64(b);
+    same &= q == MakeUint128(static_cast<uint64_t>((wa / wb) >> 64),
+                             static_cast<uint64_t>(wa / wb));
+    same &= r == MakeUint128(static_cast<uint64_t>((wa % wb) >> 64),
+                             static_cast<uint64_t>(wa % wb));
+
+    const int128_t sa(a), sb(b);
+    if (sa == Int128Min() && sb == -1) continue;
+    const __int128 na = static_cast<__int128>(wa), nb = static_cast<__int128>(wb);
+    same &= sa / sb == int128_t(uint128_t(MakeUint128(
+                           static_cast<uint64_t>(static_cast<unsigned __int128>(na / nb) >> 64),
+                           static_cast<uint64_t>(na / nb))));
+    same &= sa % sb == int128_t(uint128_t(MakeUint128(
+                           static_cast<uint64_t>(static_cast<unsigned __int128>(na % nb) >> 64),
+                           static_cast<uint64_t>(na % nb))));
+  }
+  Expect(same, "DivMod");
+#endif
+
+  // Quotients whose estimate is off by one in either direction.
+  const uint128_t b = MakeUint128(0x8000000000000000u, 1);
+  uint128_t q, r;
+  uint128_t::DivMod(Uint128Max(), b, &q, &r);
+  Expect(q == 1 && r == Uint128Max() - b, "DivMod large divisor");
+  uint128_t::DivMod(MakeUint128(1, 0), MakeUint128(1, 1), &q, &r);
+  Expect(q == 0 && r == MakeUint128(1, 0), "DivMod divisor above dividend");
+  uint128_t::DivMod(Uint128Max(), MakeUint128(1, 0xffffffffffffffffu), &q, &r);
+  Expect(q == MakeUint128(0, 0x8000000000000000u) && r == 0x7fffffffffffffffu,
+         "DivMod 2^65 - 1");
+}
+
+static void CheckToChars(std::mt19937_64 & random)
+{
+  char buffer[130];
+  bool same = true;
+  for (int i = 0; i < 20000; i++) {
+    const uint128_t v = MakeUint128(random(), random()) >> (random() % 128);
+    for (auto base : {std::ios_base::oct, std::ios_base::dec, std::ios_base::hex}) {
+      const int radix = base == std::ios_base::oct ? 8 : base == std::ios_base::dec ? 10 : 16;
+      char * end = ToChars(buffer, buffer + sizeof(buffer), v, radix);
+      same &= end != nullptr &&
+              std::string(buffer, end) == uint128_t::ToFormattedString(v, base);
+    }
+    const int128_t s(v);
+    char * end = ToChars(buffer, buffer + sizeof(buffer), s);
+    same &= end != nullptr && std::string(buffer, end) == int128_t::ToFormattedString(s);
+
+    // Any base, parsed back digit by digit.
+    const int radix = static_cast<int>(random() % 35) + 2;
+    end = ToChars(buffer, buffer + sizeof(buffer), v, radix);
+    uint128_t parsed = 0;
+    for (char * p = buffer; p != end; p++) {
+      parsed = parsed * radix + static_cast<int>(*p <= '9' ? *p - '0' : *p - 'a' + 10);
+    }
+    same &= end != nullptr && parsed == v && (v == 0 || buffer[0] != '0');
+  }
+  Expect(same, "ToChars");
+
+  // Exactly enough room, then one character too little.
+  const size_t length = strlen("340282366920938463463374607431768211455");
+  Expect(ToChars(buffer, buffer + length, Uint128Max()) == buffer + length, "ToChars fits");
+  Expect(ToChars(buffer, buffer + length - 1, Uint128Max()) == nullptr, "ToChars too small");
+  Expect(ToChars(buffer, buffer, int128_t(-1)) == nullptr, "ToChars no room for sign");
+  Expect(ToChars(buffer, buffer + 1, int128_t(-1)) == nullptr, "ToChars no room for digit");
+  Expect(uint128_t::ToString(Uint128Max()) == "340282366920938463463374607431768211455",
+         "ToString");
+  Expect(int128_t::ToString(Int128Min()) == "-170141183460469231731687303715884105728",
+         "ToString int128_t");
+}
+
+static void Benchmark(std::mt19937_64 & random)
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = MakeUint128(random(), random());
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  volatile uint64_t small_divisor = 10;
+  const uint128_t divisor = small_divisor;
+  const uint128_t large_divisor = MakeUint128(random() >> 20, random());
+  uint64_t sink = 0;
+  auto t0 = Clock::now();
+  for (const uint128_t & v : values) sink += Uint128Low64(v / divisor);
+  auto t1 = Clock::now();
+  for (const uint128_t & v : values) sink += Uint128Low64(v / large_divisor);
+  auto t2 = Clock::now();
+  char buffer[39];
+  for (const uint128_t & v : values) sink += ToChars(buffer, buffer + sizeof(buffer), v) - buffer;
+  auto t3 = Clock::now();
+  printf("divide by 10 %.2f ns, by a large divisor %.2f ns, ToChars %.2f ns (%llu)\n", ns(t1 - t0),
+         ns(t2 - t1), ns(t3 - t2), static_cast<unsigned long long>(sink % 10));
+}
+
+int main()
+{
+  std::mt19937_64 random(47);
+  CheckDivision(random);
+  CheckToChars(random);
+  Benchmark(random);
+  printf("Done!\n");
+  return errors != 0;
+}
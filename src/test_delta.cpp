@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_delta.h"
+#include "int128_kernels.h"
+
+using namespace absl;
+using int128_t_internal::KernelLevel;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// Sorted values whose steps have `bits` random bits above a fixed stride.
+static std::vector<uint128_t> Sorted(size_t n, int bits, std::mt19937_64 & random)
+{
+  std::vector<uint128_t> values(n);
+  uint128_t v = MakeUint128(random(), random());
+  for (auto & x : values) {
+    const uint128_t noise = bits == 0 ? 0 : MakeUint128(random(), random()) >> (128 - bits);
+    v += 1000000000 + noise;
+    x = v;
+  }
+  return values;
+}
+
+static void CheckBlocks(std::mt19937_64 & random)
+{
+  std::vector<uint8_t> buffer(MaxDeltaBlockBytes(kDeltaBlockSize));
+  std::vector<uint128_t> decoded(kDeltaBlockSize);
+  for (int bits = 0; bits <= 128; bits++) {
+    for (size_t n : {size_t(1), size_t(2), size_t(5), size_t(64), size_t(127), kDeltaBlockSize}) {
+      std::vector<uint128_t> values = Sorted(n, bits, random);
+      const size_t bytes = EncodeDeltaBlock(values.data(), n, buffer.data());
+      Expect(bytes <= MaxDeltaBlockBytes(n), "EncodeDeltaBlock size");
+      size_t count = 0;
+      Expect(DeltaBlockBytes(buffer.data(), bytes, &count) == bytes && count == n,
+             "DeltaBlockBytes");
+      Expect(DeltaBlockBytes(buffer.data(), bytes - 1, &count) == 0,
+             "DeltaBlockBytes truncated");
+      DecodeDeltaBlock(buffer.data(), decoded.data());
+      Expect(std::equal(values.begin(), values.end(), decoded.begin()), "DecodeDeltaBlock");
+    }
+  }
+  // Timestamps at a fixed interval need no packed bits.
+  std::vector<uint128_t> regular = Sorted(kDeltaBlockSize, 0, random);
+  Expect(EncodeDeltaBlock(regular.data(), regular.size(), buffer.data()) == 40,
+         "EncodeDeltaBlock regular");
+  // A block with steps below 2^10 packs 127 differences in 4 * 10 words.
+  std::vector<uint128_t> small = Sorted(kDeltaBlockSize, 10, random);
+  Expect(EncodeDeltaBlock(small.data(), small.size(), buffer.data()) <= 40 + 4 * 8 * 10,
+         "EncodeDeltaBlock width");
+
+  // Unsorted and extreme values still round-trip.
+  for (int round = 0; round < 200; round++) {
+    std::vector<int128_t> values(1 + random() % kDeltaBlockSize);
+    for (auto & v : values) {
+      switch (random() % 4) {
+        case 0: v = Int128Min(); break;
+        case 1: v = Int128Max(); break;
+        case 2: v = int128_t(MakeUint128(random(), random())); break;
+        default: v = int128_t(int64_t(random() % 1000) - 500); break;
+      }
+    }
+    const size_t bytes = EncodeDeltaBlock(values.data(), values.size(), buffer.data());
+    std::vector<int128_t> out(values.size());
+    size_t count = 0;
+    Expect(DeltaBlockBytes(buffer.data(), bytes, &count) == bytes, "DeltaBlockBytes signed");
+    DecodeDeltaBlock(buffer.data(), out.data());
+    Expect(out == values, "DecodeDeltaBlock signed");
+  }
+
+  // Malformed headers.
+  buffer.assign(buffer.size(), 0);
+  size_t count = 0;
+  Expect(DeltaBlockBytes(buffer.data(), buffer.size(), &count) == 0, "DeltaBlockBytes empty");
+  buffer[0] = 129;
+  buffer[1] = 2;
+  Expect(DeltaBlockBytes(buffer.data(), buffer.size(), &count) == 0, "DeltaBlockBytes width");
+  buffer[0] = 0;
+  buffer[1] = 129;
+  Expect(DeltaBlockBytes(buffer.data(), buffer.size(), &count) == 0, "DeltaBlockBytes count");
+}
+
+static void CheckStream(std::mt19937_64 & random)
+{
+  const size_t n = 100000;
+  std::vector<uint128_t> values = Sorted(n, 20, random);
+  for (size_t i = 5000; i < 5300; i++) values[i] = Uint128Max() - i;  // a jump
+
+  // The same values added one at a time, in pieces, and with a flush in the
+  // middle, which leaves a short block there.
+  Uint128DeltaWriter one, pieces, flushed;
+  for (uint128_t v : values) one.Add(v);
+  for (size_t i = 0; i < n;) {
+    const size_t k = std::min<size_t>(n - i, random() % 1000);
+    pieces.AddN(values.data() + i, k);
+    i += k;
+  }
+  flushed.AddN(values.data(), 1000);
+  flushed.Flush();
+  Expect(flushed.data().size() != 0 && flushed.size() == 1000, "Flush");
+  flushed.AddN(values.data() + 1000, n - 1000);
+  Expect(one.size() == n && pieces.size() == n, "Uint128DeltaWriter size");
+
+  const std::vector<uint8_t> a = one.Finish();
+  const std::vector<uint8_t> b = pieces.Finish();
+  const std::vector<uint8_t> c = flushed.Finish();
+  Expect(a == b, "AddN");
+  Expect(one.size() == 0 && one.data().empty(), "Finish");
+  printf("%zu values, steps of 10^9 plus 20 random bits: %zu bytes (%.2f "
+         "bytes/value)\n", n, a.size(), double(a.size()) / n);
+
+  for (const std::vector<uint8_t> * data : {&a, &c}) {
+    Uint128DeltaReader reader(data->data(), data->size());
+    Expect(reader.ok() && reader.size() == n, "Uint128DeltaReader");
+    std::vector<uint128_t> decoded(n);
+    reader.Decode(decoded.data());
+    Expect(decoded == values, "Uint128DeltaReader Decode");
+    for (int i = 0; i < 1000; i++) {
+      const size_t k = random() % n;
+      Expect(reader[k] == values[k], "Uint128DeltaReader[]");
+    }
+  }
+  Uint128DeltaReader reader(c.data(), c.size());
+  Expect(reader.num_blocks() == (1000 + 127) / 128 + (n - 1000 + 127) / 128 &&
+         reader.block_start(8) == 1000, "short block");
+
+  Uint128DeltaReader truncated(a.data(), a.size() - 1);
+  Expect(!truncated.ok() && truncated.size() == n - n % kDeltaBlockSize,
+         "Uint128DeltaReader truncated");
+
+  Int128DeltaWriter writer;
+  std::vector<int128_t> times(1000);
+  for (size_t i = 0; i < times.size(); i++) {
+    times[i] = int128_t(-1700000000) * 1000000000 + int128_t(i) * 1000000;
+  }
+  writer.AddN(times.data(), times.size());
+  const std::vector<uint8_t> encoded = writer.Finish();
+  Int128DeltaReader times_reader(encoded.data(), encoded.size());
+  std::vector<int128_t> decoded(times.size());
+  times_reader.Decode(decoded.data());
+  Expect(decoded == times && encoded.size() == 40 * 8, "Int128DeltaReader");
+}
+
+static void Benchmark(int level, std::mt19937_64 & random)
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values = Sorted(n, 24, random);
+  std::vector<uint128_t> decoded(n);
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  auto t0 = Clock::now();
+  Uint128DeltaWriter writer;
+  writer.AddN(values.data(), n);
+  const std::vector<uint8_t> data = writer.Finish();
+  auto t1 = Clock::now();
+  Uint128DeltaReader reader(data.data(), data.size());
+  reader.Decode(decoded.data());
+  auto t2 = Clock::now();
+  Expect(decoded == values, "benchmark round trip");
+  printf("level %d: %.2f bytes/value; encode %.2f ns/value, decode %.2f ns/value\n",
+         level, double(data.size()) / n, ns(t1 - t0), ns(t2 - t1));
+}
+
+int main()
+{
+  std::mt19937_64 random(43);
+  const int detected = static_cast<int>(int128_t_internal::DetectedKernelLevel());
+  for (int level = 0; level <= detected; level++) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    CheckBlocks(random);
+    CheckStream(random);
+  }
+  for (int level : {0, detected}) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    Benchmark(level, random);
+  }
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <random>
+#include <stdint.h>
+
+#include "abslint128.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what, uint128_t a, uint128_t d)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s (%s, %s)\n", what,
+      uint128_t::ToString(a).c_str(), uint128_t::ToString(d).c_str());
+    errors++;
+  }
+}
+
+static void Check(uint128_t q, uint128_t d)
+{
+  if (d == 0)
+    return;
+  uint128_t a = q * d;
+  bool exact = a / d == q;  // false if q * d overflowed
+  if ((Uint128Low64(d) & 1) != 0)
+    Expect(d * InverseMod2_128(d) == 1, "InverseMod2_128", d, d);
+  if (exact) {
+    Expect(DivExact(a, d) == q, "DivExact", a, d);
+    Expect(IsDivisible(a, d), "IsDivisible", a, d);
+    int128_t sa = int128_t(a), sd = int128_t(d);
+    if (Int128High64(sa) >= 0 && Int128High64(sd) >= 0) {
+      Expect(DivExact(-sa, sd) == -int128_t(q), "DivExact(-a, d)", a, d);
+      Expect(DivExact(sa, -sd) == -int128_t(q), "DivExact(a, -d)", a, d);
+      Expect(IsDivisible(-sa, sd), "IsDivisible(-a, d)", a, d);
+    }
+  }
+  for (int k = 1; k <= 3; k++)
+    Expect(IsDivisible(a + k, d) == ((a + k) % d == 0), "IsDivisible(a + k)",
+      a + k, d);
+}
+
+int main(int argc, char ** argv)
+{
+  for (uint64_t q = 0; q < 64; q++)
+    for (uint64_t d = 1; d < 64; d++)
+      Check(q, d);
+
+  std::mt19937_64 random(1);
+  for (int i = 0; i < 200000; i++) {
+    uint128_t d = (uint128_t(random()) << 64 | random()) >> (random() % 128);
+    uint128_t q = (uint128_t(random()) << 64 | random()) >> (random() % 128);
+    Check(q, d);
+    Check(q, d << (random() % 16));
+    Check(q >> (128 - BitWidth(Uint128Max() / (d | 1))), d | 1);
+  }
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
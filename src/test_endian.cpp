@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_endian.h"
+#include "int128_kernels.h"
+
+using namespace absl;
+using int128_t_internal::KernelLevel;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what, int level, size_t n)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s (level %d, n %zu)\n", what, level, n);
+    errors++;
+  }
+}
+
+// The bytes of `v` from least to most significant.
+static void LittleEndianBytes(uint128_t v, unsigned char * out)
+{
+  for (int i = 0; i < 16; i++) out[i] = (unsigned char)(Uint128Low64(v >> (8 * i)) & 0xff);
+}
+
+static void CheckScalar(std::mt19937_64 & random)
+{
+  unsigned char buffer[64];
+  for (int trial = 0; trial < 1000; trial++) {
+    const uint128_t v = MakeUint128(random(), random());
+    const int128_t s = int128_t(v);
+    unsigned char le[16], be[16];
+    LittleEndianBytes(v, le);
+    for (int i = 0; i < 16; i++) be[i] = le[15 - i];
+
+    // Every alignment.
+    const size_t offset = trial % 17;
+    std::memcpy(buffer + offset, le, 16);
+    Expect(LoadLE128(buffer + offset) == v, "LoadLE128", 0, offset);
+    Expect(LoadLE128<int128_t>(buffer + offset) == s, "LoadLE128<int128_t>", 0, offset);
+    std::memcpy(buffer + offset, be, 16);
+    Expect(LoadBE128(buffer + offset) == v, "LoadBE128", 0, offset);
+    Expect(LoadBE128<int128_t>(buffer + offset) == s, "LoadBE128<int128_t>", 0, offset);
+
+    std::memset(buffer, 0, sizeof(buffer));
+    StoreLE128(buffer + offset, v);
+    Expect(std::memcmp(buffer + offset, le, 16) == 0, "StoreLE128", 0, offset);
+    StoreLE128(buffer + offset, s);
+    Expect(std::memcmp(buffer + offset, le, 16) == 0, "StoreLE128(int128_t)", 0, offset);
+    StoreBE128(buffer + offset, v);
+    Expect(std::memcmp(buffer + offset, be, 16) == 0, "StoreBE128", 0, offset);
+    StoreBE128(buffer + offset, s);
+    Expect(std::memcmp(buffer + offset, be, 16) == 0, "StoreBE128(int128_t)", 0, offset);
+    Expect(buffer[offset + 16] == 0 && (offset == 0 || buffer[offset - 1] == 0),
+           "store bounds", 0, offset);
+  }
+  // A known big-endian value: the IPv6 address 2001:db8::1.
+  const unsigned char address[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                                     0,    0,    0,    0,    0, 0, 0, 1};
+  Expect(LoadBE128(address) == MakeUint128(0x20010db800000000ull, 1),
+         "LoadBE128(2001:db8::1)", 0, 0);
+  Expect(LoadLE128<int128_t>(address) > 0, "LoadLE128 sign", 0, 0);
+  const unsigned char minus_one[16] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                       0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                       0xff, 0xff, 0xff, 0xff};
+  Expect(LoadBE128<int128_t>(minus_one) == -1, "LoadBE128(-1)", 0, 0);
+}
+
+static void CheckBulk(int level, size_t n, std::mt19937_64 & random)
+{
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = MakeUint128(random(), random());
+  const size_t offset = 1 + n % 15;  // an unaligned buffer
+  std::vector<unsigned char> le(16 * n + offset), be(16 * n + offset);
+  for (size_t i = 0; i < n; i++) {
+    StoreLE128(le.data() + offset + 16 * i, values[i]);
+    StoreBE128(be.data() + offset + 16 * i, values[i]);
+  }
+
+  std::vector<uint128_t> loaded(n);
+  LoadLE128N(loaded.data(), le.data() + offset, n);
+  Expect(loaded == values, "LoadLE128N", level, n);
+  LoadBE128N(loaded.data(), be.data() + offset, n);
+  Expect(loaded == values, "LoadBE128N", level, n);
+  std::vector<int128_t> signed_loaded(n);
+  LoadBE128N(signed_loaded.data(), be.data() + offset, n);
+  for (size_t i = 0; i < n; i++) {
+    Expect(signed_loaded[i] == int128_t(values[i]), "LoadBE128N(int128_t)", level, n);
+  }
+
+  std::vector<unsigned char> out(16 * n + offset);
+  StoreLE128N(out.data() + offset, values.data(), n);
+  Expect(std::memcmp(out.data() + offset, le.data() + offset, 16 * n) == 0,
+         "StoreLE128N", level, n);
+  StoreBE128N(out.data() + offset, values.data(), n);
+  Expect(std::memcmp(out.data() + offset, be.data() + offset, 16 * n) == 0,
+         "StoreBE128N", level, n);
+  StoreBE128N(out.data() + offset, signed_loaded.data(), n);
+  Expect(std::memcmp(out.data() + offset, be.data() + offset, 16 * n) == 0,
+         "StoreBE128N(int128_t)", level, n);
+
+  // In place: a received buffer of big-endian values becomes native.
+  std::vector<uint128_t> in_place(n);
+  if (n != 0) std::memcpy(in_place.data(), be.data() + offset, 16 * n);
+  LoadBE128N(in_place.data(), in_place.data(), n);
+  Expect(in_place == values, "LoadBE128N(in place)", level, n);
+  std::vector<uint128_t> swapped(n);
+  ByteswapN(swapped.data(), values.data(), n);
+  ByteswapN(in_place.data(), in_place.data(), n);
+  for (size_t i = 0; i < n; i++) {
+    Expect(swapped[i] == Byteswap(values[i]), "ByteswapN", level, n);
+  }
+  Expect(in_place == swapped, "ByteswapN(in place)", level, n);
+}
+
+static void Benchmark()
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values(n), out(n);
+  std::vector<unsigned char> buffer(16 * n);
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  auto t0 = Clock::now();
+  for (size_t i = 0; i < n; i++) out[i] = LoadBE128(buffer.data() + 16 * i);
+  auto t1 = Clock::now();
+  LoadBE128N(out.data(), buffer.data(), n);
+  auto t2 = Clock::now();
+  printf("LoadBE128 loop %.2f ns/value, LoadBE128N %.2f ns/value\n",
+         ns(t1 - t0), ns(t2 - t1));
+}
+
+int main()
+{
+  std::mt19937_64 random(41);
+  CheckScalar(random);
+  int detected = static_cast<int>(int128_t_internal::DetectedKernelLevel());
+  for (int level = 0; level <= detected; level++) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    for (size_t n = 0; n < 40; n++) CheckBulk(level, n, random);
+    CheckBulk(level, 10001, random);
+  }
+  int128_t_internal::SetKernelLevel(int128_t_internal::DetectedKernelLevel());
+  Benchmark();
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_flat_hash.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// Keys drawn from a small pool, so that inserts, erases and lookups of the
+// same keys interleave. Includes 0 and the all-ones value, which a table with
+// an empty-key sentinel could not store.
+static std::vector<uint128_t> KeyPool(std::mt19937_64 & random, size_t n)
+{
+  std::vector<uint128_t> pool = {0, Uint128Max(), MakeUint128(1, 0), 1};
+  while (pool.size() < n / 2) pool.push_back(MakeUint128(random(), random()));
+  // Keys differing only in the high half, and only in the low half.
+  for (uint64_t i = 0; pool.size() < 3 * n / 4; i++) {
+    pool.push_back(MakeUint128(i + 2, 7));
+  }
+  for (uint64_t i = 0; pool.size() < n; i++) pool.push_back(MakeUint128(0, i + 2));
+  return pool;
+}
+
+// Applies random operations to a map and to a reference std::map, with a
+// value type that owns memory so that leaks and double frees show up under a
+// sanitizer.
+static void CheckMap(std::mt19937_64 & random)
+{
+  const std::vector<uint128_t> pool = KeyPool(random, 4096);
+  FlatHashMap128<std::string> map;
+  std::map<uint128_t, std::string> reference;
+  for (int op = 0; op < 200000; op++) {
+    const uint128_t key = pool[random() % pool.size()];
+    const std::string value = std::to_string(op) + " a longer string value";
+    switch (random() % 5) {
+      case 0: {
+        auto result = map.insert(key, value);
+        bool inserted = reference.insert({key, value}).second;
+        Expect(result.second == inserted, "map insert result");
+        Expect(*result.first == reference[key], "map insert value");
+        break;
+      }
+      case 1:
+        map[key] = value;
+        reference[key] = value;
+        break;
+      case 2:
+        Expect(map.erase(key) == (reference.erase(key) == 1), "map erase");
+        break;
+      default: {
+        const std::string * found = map.find(key);
+        auto it = reference.find(key);
+        Expect((found != nullptr) == (it != reference.end()), "map find");
+        if (found != nullptr && it != reference.end()) {
+          Expect(*found == it->second, "map find value");
+        }
+        break;
+      }
+    }
+    Expect(map.size() == reference.size(), "map size");
+    if (op % 50000 == 0) map.clear(), reference.clear();
+  }
+
+  size_t visited = 0;
+  map.ForEach([&](const uint128_t & key, std::string & value) {
+    auto it = reference.find(key);
+    Expect(it != reference.end() && it->second == value, "map ForEach");
+    visited++;
+  });
+  Expect(visited == reference.size(), "map ForEach count");
+
+  FlatHashMap128<std::string> copy(map);
+  map.clear();
+  Expect(map.empty() && copy.size() == reference.size(), "map copy");
+  FlatHashMap128<std::string> moved(std::move(copy));
+  for (const auto & entry : reference) {
+    const std::string * found = moved.find(entry.first);
+    Expect(found != nullptr && *found == entry.second, "map copy and move");
+  }
+
+  std::vector<uint128_t> keys(pool);
+  keys.push_back(MakeUint128(99, 99));
+  std::vector<const std::string *> found(keys.size());
+  size_t hits = moved.FindN(keys.data(), keys.size(), found.data());
+  Expect(hits == reference.size(), "map FindN count");
+  for (size_t i = 0; i < keys.size(); i++) {
+    Expect(found[i] == moved.find(keys[i]), "map FindN");
+  }
+}
+
+static void CheckSet(std::mt19937_64 & random)
+{
+  const std::vector<uint128_t> pool = KeyPool(random, 100000);
+  FlatHashSet128 set;
+  for (size_t i = 0; i < pool.size(); i += 2) {
+    Expect(set.insert(pool[i]), "set insert");
+    Expect(!set.insert(pool[i]), "set insert duplicate");
+  }
+  Expect(set.size() == pool.size() / 2, "set size");
+  Expect(set.size() <= set.capacity() - set.capacity() / 8, "set load");
+
+  std::vector<bool> expected(pool.size());
+  for (size_t i = 0; i < pool.size(); i++) expected[i] = i % 2 == 0;
+  // Erasing and reinserting many keys leaves tombstones that later inserts
+  // must reuse or rehash away without growing without bound.
+  size_t capacity = set.capacity();
+  for (int round = 0; round < 20; round++) {
+    for (size_t i = round % 4; i < pool.size(); i += 4) {
+      if (expected[i]) Expect(set.erase(pool[i]), "set erase");
+      expected[i] = false;
+    }
+    for (size_t i = (round + 1) % 4; i < pool.size(); i += 4) {
+      Expect(set.insert(pool[i]) != expected[i], "set reinsert");
+      expected[i] = true;
+    }
+  }
+  Expect(set.capacity() <= 2 * capacity, "set tombstones");
+
+  std::unique_ptr<bool[]> found(new bool[pool.size()]);
+  size_t hits = set.FindN(pool.data(), pool.size(), found.get());
+  size_t count = 0;
+  for (size_t i = 0; i < pool.size(); i++) {
+    Expect(found[i] == expected[i], "set FindN");
+    Expect(set.contains(pool[i]) == expected[i], "set contains");
+    count += expected[i];
+  }
+  Expect(hits == count && set.size() == count, "set FindN count");
+
+  size_t visited = 0;
+  set.ForEach([&](const uint128_t &) { visited++; });
+  Expect(visited == count, "set ForEach");
+
+  FlatHashSet128 reserved(1000);
+  size_t reserved_capacity = reserved.capacity();
+  for (size_t i = 0; i < 1000; i++) reserved.insert(pool[i]);
+  Expect(reserved.capacity() == reserved_capacity, "set reserve");
+}
+
+// Inserts `keys` into an empty set and returns the time per key, in ns.
+static double InsertTime(const std::vector<uint128_t> & keys)
+{
+  auto start = std::chrono::steady_clock::now();
+  FlatHashSet128 set;
+  for (const auto & k : keys) set.insert(k);
+  double ns = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count() / keys.size();
+  Expect(set.size() == keys.size(), "adversarial keys size");
+  return ns;
+}
+
+// How `keys` spread over the groups where lookups in a table of `capacity`
+// slots start, which are picked by the hash bits above the low 7.
+struct GroupSpread {
+  size_t max_keys;  // the most keys that start in one group
+  size_t overflow;  // keys past the 16 slots of their first group
+};
+
+static GroupSpread Spread(const std::vector<uint128_t> & keys, size_t capacity)
+{
+  const size_t groups = capacity / int128_t_internal::kGroupWidth;
+  std::vector<size_t> count(groups);
+  for (const auto & k : keys) {
+    const uint64_t hash =
+        int128_t_internal::Hash128(Uint128High64(k), Uint128Low64(k));
+    count[(hash >> 7) & (groups - 1)]++;
+  }
+  GroupSpread spread = {0, 0};
+  for (size_t c : count) {
+    spread.max_keys = std::max(spread.max_keys, c);
+    if (c > int128_t_internal::kGroupWidth) {
+      spread.overflow += c - int128_t_internal::kGroupWidth;
+    }
+  }
+  return spread;
+}
+
+// Keys that an attacker who reads the hash constants can pick to zero a
+// factor of its first multiply, or to make it the identity. Once these all
+// shared a probe sequence, so inserting 20000 of them took half a second.
+// Each family must spread over the groups of the table about as well as
+// random keys; the insert times are only printed.
+static void CheckAdversarialKeys(std::mt19937_64 & random)
+{
+  using int128_t_internal::kHashSecret0;
+  using int128_t_internal::kHashSecret1;
+  const size_t n = 20000;
+  std::vector<uint128_t> keys(n);
+  for (auto & k : keys) k = MakeUint128(random(), random());
+  FlatHashSet128 sized(n);
+  const size_t capacity = sized.capacity();
+  const GroupSpread random_spread = Spread(keys, capacity);
+  const double random_ns = InsertTime(keys);
+  for (int family = 0; family < 4; family++) {
+    for (size_t i = 0; i < n; i++) {
+      const uint64_t high[] = {i, kHashSecret1, i, kHashSecret1 ^ 1};
+      const uint64_t low[] = {kHashSecret0, i, kHashSecret0 ^ 1, i};
+      keys[i] = MakeUint128(high[family], low[family]);
+    }
+    const GroupSpread spread = Spread(keys, capacity);
+    const double ns = InsertTime(keys);
+    printf("adversarial family %d: %zu keys in the fullest group, %zu past "
+           "a full one (random keys %zu, %zu), insert %.1f ns/key (random "
+           "keys %.1f)\n", family, spread.max_keys, spread.overflow,
+           random_spread.max_keys, random_spread.overflow, ns, random_ns);
+    Expect(spread.max_keys <= 2 * random_spread.max_keys,
+           "adversarial keys group load");
+    Expect(spread.overflow <= 2 * random_spread.overflow + n / 100,
+           "adversarial keys overflow");
+  }
+}
+
+// Compares lookups in a table larger than the cache with std::unordered_map.
+static void Benchmark(std::mt19937_64 & random)
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> keys(n);
+  for (auto & k : keys) k = MakeUint128(random(), random());
+  FlatHashMap128<uint32_t> map(n);
+  std::unordered_map<uint128_t, uint32_t> std_map(n);
+  for (size_t i = 0; i < n; i++) {
+    map[keys[i]] = uint32_t(i);
+    std_map[keys[i]] = uint32_t(i);
+  }
+  std::vector<uint128_t> queries(n);
+  for (auto & q : queries) q = keys[random() % n];
+
+  using Clock = std::chrono::steady_clock;
+  uint64_t sum = 0;
+  auto t0 = Clock::now();
+  for (const auto & q : queries) sum += std_map.find(q) != std_map.end();
+  auto t1 = Clock::now();
+  for (const auto & q : queries) sum += map.find(q) != nullptr;
+  auto t2 = Clock::now();
+  std::vector<const uint32_t *> found(n);
+  sum += map.FindN(queries.data(), n, found.data());
+  auto t3 = Clock::now();
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  printf("lookup ns/key: std::unordered_map %.1f, find %.1f, FindN %.1f "
+         "(%llu hits)\n", ns(t1 - t0), ns(t2 - t1), ns(t3 - t2),
+         (unsigned long long)sum);
+}
+
+int main()
+{
+  std::mt19937_64 random(38);
+  CheckMap(random);
+  CheckSet(random);
+  CheckAdversarialKeys(random);
+  Benchmark(random);
+  printf("Done!\n");
+  return errors != 0;
+}
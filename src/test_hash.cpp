@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <stdint.h>
+#include <unordered_set>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_kernels.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+static uint64_t Hash(uint128_t v)
+{
+  return std::hash<uint128_t>{}(v);
+}
+
+// Counts distinct values among the low `bits` bits of the hashes, as a hash
+// table of 2^bits buckets would see them, and compares with the number of
+// distinct buckets expected for random hashes. Using more buckets than random
+// hashes would is fine.
+static void CheckBuckets(const char * name, const std::vector<uint128_t> & keys,
+                         int bits)
+{
+  std::vector<uint64_t> hashes(keys.size());
+  HashN(hashes.data(), keys.data(), keys.size());
+  std::unordered_set<uint64_t> full, buckets, xor_buckets;
+  uint64_t mask = (uint64_t{1} << bits) - 1;
+  for (size_t i = 0; i < keys.size(); i++) {
+    full.insert(hashes[i]);
+    buckets.insert(hashes[i] & mask);
+    xor_buckets.insert((Uint128High64(keys[i]) ^ Uint128Low64(keys[i])) & mask);
+  }
+  double m = double(mask + 1), n = double(keys.size());
+  double expected = m * (1 - std::exp(-n / m));
+  printf("%-12s %zu keys, 2^%d buckets: %zu used (random %.0f, hi^lo %zu), "
+         "%zu full-hash collisions\n", name, keys.size(), bits, buckets.size(),
+         expected, xor_buckets.size(), keys.size() - full.size());
+  Expect(full.size() == keys.size(), name);
+  Expect(double(buckets.size()) > expected - 5 * std::sqrt(expected), name);
+}
+
+// For each input bit, measures how often each output bit flips, which is
+// 1/2 for an ideal hash.
+static void CheckAvalanche(std::mt19937_64 & random)
+{
+  const int trials = 20000;
+  static int flips[128][64];
+  for (int t = 0; t < trials; t++) {
+    uint128_t v = MakeUint128(random(), random());
+    uint64_t h = Hash(v);
+    for (int i = 0; i < 128; i++) {
+      uint64_t d = h ^ Hash(v ^ (uint128_t(1) << i));
+      for (int j = 0; j < 64; j++)
+        flips[i][j] += (d >> j) & 1;
+    }
+  }
+  double worst = 0, total = 0;
+  for (int i = 0; i < 128; i++) {
+    for (int j = 0; j < 64; j++) {
+      double bias = std::fabs(double(flips[i][j]) / trials - 0.5);
+      worst = bias > worst ? bias : worst;
+      total += bias;
+    }
+  }
+  printf("avalanche: mean bias %.4f, worst bias %.4f\n",
+         total / (128 * 64), worst);
+  Expect(worst < 0.1, "avalanche");
+}
+
+int main(int argc, char ** argv)
+{
+  std::mt19937_64 random(1);
+
+  // Both specializations and HashN agree.
+  std::vector<uint128_t> values(1000);
+  for (auto & v : values)
+    v = MakeUint128(random(), random());
+  std::vector<uint64_t> out(values.size());
+  HashN(out.data(), values.data(), values.size());
+  bool ok = true;
+  for (size_t i = 0; i < values.size(); i++) {
+    ok &= out[i] == Hash(values[i]);
+    ok &= std::hash<int128_t>{}(int128_t(values[i])) == Hash(values[i]);
+  }
+  std::vector<int128_t> signed_values(values.begin(), values.end());
+  std::vector<uint64_t> signed_out(values.size());
+  HashN(signed_out.data(), signed_values.data(), signed_values.size());
+  Expect(ok && signed_out == out, "HashN");
+
+  // Distinct structured keys: sequential IDs, (entity, sequence) pairs,
+  // equal halves, IPv6 addresses in one /64, and small odd values shifted.
+  const size_t n = 1 << 16;
+  std::vector<uint128_t> sequential, pairs, equal, ipv6, shifted;
+  for (size_t i = 0; i < n; i++) {
+    sequential.push_back(i);
+    pairs.push_back(MakeUint128(i >> 8, i & 255));
+    equal.push_back(MakeUint128(i, i));
+    ipv6.push_back(MakeUint128(0x20010db800000000, i << 8 | 1));
+    shifted.push_back(uint128_t(2 * (i % 1024) + 1) << (i / 1024));
+  }
+  CheckBuckets("sequential", sequential, 16);
+  CheckBuckets("pairs", pairs, 16);
+  CheckBuckets("equal", equal, 16);
+  CheckBuckets("ipv6", ipv6, 16);
+  CheckBuckets("shifted", shifted, 16);
+  CheckAvalanche(random);
+
+  // Keys that zero a factor of one multiply, or make it the identity, which
+  // hashed every such key alike when the hash was that multiply alone.
+  using int128_t_internal::kHashSecret0;
+  using int128_t_internal::kHashSecret1;
+  const uint64_t h1 = Hash(MakeUint128(1, kHashSecret0));
+  const uint64_t h2 = Hash(MakeUint128(12345, kHashSecret0));
+  const uint64_t h3 = Hash(MakeUint128(kHashSecret1, 777));
+  Expect(h1 != h2 && h1 != h3 && h2 != h3, "annihilating keys");
+  std::vector<uint128_t> annihilating;
+  for (size_t i = 0; i < n / 4; i++) {
+    annihilating.push_back(MakeUint128(i, kHashSecret0));
+    annihilating.push_back(MakeUint128(kHashSecret1, i));
+    annihilating.push_back(MakeUint128(i, kHashSecret0 ^ 1));
+    annihilating.push_back(MakeUint128(kHashSecret1 ^ 1, i));
+  }
+  CheckBuckets("annihilating", annihilating, 16);
+
+  values.resize(1 << 20);
+  for (auto & v : values)
+    v = MakeUint128(random(), random());
+  out.resize(values.size());
+  auto start = std::chrono::steady_clock::now();
+  HashN(out.data(), values.data(), values.size());
+  double ns = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count() / values.size();
+  printf("HashN: %.2f ns/value\n", ns);
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Built against the abslint128_header_only target, which defines
+// ABSL_INT128_HEADER_ONLY: nothing below needs the compiled library.
+#include "abslint128.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+static void CheckOutOfLine()
+{
+  Expect(uint128_t(18446744073709551616.0) == MakeUint128(1, 0), "uint128_t(double)");
+  Expect(int128_t(-1e20) == -int128_t(100000000000000000000_u128), "int128_t(double)");
+  Expect(static_cast<double>(MakeUint128(1, 0)) == 18446744073709551616.0, "double");
+  Expect(Isqrt(Uint128Max()) == 0xffffffffffffffffu && Icbrt(1000000000000000000000_u128) ==
+         10000000 && Iroot(MakeUint128(1, 0), 4) == 65536, "roots");
+  Expect(uint128_t::ToString(Uint128Max()) == "340282366920938463463374607431768211455",
+         "ToString");
+  Expect(uint128_t::ToFormattedString(255, std::ios::hex | std::ios::showbase) == "0xff",
+         "ToFormattedString");
+  std::ostringstream os;
+  os << int128_t(-42) << ' ' << std::hex << uint128_t(255);
+  Expect(os.str() == "-42 ff", "operator<<");
+}
+
+// Stands in for a call across a shared-library boundary, which can be neither
+// inlined nor specialized for the divisor.
+static uint128_t Divide(uint128_t a, uint128_t b)
+{
+  return a / b;
+}
+static uint128_t (*volatile divide_out_of_line)(uint128_t, uint128_t) = Divide;
+
+static void Benchmark(std::mt19937_64 & random)
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = MakeUint128(random(), random());
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  volatile uint64_t ten = 10;
+  const uint128_t divisor = ten;
+  uint128_t (*divide)(uint128_t, uint128_t) = divide_out_of_line;
+  uint64_t sink = 0;
+  auto t0 = Clock::now();
+  for (const uint128_t & v : values) sink += Uint128Low64(divide(v, divisor));
+  auto t1 = Clock::now();
+  for (const uint128_t & v : values) sink += Uint128Low64(v / divisor);
+  auto t2 = Clock::now();
+  for (const uint128_t & v : values) sink += Uint128Low64(v / 10);
+  auto t3 = Clock::now();
+  printf("divide by 10: out of line %.2f ns, inline %.2f ns, inline constant %.2f ns (%llu)\n",
+         ns(t1 - t0), ns(t2 - t1), ns(t3 - t2), static_cast<unsigned long long>(sink % 10));
+}
+
+int main()
+{
+  std::mt19937_64 random(49);
+  CheckOutOfLine();
+  Benchmark(random);
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,273 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_endian.h"
+#include "int128_ipv6.h"
+#include "int128_kernels.h"
+
+using namespace absl;
+using int128_t_internal::KernelLevel;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+static bool PtonValue(const std::string & text, uint128_t * value)
+{
+  unsigned char bytes[16];
+  if (inet_pton(AF_INET6, text.c_str(), bytes) != 1) return false;
+  *value = LoadBE128<uint128_t>(bytes);
+  return true;
+}
+
+static std::string Ntop(uint128_t value)
+{
+  unsigned char bytes[16];
+  StoreBE128(bytes, value);
+  char text[INET6_ADDRSTRLEN];
+  return inet_ntop(AF_INET6, bytes, text, sizeof(text));
+}
+
+// Addresses with random groups, each zero half of the time, so that runs of
+// zero groups of every length occur.
+static uint128_t RandomAddress(std::mt19937_64 & random)
+{
+  uint128_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    const uint64_t group = random() % 2 ? 0 : random() >> (4 * (random() % 4) + 48);
+    value = (value << 16) | group;
+  }
+  return value;
+}
+
+static void CheckFormat()
+{
+  struct Case { uint128_t value; const char * text; };
+  const Case cases[] = {
+      {0, "::"},
+      {1, "::1"},
+      {MakeUint128(0x20010db800000000u, 0x0000000000000001u), "2001:db8::1"},
+      // RFC 5952 section 4.2.2: a single zero group is not compressed.
+      {MakeUint128(0x20010db800000001u, 0x0001000100010001u), "2001:db8:0:1:1:1:1:1"},
+      // Section 4.2.3: the longest run, or the first of equal runs.
+      {MakeUint128(0x20010db800000000u, 0x0001000000000001u), "2001:db8::1:0:0:1"},
+      {MakeUint128(0x2001000000000000u, 0x0001000000000001u), "2001::1:0:0:1"},
+      {MakeUint128(0x20010db8abcd0000u, 0x0000000000000000u), "2001:db8:abcd::"},
+      {MakeUint128(0x0001000200030004u, 0x0005000600070008u), "1:2:3:4:5:6:7:8"},
+      {MakeUint128(0, 0x0000ffffc0000201u), "::ffff:192.0.2.1"},
+      {MakeUint128(0, 0x0000ffff00000000u), "::ffff:0.0.0.0"},
+      {MakeUint128(0xfe80000000000000u, 0x0000000000000001u), "fe80::1"},
+      {Uint128Max(), "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"},
+  };
+  for (const Case & c : cases) {
+    Expect(Ipv6Address(c.value).ToString() == c.text, c.text);
+  }
+  Expect(Ipv6Address(Uint128Max()).ToString().size() == kIpv6AddressMaxLength,
+         "kIpv6AddressMaxLength");
+}
+
+static void CheckParse()
+{
+  struct Case { const char * text; uint128_t value; };
+  const Case valid[] = {
+      {"::", 0},
+      {"::1", 1},
+      {"1::", MakeUint128(0x0001000000000000u, 0)},
+      {"2001:DB8::1", MakeUint128(0x20010db800000000u, 1)},
+      {"2001:0db8:0000:0000:0000:0000:0000:0001", MakeUint128(0x20010db800000000u, 1)},
+      {"1:2:3:4:5:6:7::", MakeUint128(0x0001000200030004u, 0x0005000600070000u)},
+      {"::2:3:4:5:6:7:8", MakeUint128(0x0000000200030004u, 0x0005000600070008u)},
+      {"::ffff:192.0.2.1", MakeUint128(0, 0x0000ffffc0000201u)},
+      {"::192.0.2.1", MakeUint128(0, 0xc0000201u)},
+      {"1:2:3:4:5:6:1.2.3.4", MakeUint128(0x0001000200030004u, 0x0005000601020304u)},
+      {"64:ff9b::255.255.255.255", MakeUint128(0x0064ff9b00000000u, 0xffffffffu)},
+  };
+  for (const Case & c : valid) {
+    Ipv6Address address;
+    size_t zone = 0;
+    Expect(Ipv6Address::Parse(std::string(c.text), &address, &zone) &&
+           address.value() == c.value && zone == strlen(c.text), c.text);
+  }
+
+  const char * invalid[] = {
+      "", ":", ":::", "1", "1:", ":1", "1:2:3:4:5:6:7", "1:2:3:4:5:6:7:8:9",
+      "1:2:3:4:5:6:7:8::", "::1:2:3:4:5:6:7:8", "1::2::3", "12345::", "g::",
+      "::1.2.3", "::1.2.3.4.5", "::256.0.0.1", "::01.2.3.4", "1.2.3.4::",
+      "::1.2.3.4:5", "1:2:3:4:5:6:7:1.2.3.4", "::ffff:1.2.3.4%", "%eth0",
+      " ::1", "::1 ", "::-1",
+  };
+  for (const char * text : invalid) {
+    Ipv6Address address(7);
+    Expect(!Ipv6Address::Parse(std::string(text), &address) && address.value() == 7,
+           text);
+  }
+
+  // Zone IDs.
+  const std::string scoped = "fe80::1%eth0";
+  Ipv6Address address;
+  size_t zone = 0;
+  Expect(Ipv6Address::Parse(scoped, &address, &zone) &&
+         address == Ipv6Address(MakeUint128(0xfe80000000000000u, 1)) &&
+         scoped.substr(zone) == "eth0", "zone ID");
+  Expect(Ipv6Address::Parse(std::string("::ffff:10.0.0.1%25"), &address, &zone) &&
+         zone == 16 && address.IsIpv4Mapped() && address.ToIpv4() == 0x0a000001,
+         "zone ID after IPv4");
+}
+
+static void CheckPrefixes()
+{
+  Ipv6Address address;
+  Ipv6Address::Parse(std::string("2001:db8:1234:5678:9abc:def0:1234:5678"), &address);
+  Expect(address.Network(48).ToString() == "2001:db8:1234::", "Network");
+  Expect(address.Network(128) == address && address.Network(0) == Ipv6Address(),
+         "Network bounds");
+  Expect(address.Host(64).ToString() == "::9abc:def0:1234:5678", "Host");
+  Expect(address.InNetwork(address.Network(48), 48) &&
+         address.InNetwork(Ipv6Address(), 0) &&
+         !address.InNetwork(Ipv6Address(address.value() ^ 1), 128) &&
+         address.InNetwork(Ipv6Address(address.value() ^ 1), 127), "InNetwork");
+  Expect(Ipv6Address::FromIpv4(0xc0000201).ToString() == "::ffff:192.0.2.1" &&
+         Ipv6Address::FromIpv4(0xc0000201).IsIpv4Mapped() &&
+         !Ipv6Address(1).IsIpv4Mapped(), "FromIpv4");
+  Expect(std::hash<Ipv6Address>()(address) == std::hash<uint128_t>()(address.value()),
+         "hash");
+}
+
+// Compares against the C library on random addresses, and on their text with
+// random edits for the parser.
+static void CheckLibc(std::mt19937_64 & random)
+{
+  const char alphabet[] = "0123456789abcdefABCDEFg:::...";
+  for (int i = 0; i < 200000; i++) {
+    const uint128_t value = RandomAddress(random);
+    const std::string text = Ipv6Address(value).ToString();
+    // The C library also writes "::a.b.c.d" for the deprecated
+    // IPv4-compatible addresses, which RFC 5952 leaves out.
+    if (Uint128High64(value) != 0 || Uint128Low64(value) >> 32 != 0) {
+      Expect(text == Ntop(value), "Format matches inet_ntop");
+    }
+    uint128_t parsed;
+    Expect(PtonValue(text, &parsed) && parsed == value, "inet_pton round trip");
+
+    std::string edited = text;
+    for (int edits = 1 + random() % 3; edits > 0; edits--) {
+      const size_t at = random() % (edited.size() + 1);
+      const char c = alphabet[random() % (sizeof(alphabet) - 1)];
+      switch (random() % 3) {
+        case 0: edited.insert(at, 1, c); break;
+        case 1: if (at < edited.size()) edited.erase(at, 1); break;
+        default: if (at < edited.size()) edited[at] = c; break;
+      }
+    }
+    uint128_t expected = 0;
+    const bool libc = PtonValue(edited, &expected);
+    Ipv6Address address;
+    const bool ours = Ipv6Address::Parse(edited, &address);
+    Expect(libc == ours && (!ours || address.value() == expected),
+           "Parse matches inet_pton");
+    if (libc != ours) fprintf(stderr, "  %s\n", edited.c_str());
+  }
+}
+
+static void CheckBatch(std::mt19937_64 & random)
+{
+  const size_t n = 1000;
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = RandomAddress(random);
+  std::vector<char> text(n * (kIpv6AddressMaxLength + 1));
+  char * end = FormatIpv6Addresses(values.data(), n, '\n', text.data());
+  std::string expected;
+  for (uint128_t v : values) expected += Ipv6Address(v).ToString() + "\n";
+  Expect(std::string(text.data(), end) == expected, "FormatIpv6Addresses");
+
+  std::vector<uint128_t> parsed(n);
+  Expect(ParseIpv6Addresses(text.data(), end, '\n', parsed.data(), n) == end &&
+         parsed == values, "ParseIpv6Addresses");
+  // The last address need not be followed by a separator.
+  std::vector<Ipv6Address> addresses(n);
+  Expect(ParseIpv6Addresses(text.data(), end - 1, '\n', addresses.data(), n) == end - 1 &&
+         addresses[n - 1] == Ipv6Address(values[n - 1]), "ParseIpv6Addresses(Ipv6Address)");
+  Expect(ParseIpv6Addresses(text.data(), end, '\n', parsed.data(), n + 1) == nullptr,
+         "ParseIpv6Addresses short input");
+
+  const std::string zoned = "fe80::1%eth0,fe80::2%eth1";
+  Expect(ParseIpv6Addresses(zoned.data(), zoned.data() + zoned.size(), ',',
+                            parsed.data(), 2) == zoned.data() + zoned.size() &&
+         parsed[1] == MakeUint128(0xfe80000000000000u, 2), "ParseIpv6Addresses zone");
+  text[10] = 'x';
+  Expect(ParseIpv6Addresses(text.data(), end, '\n', parsed.data(), n) == nullptr,
+         "ParseIpv6Addresses error");
+}
+
+static void Benchmark(int level, std::mt19937_64 & random)
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = RandomAddress(random);
+  std::vector<char> text(n * (kIpv6AddressMaxLength + 1));
+  std::vector<uint128_t> parsed(n);
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  auto t0 = Clock::now();
+  char * end = FormatIpv6Addresses(values.data(), n, '\n', text.data());
+  auto t1 = Clock::now();
+  ParseIpv6Addresses(text.data(), end, '\n', parsed.data(), n);
+  auto t2 = Clock::now();
+  Expect(parsed == values, "benchmark round trip");
+
+  // The C library needs each address copied out and null-terminated.
+  std::vector<char> libc_text(n * INET6_ADDRSTRLEN);
+  unsigned char bytes[16];
+  auto t3 = Clock::now();
+  for (size_t i = 0; i < n; i++) {
+    StoreBE128(bytes, values[i]);
+    inet_ntop(AF_INET6, bytes, &libc_text[i * INET6_ADDRSTRLEN], INET6_ADDRSTRLEN);
+  }
+  auto t4 = Clock::now();
+  uint128_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    inet_pton(AF_INET6, &libc_text[i * INET6_ADDRSTRLEN], bytes);
+    sum += LoadBE128<uint128_t>(bytes);
+  }
+  auto t5 = Clock::now();
+  Expect(sum != 0, "benchmark sum");
+  printf("level %d: format %.1f ns/address (inet_ntop %.1f), parse %.1f "
+         "ns/address (inet_pton %.1f)\n", level, ns(t1 - t0), ns(t4 - t3),
+         ns(t2 - t1), ns(t5 - t4));
+}
+
+int main()
+{
+  std::mt19937_64 random(46);
+  const int detected = static_cast<int>(int128_t_internal::DetectedKernelLevel());
+  for (int level = 0; level <= detected; level++) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    CheckFormat();
+    CheckParse();
+    CheckPrefixes();
+    CheckLibc(random);
+    CheckBatch(random);
+  }
+  for (int level : {0, detected}) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    Benchmark(level, random);
+  }
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,395 @@
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "abslint128.h"
+#include "int128_kernels.h"
+
+using namespace absl;
+using int128_t_internal::KernelLevel;
+using int128_t_internal::MulKernelLevel;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what, int level, size_t n)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s (level %d, n %zu)\n", what, level, n);
+    errors++;
+  }
+}
+
+// Values whose low halves are likely to carry or borrow.
+static uint128_t RandomValue(std::mt19937_64 & random)
+{
+  static const uint64_t edges[] = {0, 1, ~uint64_t{0}, ~uint64_t{0} - 1,
+                                   uint64_t{1} << 63};
+  uint64_t hi = random() % 4 == 0 ? edges[random() % 5] : random();
+  uint64_t lo = random() % 2 == 0 ? edges[random() % 5] : random();
+  return MakeUint128(hi, lo);
+}
+
+template <typename T>
+static void CheckArithmetic(int level, size_t n, std::mt19937_64 & random)
+{
+  std::vector<T> a(n), b(n), out(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = T(RandomValue(random));
+    b[i] = T(RandomValue(random));
+  }
+  T s = T(RandomValue(random));
+
+  bool ok = true;
+  AddN(out.data(), a.data(), b.data(), n);
+  for (size_t i = 0; i < n; i++)
+    ok &= out[i] == a[i] + b[i];
+  Expect(ok, "AddN", level, n);
+
+  ok = true;
+  SubN(out.data(), a.data(), b.data(), n);
+  for (size_t i = 0; i < n; i++)
+    ok &= out[i] == a[i] - b[i];
+  Expect(ok, "SubN", level, n);
+
+  ok = true;
+  NegN(out.data(), a.data(), n);
+  for (size_t i = 0; i < n; i++)
+    ok &= out[i] == -a[i];
+  Expect(ok, "NegN", level, n);
+
+  ok = true;
+  AddScalarN(out.data(), a.data(), s, n);
+  for (size_t i = 0; i < n; i++)
+    ok &= out[i] == a[i] + s;
+  Expect(ok, "AddScalarN", level, n);
+
+  ok = true;
+  std::vector<T> in_place = a;
+  SubScalarN(in_place.data(), in_place.data(), s, n);
+  for (size_t i = 0; i < n; i++)
+    ok &= in_place[i] == a[i] - s;
+  Expect(ok, "SubScalarN", level, n);
+}
+
+template <typename T>
+static void CheckMultiply(int level, size_t n, std::mt19937_64 & random)
+{
+  std::vector<T> a(n), b(n), out(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = T(RandomValue(random));
+    b[i] = T(RandomValue(random));
+  }
+  T s = T(RandomValue(random));
+
+  bool ok = true;
+  MulN(out.data(), a.data(), b.data(), n);
+  for (size_t i = 0; i < n; i++)
+    ok &= out[i] == a[i] * b[i];
+  Expect(ok, "MulN", level, n);
+
+  ok = true;
+  std::vector<T> in_place = a;
+  MulScalarN(in_place.data(), in_place.data(), s, n);
+  for (size_t i = 0; i < n; i++)
+    ok &= in_place[i] == a[i] * s;
+  Expect(ok, "MulScalarN", level, n);
+}
+
+static void CheckWide(int level, size_t n, std::mt19937_64 & random)
+{
+  std::vector<uint128_t> a(n), b(n), high(n), low(n), quotient(n);
+  std::vector<uint64_t> remainder(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = RandomValue(random);
+    b[i] = RandomValue(random);
+  }
+
+  bool ok = true;
+  MulWideN(high.data(), low.data(), a.data(), b.data(), n);
+  for (size_t i = 0; i < n; i++) {
+    uint128_t h;
+    uint128_t l = int128_t_internal::Multiply128To256(a[i], b[i], &h);
+    ok &= high[i] == h && low[i] == l;
+  }
+  Expect(ok, "MulWideN", level, n);
+
+  // Divisors of every width, including those with the top bit set, which
+  // need no normalization.
+  static const uint64_t divisors[] = {1, 2, 3, 10, 1000000007, uint64_t{1} << 63,
+                                      ~uint64_t{0}, ~uint64_t{0} - 1};
+  for (uint64_t divisor : divisors) {
+    ok = true;
+    DivModScalarN(quotient.data(), remainder.data(), a.data(), divisor, n);
+    for (size_t i = 0; i < n; i++)
+      ok &= quotient[i] == a[i] / divisor && remainder[i] == a[i] % divisor;
+    Expect(ok, "DivModScalarN", level, n);
+  }
+  const uint64_t divisor = random() >> (random() % 64) | 1;
+  ok = true;
+  std::vector<uint128_t> in_place = a;
+  DivModScalarN(in_place.data(), remainder.data(), in_place.data(), divisor, n);
+  for (size_t i = 0; i < n; i++)
+    ok &= in_place[i] == a[i] / divisor && remainder[i] == a[i] % divisor;
+  Expect(ok, "DivModScalarN(in place)", level, n);
+}
+
+static void BenchmarkMultiply(int level, std::mt19937_64 & random)
+{
+  const size_t n = 1 << 18;
+  std::vector<uint128_t> a(n), b(n), high(n), low(n);
+  std::vector<uint64_t> remainder(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = MakeUint128(random(), random());
+    b[i] = MakeUint128(random(), random());
+  }
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  volatile uint64_t ten = 10;
+  const uint128_t divisor = ten;
+  auto t0 = Clock::now();
+  MulN(low.data(), a.data(), b.data(), n);
+  auto t1 = Clock::now();
+  MulWideN(high.data(), low.data(), a.data(), b.data(), n);
+  auto t2 = Clock::now();
+  DivModScalarN(high.data(), remainder.data(), a.data(), ten, n);
+  auto t3 = Clock::now();
+  for (size_t i = 0; i < n; i++)
+    low[i] = a[i] / divisor;
+  auto t4 = Clock::now();
+  printf("multiply level %d: MulN %.2f ns, MulWideN %.2f ns, DivModScalarN %.2f ns, "
+         "operator/ %.2f ns\n", level, ns(t1 - t0), ns(t2 - t1), ns(t3 - t2), ns(t4 - t3));
+}
+
+static bool Compare(uint128_t x, CompareOp op, uint128_t c)
+{
+  switch (op) {
+    case CompareOp::kEq: return x == c;
+    case CompareOp::kNe: return x != c;
+    case CompareOp::kLt: return x < c;
+    case CompareOp::kLe: return x <= c;
+    case CompareOp::kGt: return x > c;
+    case CompareOp::kGe: return x >= c;
+  }
+  return false;
+}
+
+static bool Compare(int128_t x, CompareOp op, int128_t c)
+{
+  switch (op) {
+    case CompareOp::kEq: return x == c;
+    case CompareOp::kNe: return x != c;
+    case CompareOp::kLt: return x < c;
+    case CompareOp::kLe: return x <= c;
+    case CompareOp::kGt: return x > c;
+    case CompareOp::kGe: return x >= c;
+  }
+  return false;
+}
+
+// Checks a bitmap, including the cleared bits past n, and its selection.
+template <typename T, typename Predicate>
+static void CheckBitmap(const std::vector<uint64_t> & bitmap, size_t count,
+                        const std::vector<T> & values, Predicate predicate,
+                        const char * what, int level)
+{
+  size_t n = values.size(), expected = 0;
+  bool ok = true;
+  for (size_t i = 0; i < bitmap.size() * 64; i++) {
+    bool bit = (bitmap[i / 64] >> (i % 64)) & 1;
+    bool selected = i < n && predicate(values[i]);
+    ok &= bit == selected;
+    expected += selected;
+  }
+  ok &= count == expected;
+
+  std::vector<uint32_t> selection(n);
+  ok &= BitmapToSelection(bitmap.data(), n, selection.data()) == expected;
+  for (size_t k = 0, i = 0; i < n; i++)
+    if (predicate(values[i]))
+      ok &= selection[k++] == i;
+  Expect(ok, what, level, n);
+}
+
+template <typename T>
+static void CheckFilters(int level, size_t n, std::mt19937_64 & random)
+{
+  // Few distinct high halves, so that the low halves often decide.
+  std::vector<T> values(n);
+  for (size_t i = 0; i < n; i++) {
+    uint128_t v = RandomValue(random);
+    values[i] = T(MakeUint128(Uint128High64(v) % 4 - 2, Uint128Low64(v)));
+  }
+  BasicInt128Column<T> column(values);
+  std::vector<uint64_t> bitmap((n + 63) / 64, ~uint64_t{0});
+
+  std::vector<T> constants = {T(0), (std::numeric_limits<T>::min)(),
+                              (std::numeric_limits<T>::max)()};
+  for (int k = 0; k < 6; k++)
+    constants.push_back(n ? values[random() % n] : T(RandomValue(random)));
+  for (T c : constants) {
+    for (int o = 0; o <= static_cast<int>(CompareOp::kGe); o++) {
+      CompareOp op = static_cast<CompareOp>(o);
+      auto predicate = [&](T x) { return Compare(x, op, c); };
+      size_t count = CompareN(values.data(), n, op, c, bitmap.data());
+      CheckBitmap(bitmap, count, values, predicate, "CompareN", level);
+      count = CompareN(column, op, c, bitmap.data());
+      CheckBitmap(bitmap, count, values, predicate, "CompareN(column)", level);
+    }
+    for (T upper : constants) {
+      auto predicate = [&](T x) { return c <= x && x < upper; };
+      size_t count = BetweenN(values.data(), n, c, upper, bitmap.data());
+      CheckBitmap(bitmap, count, values, predicate, "BetweenN", level);
+      count = BetweenN(column, c, upper, bitmap.data());
+      CheckBitmap(bitmap, count, values, predicate, "BetweenN(column)", level);
+    }
+  }
+}
+
+// Sums at most 2^64 values into three 64-bit limbs.
+template <typename T>
+static void ReferenceSum(const std::vector<T> & values, uint64_t limbs[3])
+{
+  limbs[0] = limbs[1] = limbs[2] = 0;
+  for (T value : values) {
+    uint128_t v(value);
+    uint128_t low = MakeUint128(limbs[1], limbs[0]) + v;
+    limbs[2] += low < v;
+    if (std::is_signed<typename BasicInt192<T>::High>::value &&
+        Uint128High64(v) >> 63)
+      limbs[2]--;
+    limbs[0] = Uint128Low64(low);
+    limbs[1] = Uint128High64(low);
+  }
+}
+
+template <typename T>
+static void CheckReductions(int level, size_t n, std::mt19937_64 & random,
+                            Execution execution)
+{
+  std::vector<T> values(n);
+  for (size_t i = 0; i < n; i++)
+    values[i] = T(RandomValue(random));
+  if (n > 3) {
+    values[n / 3] = (std::numeric_limits<T>::min)();
+    values[n / 2] = (std::numeric_limits<T>::max)();
+  }
+
+  uint64_t limbs[3];
+  ReferenceSum(values, limbs);
+  BasicInt192<T> sum = Sum(values.data(), n, execution);
+  Expect(uint64_t(sum.high) == limbs[2] &&
+         sum.low == MakeUint128(limbs[1], limbs[0]), "Sum", level, n);
+  Expect(sum.FitsIn128() == (uint64_t(sum.high) ==
+         (std::is_signed<typename BasicInt192<T>::High>::value &&
+          Uint128High64(sum.low) >> 63 ? ~uint64_t{0} : 0)),
+         "FitsIn128", level, n);
+
+  if (n == 0)
+    return;
+  T min = values[0], max = values[0];
+  for (T v : values) {
+    if (v < min)
+      min = v;
+    if (max < v)
+      max = v;
+  }
+  std::pair<T, T> both = MinMax(values.data(), n, execution);
+  Expect(Min(values.data(), n, execution) == min, "Min", level, n);
+  Expect(Max(values.data(), n, execution) == max, "Max", level, n);
+  Expect(both.first == min && both.second == max, "MinMax", level, n);
+}
+
+template <typename T>
+static void CheckPrefixSums(int level, size_t n, std::mt19937_64 & random,
+                            Execution execution)
+{
+  std::vector<T> values(n), inclusive(n), exclusive(n);
+  for (size_t i = 0; i < n; i++)
+    values[i] = T(RandomValue(random));
+
+  InclusivePrefixSum(inclusive.data(), values.data(), n, execution);
+  ExclusivePrefixSum(exclusive.data(), values.data(), n, execution);
+  bool ok = true;
+  T sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    ok &= exclusive[i] == sum;
+    sum += values[i];
+    ok &= inclusive[i] == sum;
+  }
+  Expect(ok, "PrefixSum", level, n);
+
+  std::vector<T> in_place = values;
+  InclusivePrefixSum(in_place.data(), in_place.data(), n, execution);
+  Expect(in_place == inclusive, "InclusivePrefixSum(in place)", level, n);
+  in_place = values;
+  ExclusivePrefixSum(in_place.data(), in_place.data(), n, execution);
+  Expect(in_place == exclusive, "ExclusivePrefixSum(in place)", level, n);
+}
+
+int main(int argc, char ** argv)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+
+  std::mt19937_64 random(1);
+  int detected = static_cast<int>(int128_t_internal::DetectedKernelLevel());
+  for (int level = 0; level <= detected; level++) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    for (size_t n = 0; n < 40; n++) {
+      CheckArithmetic<uint128_t>(level, n, random);
+      CheckArithmetic<int128_t>(level, n, random);
+    }
+    CheckArithmetic<uint128_t>(level, 10001, random);
+    CheckArithmetic<int128_t>(level, 10001, random);
+    for (size_t n : {0, 1, 63, 64, 65, 200, 1000}) {
+      CheckFilters<uint128_t>(level, n, random);
+      CheckFilters<int128_t>(level, n, random);
+    }
+    for (size_t n = 0; n < 40; n++) {
+      CheckReductions<uint128_t>(level, n, random, Execution::kSequential);
+      CheckReductions<int128_t>(level, n, random, Execution::kSequential);
+    }
+    // Large enough to be split across the threads.
+    for (size_t n : {100000, 1000003}) {
+      CheckReductions<uint128_t>(level, n, random, Execution::kParallel);
+      CheckReductions<int128_t>(level, n, random, Execution::kParallel);
+      CheckPrefixSums<uint128_t>(level, n, random, Execution::kParallel);
+      CheckPrefixSums<int128_t>(level, n, random, Execution::kParallel);
+    }
+    CheckPrefixSums<uint128_t>(level, 1000, random, Execution::kSequential);
+    CheckPrefixSums<int128_t>(level, 0, random, Execution::kSequential);
+  }
+
+  int detected_mul = static_cast<int>(int128_t_internal::DetectedMulKernelLevel());
+  for (int level = 0; level <= detected_mul; level++) {
+    int128_t_internal::SetMulKernelLevel(static_cast<MulKernelLevel>(level));
+    for (size_t n = 0; n < 40; n++) {
+      CheckMultiply<uint128_t>(level, n, random);
+      CheckMultiply<int128_t>(level, n, random);
+      CheckWide(level, n, random);
+    }
+    CheckMultiply<uint128_t>(level, 10001, random);
+    CheckMultiply<int128_t>(level, 10001, random);
+    CheckWide(level, 10001, random);
+    BenchmarkMultiply(level, random);
+  }
+  printf("%s\n", ActiveKernelVariants().c_str());
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
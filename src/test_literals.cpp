@@ -0,0 +1,59 @@
+#include <cstdio>
+#include <stdint.h>
+
+#include "abslint128.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// Every base and separators, checked at compile time.
+static_assert(0_u128 == 0 && 00_u128 == 0 && 0x0_u128 == 0 && 0b0_u128 == 0, "zero");
+static_assert(42_u128 == 42 && 052_u128 == 42 && 0x2a_u128 == 42 && 0X2A_u128 == 42 &&
+              0b101010_u128 == 42 && 0B101010_u128 == 42, "bases");
+static_assert(1'000'000_u128 == 1000000 && 0xffff'ffff_u128 == 0xffffffffu &&
+              0b1'0000_u128 == 16, "separators");
+static_assert(18446744073709551616_u128 == MakeUint128(1, 0), "2^64");
+static_assert(0x1234'5678'9abc'def0'0fed'cba9'8765'4321_u128 ==
+              MakeUint128(0x123456789abcdef0, 0x0fedcba987654321), "hex");
+static_assert(340282366920938463463374607431768211455_u128 == Uint128Max(), "decimal max");
+static_assert(0xffffffffffffffffffffffffffffffff_u128 == Uint128Max(), "hex max");
+static_assert(03777777777777777777777777777777777777777777_u128 == Uint128Max(), "octal max");
+static_assert(0b11111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111_u128 ==
+              Uint128Max(), "binary max");
+
+static_assert(170141183460469231731687303715884105727_i128 == Int128Max(), "Int128Max");
+static_assert(-170141183460469231731687303715884105727_i128 - 1 == Int128Min(), "Int128Min");
+static_assert(-18'446'744'073'709'551'616_i128 == MakeInt128(-1, 0), "-2^64");
+static_assert(0x7fff'ffff'ffff'ffff'ffff'ffff'ffff'ffff_i128 == Int128Max(), "hex Int128Max");
+
+// Out-of-range literals do not compile, for example:
+//
+//   340282366920938463463374607431768211456_u128
+//   0x1'0000'0000'0000'0000'0000'0000'0000'0000_u128
+//   170141183460469231731687303715884105728_i128
+
+// The value is a constant even where it is not required to be one.
+static uint128_t Runtime(uint128_t offset)
+{
+  return 100000000000000000000000_u128 + offset;
+}
+
+int main()
+{
+  Expect(Runtime(0) == MakeUint128(0x152du, 0x2c7e14af6800000u), "Runtime");
+  Expect(uint128_t::ToString(123456789012345678901234567890_u128) ==
+         "123456789012345678901234567890", "ToString");
+  Expect(int128_t::ToString(-99999999999999999999999999999_i128) ==
+         "-99999999999999999999999999999", "ToString int128_t");
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_kernels.h"
+#include "int128_lpm.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// Answers lookups by probing one hash map per route length, longest first.
+class Reference
+{
+public:
+  Reference(const std::vector<LpmRoute128> & routes)
+  {
+    for (const auto & r : routes) {
+      by_length_[r.length][r.prefix & PrefixMask(r.length)] = r.value;
+    }
+  }
+
+  uint32_t Lookup(uint128_t key) const
+  {
+    for (auto it = by_length_.rbegin(); it != by_length_.rend(); ++it) {
+      auto found = it->second.find(key & PrefixMask(it->first));
+      if (found != it->second.end()) return found->second;
+    }
+    return LpmTable128::kNoMatch;
+  }
+
+private:
+  std::map<int, std::unordered_map<uint128_t, uint32_t>> by_length_;
+};
+
+static void CheckMasks()
+{
+  Expect(PrefixMask(0) == 0, "PrefixMask(0)");
+  Expect(PrefixMask(128) == Uint128Max(), "PrefixMask(128)");
+  Expect(PrefixMask(1) == MakeUint128(uint64_t{1} << 63, 0), "PrefixMask(1)");
+  Expect(PrefixMask(64) == MakeUint128(~uint64_t{0}, 0), "PrefixMask(64)");
+  Expect(PrefixMask(65) == MakeUint128(~uint64_t{0}, uint64_t{1} << 63),
+         "PrefixMask(65)");
+  for (int length = 0; length <= 128; length++) {
+    Expect(PrefixLength(PrefixMask(length)) == length, "PrefixLength");
+  }
+  Expect(PrefixLength(1) == -1, "PrefixLength non-contiguous");
+  Expect(PrefixLength(PrefixMask(48) | 1) == -1, "PrefixLength hole");
+}
+
+// Routes shaped like an IPv6 table: a few short aggregates, many /32 to /48
+// allocations under a handful of /16s, more specifics under some of them,
+// and host routes. Some routes repeat with a new value. No route is longer
+// than `max_length`.
+static std::vector<LpmRoute128> MakeRoutes(std::mt19937_64 & random, size_t n,
+                                           int max_length = 128)
+{
+  static const int kLengths[] = {19, 24, 29, 32, 32, 36, 40, 44, 48, 48, 48,
+                                 52, 56, 60, 64, 64, 96, 127, 128};
+  std::vector<LpmRoute128> routes = {{0, 0, 1}, {MakeUint128(0x2000ull << 48, 0), 3, 2}};
+  while (routes.size() < n) {
+    const uint32_t value = uint32_t(routes.size());
+    if (random() % 8 == 0 && routes.size() > 2) {
+      // A more specific route or a replacement of an existing one.
+      LpmRoute128 r = routes[random() % routes.size()];
+      if (random() % 2 && r.length < max_length) {
+        r.length += 1 + int(random() % (max_length - r.length));
+        r.prefix |= MakeUint128(random(), random()) & ~PrefixMask(r.length - 1);
+      }
+      r.value = value;
+      routes.push_back(r);
+      continue;
+    }
+    const uint64_t top = (0x2001ull + random() % 6) << 48;
+    const int length = std::min(
+        max_length, kLengths[random() % (sizeof(kLengths) / sizeof(kLengths[0]))]);
+    // Host bits are left set; the table must ignore them.
+    routes.push_back({MakeUint128(top | (random() >> 16), random()), length, value});
+  }
+  return routes;
+}
+
+static void CheckTable(std::mt19937_64 & random, size_t n)
+{
+  const std::vector<LpmRoute128> routes = MakeRoutes(random, n);
+  LpmTable128 table(routes.data(), routes.size());
+  Reference reference(routes);
+
+  // Keys inside routes, on their first and last addresses, and at random.
+  std::vector<uint128_t> keys;
+  for (const auto & r : routes) {
+    const uint128_t base = r.prefix & PrefixMask(r.length);
+    keys.push_back(base);
+    keys.push_back(base | ~PrefixMask(r.length));
+    keys.push_back(base | (MakeUint128(random(), random()) & ~PrefixMask(r.length)));
+  }
+  for (size_t i = 0; i < n; i++) keys.push_back(MakeUint128(random(), random()));
+
+  std::vector<uint32_t> values(keys.size());
+  table.LookupN(keys.data(), keys.size(), values.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    const uint32_t expected = reference.Lookup(keys[i]);
+    Expect(table.Lookup(keys[i]) == expected, "Lookup");
+    Expect(values[i] == expected, "LookupN");
+  }
+  printf("%zu routes: %zu bytes\n", routes.size(), table.MemoryUsage());
+}
+
+static void CheckEmpty()
+{
+  LpmTable128 empty;
+  Expect(empty.Lookup(12345) == LpmTable128::kNoMatch, "empty table");
+  LpmRoute128 host = {MakeUint128(1, 2), 128, 5};
+  LpmTable128 one(&host, 1);
+  Expect(one.Lookup(MakeUint128(1, 2)) == 5, "host route");
+  Expect(one.Lookup(MakeUint128(1, 3)) == LpmTable128::kNoMatch, "host route miss");
+  LpmRoute128 all = {MakeUint128(9, 9), 0, 6};
+  LpmTable128 default_route(&all, 1);
+  Expect(default_route.Lookup(0) == 6 && default_route.Lookup(Uint128Max()) == 6,
+         "default route");
+}
+
+// A table the size of a full IPv6 routing table, where no route is longer
+// than /48.
+static void Benchmark(std::mt19937_64 & random)
+{
+  const std::vector<LpmRoute128> routes = MakeRoutes(random, 200000, 48);
+  LpmTable128 table(routes.data(), routes.size());
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> keys(n);
+  for (auto & k : keys) {
+    const LpmRoute128 & r = routes[random() % routes.size()];
+    k = (r.prefix & PrefixMask(r.length)) |
+        (MakeUint128(random(), random()) & ~PrefixMask(r.length));
+  }
+  std::vector<uint32_t> values(n);
+
+  using Clock = std::chrono::steady_clock;
+  uint64_t sum = 0;
+  auto t0 = Clock::now();
+  for (const auto & k : keys) sum += table.Lookup(k);
+  auto t1 = Clock::now();
+  table.LookupN(keys.data(), n, values.data());
+  auto t2 = Clock::now();
+  for (uint32_t v : values) sum -= v;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  printf("%zu routes, %zu bytes: Lookup %.1f ns/key, LookupN %.1f ns/key\n",
+         routes.size(), table.MemoryUsage(), ns(t1 - t0), ns(t2 - t1));
+  Expect(sum == 0, "benchmark LookupN");
+}
+
+int main()
+{
+  std::mt19937_64 random(39);
+  CheckMasks();
+  CheckEmpty();
+  CheckTable(random, 100);
+  CheckTable(random, 20000);
+  // Without popcnt.
+  int128_t_internal::SetKernelLevel(int128_t_internal::KernelLevel::kPortable);
+  CheckTable(random, 2000);
+  int128_t_internal::SetKernelLevel(int128_t_internal::DetectedKernelLevel());
+  Benchmark(random);
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,301 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_random.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// PCG64 DXSM written with plain 128-bit arithmetic.
+static uint64_t ReferencePcgNext(uint128_t & state, uint128_t increment)
+{
+  uint64_t hi = Uint128High64(state);
+  uint64_t lo = Uint128Low64(state) | 1;
+  state = state * uint128_t(Pcg64Dxsm::kMultiplier) + increment;
+  hi ^= hi >> 32;
+  hi *= Pcg64Dxsm::kMultiplier;
+  hi ^= hi >> 48;
+  return hi * lo;
+}
+
+static void CheckPcg()
+{
+  const uint128_t seed = MakeUint128(0x0123456789abcdefull, 0xfedcba9876543210ull);
+  const uint128_t stream = 12345;
+  Pcg64Dxsm engine(seed, stream);
+
+  const uint128_t increment = (stream << 1) | 1;
+  uint128_t state = 0;
+  ReferencePcgNext(state, increment);
+  state += seed;
+  ReferencePcgNext(state, increment);
+  for (int i = 0; i < 1000; i++) {
+    if (i % 2) {
+      uint64_t hi = ReferencePcgNext(state, increment);
+      uint64_t lo = ReferencePcgNext(state, increment);
+      Expect(engine() == MakeUint128(hi, lo), "Pcg64Dxsm draw");
+    } else {
+      Expect(engine.Next64() == ReferencePcgNext(state, increment),
+             "Pcg64Dxsm Next64");
+    }
+  }
+
+  Pcg64Dxsm a(7), b(7), c(7, 1);
+  Expect(a == b && a != c, "Pcg64Dxsm streams");
+  for (uint64_t n : {0ull, 1ull, 2ull, 5ull, 1000ull}) {
+    Pcg64Dxsm stepped = a;
+    for (uint64_t i = 0; i < n; i++) stepped();
+    Pcg64Dxsm jumped = a;
+    jumped.discard(n);
+    Expect(jumped == stepped, "Pcg64Dxsm discard");
+  }
+  // The LCG has period 2^128 steps, which is 2^127 draws.
+  Pcg64Dxsm full = a;
+  full.discard(uint128_t(1) << 127);
+  Expect(full == a, "Pcg64Dxsm period");
+}
+
+// Vigna's reference xoshiro256++.
+static uint64_t ReferenceXoshiroNext(uint64_t * s)
+{
+  auto rotl = [](uint64_t x, int k) { return (x << k) | (x >> (64 - k)); };
+  const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+  const uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+// A 256x256 matrix over GF(2): row i holds the bits of output bit i.
+struct BitMatrix
+{
+  uint64_t rows[256][4];
+};
+
+static void Apply(const BitMatrix & m, const uint64_t * in, uint64_t * out)
+{
+  for (int i = 0; i < 4; i++) out[i] = 0;
+  for (int i = 0; i < 256; i++) {
+    uint64_t parity = 0;
+    for (int w = 0; w < 4; w++) parity ^= m.rows[i][w] & in[w];
+    out[i / 64] |= uint64_t(__builtin_popcountll(parity) & 1) << (i % 64);
+  }
+}
+
+static BitMatrix Square(const BitMatrix & m)
+{
+  // Row i of m*m is the xor of the rows j of m for the bits j set in row i.
+  BitMatrix r;
+  for (int i = 0; i < 256; i++) {
+    uint64_t acc[4] = {0, 0, 0, 0};
+    for (int j = 0; j < 256; j++) {
+      if ((m.rows[i][j / 64] >> (j % 64)) & 1) {
+        for (int w = 0; w < 4; w++) acc[w] ^= m.rows[j][w];
+      }
+    }
+    for (int w = 0; w < 4; w++) r.rows[i][w] = acc[w];
+  }
+  return r;
+}
+
+// The state Xoshiro256PlusPlus(seed) starts from.
+static void SeedState(uint64_t seed, uint64_t * s)
+{
+  for (int i = 0; i < 4; i++) {
+    seed += 0x9e3779b97f4a7c15ull;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    s[i] = z ^ (z >> 31);
+  }
+}
+
+static void CheckXoshiro()
+{
+  Xoshiro256PlusPlus engine(99);
+  uint64_t s[4];
+  SeedState(99, s);
+  for (int i = 0; i < 1000; i++) {
+    uint64_t hi = ReferenceXoshiroNext(s);
+    uint64_t lo = ReferenceXoshiroNext(s);
+    Expect(engine() == MakeUint128(hi, lo), "Xoshiro256PlusPlus draw");
+  }
+
+  // The step is linear over GF(2). Build its matrix from the images of the
+  // unit states, square it 128 times to get 2^128 steps, and compare with
+  // Jump().
+  BitMatrix step;
+  for (int i = 0; i < 256; i++) {
+    for (int w = 0; w < 4; w++) step.rows[i][w] = 0;
+  }
+  for (int j = 0; j < 256; j++) {
+    uint64_t unit[4] = {0, 0, 0, 0};
+    unit[j / 64] = uint64_t{1} << (j % 64);
+    ReferenceXoshiroNext(unit);
+    for (int i = 0; i < 256; i++) {
+      if ((unit[i / 64] >> (i % 64)) & 1) {
+        step.rows[i][j / 64] |= uint64_t{1} << (j % 64);
+      }
+    }
+  }
+  BitMatrix jump = step;
+  for (int k = 0; k < 128; k++) jump = Square(jump);
+
+  Xoshiro256PlusPlus jumped(5);
+  jumped.Jump();
+  uint64_t start[4], expected[4];
+  SeedState(5, start);
+  Apply(jump, start, expected);
+  for (int i = 0; i < 100; i++) {
+    uint64_t hi = ReferenceXoshiroNext(expected);
+    uint64_t lo = ReferenceXoshiroNext(expected);
+    Expect(jumped() == MakeUint128(hi, lo), "Xoshiro256PlusPlus Jump");
+  }
+}
+
+// Returns the next value of a fixed list, for driving the rejection path.
+class ScriptedEngine
+{
+public:
+  using result_type = uint128_t;
+  explicit ScriptedEngine(std::vector<uint128_t> values) : values_(values) {}
+  uint128_t operator()() { return values_[next_++]; }
+  size_t used() const { return next_; }
+
+private:
+  std::vector<uint128_t> values_;
+  size_t next_ = 0;
+};
+
+// Counts how often draws fall below `split`, a fraction `p` of the range
+// [0, size), and checks that against the binomial distribution.
+template <typename Engine>
+static void CheckFraction(Engine & engine, const char * name, uint128_t size,
+                          uint128_t split, double p)
+{
+  const int n = 100000;
+  int below = 0;
+  for (int i = 0; i < n; i++) {
+    uint128_t v = UniformUint128(engine, 0, size - 1);
+    Expect(v <= size - 1, name);
+    below += v < split;
+  }
+  const double sigma = std::sqrt(n * p * (1 - p));
+  printf("%-28s %d of %d below split, expected %.0f +- %.0f\n", name, below, n,
+         n * p, sigma);
+  Expect(std::fabs(below - n * p) < 5 * sigma, name);
+}
+
+static void CheckUniform()
+{
+  Xoshiro256PlusPlus engine(1);
+  const uint128_t big = MakeUint128(0x8000000000000000ull, 0);  // 2^127
+
+  // Ranges at the edges.
+  Expect(UniformUint128(engine, 5, 5) == 5, "UniformUint128 single value");
+  for (int i = 0; i < 1000; i++) {
+    uint128_t v = UniformUint128(engine, big - 1, big);
+    Expect(v == big - 1 || v == big, "UniformUint128 two values");
+    v = UniformUint128(engine, Uint128Max() - 2, Uint128Max());
+    Expect(v >= Uint128Max() - 2, "UniformUint128 top of range");
+  }
+  // The full range passes draws through.
+  Xoshiro256PlusPlus a(3), b(3);
+  Expect(UniformUint128(a, 0, Uint128Max()) == b(), "UniformUint128 full range");
+
+  // Lemire's method with size 2^127 + 1: the draw 0 has a low product below
+  // the threshold 2^127 - 1 and is rejected; the draw 5 yields floor(5 * size
+  // / 2^128) = 2.
+  ScriptedEngine scripted({0, 5});
+  Expect(UniformUint128(scripted, 10, 10 + big) == 12 && scripted.used() == 2,
+         "UniformUint128 rejection");
+
+  // A modulo reduction would return [0, 2^126) for half of the draws when
+  // size = 3 * 2^126; an unbiased method, for a third.
+  CheckFraction(engine, "size 3*2^126", 3 * (big >> 1), big >> 1, 1.0 / 3);
+  // Nearly half of all draws are rejected for size 2^127 + 1; the accepted
+  // ones must still be uniform.
+  CheckFraction(engine, "size 2^127+1", big + 1, big >> 1, 0.5);
+  Pcg64Dxsm pcg(11);
+  CheckFraction(pcg, "size 7 (pcg)", 7, 3, 3.0 / 7);
+  CheckFraction(pcg, "size 10^30 (pcg)",
+                uint128_t(1000000000000000ull) * 1000000000000000ull,
+                uint128_t(1000000000000000ull) * 100000000000000ull, 0.1);
+
+  // Each residue of a small range equally often.
+  const int kSize = 6;
+  const int n = 60000;
+  int counts[kSize] = {};
+  for (int i = 0; i < n; i++) counts[Uint128Low64(UniformUint128(engine, 0, kSize - 1))]++;
+  double chi2 = 0;
+  for (int c : counts) chi2 += (c - n / kSize) * double(c - n / kSize) / (n / kSize);
+  Expect(chi2 < 25, "UniformUint128 chi-square");  // p ~ 1e-4 for 5 dof
+
+  // The bulk variants give the same values as single draws.
+  const uint128_t lo = 1000, hi = lo + 3 * (big >> 1);
+  std::vector<uint128_t> bulk(1000), raw(1000);
+  Pcg64Dxsm e1(21), e2(21), e3(21), e4(21);
+  FillUniformUint128(e1, bulk.data(), bulk.size(), lo, hi);
+  FillRandom(e3, raw.data(), raw.size());
+  for (size_t i = 0; i < bulk.size(); i++) {
+    Expect(bulk[i] == UniformUint128(e2, lo, hi), "FillUniformUint128");
+    Expect(raw[i] == e4(), "FillRandom");
+  }
+}
+
+static void Benchmark()
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> out(n);
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  std::mt19937_64 mt(1);
+  Pcg64Dxsm pcg(1);
+  Xoshiro256PlusPlus xoshiro(1);
+  const uint128_t size = uint128_t(1000000000000000ull) * 1000000000000000ull;
+
+  auto t0 = Clock::now();
+  for (auto & v : out) v = MakeUint128(mt(), mt());
+  auto t1 = Clock::now();
+  FillRandom(pcg, out.data(), n);
+  auto t2 = Clock::now();
+  FillRandom(xoshiro, out.data(), n);
+  auto t3 = Clock::now();
+  for (auto & v : out) v = MakeUint128(mt(), mt()) % size;
+  auto t4 = Clock::now();
+  FillUniformUint128(xoshiro, out.data(), n, 0, size - 1);
+  auto t5 = Clock::now();
+  printf("ns/value: mt19937_64 x2 %.1f, Pcg64Dxsm %.1f, Xoshiro256PlusPlus "
+         "%.1f; in [0, 10^30): mt19937_64 modulo %.1f, xoshiro Lemire %.1f\n",
+         ns(t1 - t0), ns(t2 - t1), ns(t3 - t2), ns(t4 - t3), ns(t5 - t4));
+}
+
+int main()
+{
+  CheckPcg();
+  CheckXoshiro();
+  CheckUniform();
+  Benchmark();
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <random>
+#include <stdint.h>
+
+#include "abslint128.h"
+
+using namespace absl;
+
+// Returns true if r^n <= v, checking for overflow with division so that the
+// check does not share code with the implementation.
+static bool PowNotAbove(uint128_t r, int n, uint128_t v)
+{
+  uint128_t p = 1;
+  for (int i = 0; i < n; i++) {
+    bool small = Uint128High64(p) == 0 && Uint128High64(r) == 0;
+    if (!small && r != 0 && p > Uint128Max() / r)
+      return false;
+    p *= r;
+  }
+  return p <= v;
+}
+
+static int Check(uint128_t v, int n)
+{
+  uint128_t r = Iroot(v, n);
+  if (n == 2 && r != Isqrt(v))
+    return 1;
+  if (n == 3 && r != Icbrt(v))
+    return 1;
+  if (PowNotAbove(r, n, v) &&
+      (r == Uint128Max() || !PowNotAbove(r + 1, n, v)))
+    return 0;
+  fprintf(stderr, "Error : Iroot(%s, %d) = %s\n",
+    uint128_t::ToString(v).c_str(), n, uint128_t::ToString(r).c_str());
+  return 1;
+}
+
+int main(int argc, char ** argv)
+{
+  int errors = 0;
+
+  // Small values and the extremes.
+  #pragma omp parallel for reduction(+:errors)
+  for (uint64_t v = 0; v < 1u << 14; v++)
+    for (int n = 1; n <= 8; n++)
+      errors += Check(v, n);
+  for (int n = 1; n <= 130; n++) {
+    errors += Check(Uint128Max(), n);
+    errors += Check(Uint128Max() - 1, n);
+    errors += Check(MakeUint128(1, 0), n);
+  }
+
+  // Perfect powers and their neighbours, where estimates are most fragile.
+  #pragma omp parallel for reduction(+:errors)
+  for (int n = 2; n <= 12; n++) {
+    std::mt19937_64 random(n);
+    int bits = 128 / n;
+    for (int i = 0; i < 20000; i++) {
+      uint128_t k = (uint128_t(random()) << 64 | random()) >> (128 - bits);
+      uint128_t p = 1;
+      for (int j = 0; j < n; j++)
+        p *= k;
+      errors += Check(p, n) + Check(p - 1, n) + Check(p + 1, n);
+    }
+  }
+
+  // Uniform values of every width.
+  #pragma omp parallel for reduction(+:errors)
+  for (int shift = 0; shift < 128; shift++) {
+    std::mt19937_64 random(shift);
+    for (int i = 0; i < 4000; i++) {
+      uint128_t v = (uint128_t(random()) << 64 | random()) >> shift;
+      errors += Check(v, 2) + Check(v, 3) + Check(v, 2 + i % 11);
+    }
+  }
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
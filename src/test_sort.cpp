@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "abslint128.h"
+#include "int128_sort.h"
+
+using namespace absl;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what, size_t n)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s (n %zu)\n", what, n);
+    errors++;
+  }
+}
+
+// Keys of a few shapes: random, mostly equal bytes (skipped passes), and
+// many duplicates (stability).
+static uint128_t RandomKey(std::mt19937_64 & random, int shape)
+{
+  switch (shape) {
+    case 0: return MakeUint128(random(), random());
+    case 1: return MakeUint128(0x20010db800000000, random() & 0xffff0000);
+    case 2: return MakeUint128(random() % 3 - 1, random() % 5);
+    default: return uint128_t(random() % 1000) << 60;
+  }
+}
+
+template <typename T>
+static void CheckSort(size_t n, int shape, Execution execution,
+                      std::mt19937_64 & random)
+{
+  std::vector<T> keys(n);
+  for (size_t i = 0; i < n; i++)
+    keys[i] = T(RandomKey(random, shape));
+
+  std::vector<T> sorted = keys;
+  RadixSort(sorted.data(), n, execution);
+  std::vector<T> expected = keys;
+  std::sort(expected.begin(), expected.end());
+  Expect(sorted == expected, "RadixSort", n);
+
+  sorted = keys;
+  Sort(sorted.data(), n, execution);
+  Expect(sorted == expected, "Sort", n);
+
+  // Sort indices along with the keys and compare against a stable sort.
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+  std::vector<T> by_key = keys;
+  std::vector<uint32_t> values32(n);
+  for (size_t i = 0; i < n; i++)
+    values32[i] = uint32_t(i);
+  RadixSortByKey(by_key.data(), values32.data(), n, execution);
+  bool ok = by_key == expected;
+  for (size_t i = 0; i < n; i++)
+    ok &= values32[i] == order[i];
+  Expect(ok, "RadixSortByKey(uint32_t)", n);
+
+  by_key = keys;
+  std::vector<uint64_t> values64(n);
+  for (size_t i = 0; i < n; i++)
+    values64[i] = uint64_t(i) << 32;
+  RadixSortByKey(by_key.data(), values64.data(), n, execution);
+  ok = by_key == expected;
+  for (size_t i = 0; i < n; i++)
+    ok &= values64[i] == uint64_t(order[i]) << 32;
+  Expect(ok, "RadixSortByKey(uint64_t)", n);
+}
+
+int main(int argc, char ** argv)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+
+  std::mt19937_64 random(1);
+  for (int shape = 0; shape < 4; shape++) {
+    for (size_t n : {0, 1, 2, 63, 64, 65, 1000, 70000}) {
+      CheckSort<uint128_t>(n, shape, Execution::kSequential, random);
+      CheckSort<int128_t>(n, shape, Execution::kSequential, random);
+    }
+    // Large enough to be split across the threads.
+    CheckSort<uint128_t>(300001, shape, Execution::kParallel, random);
+    CheckSort<int128_t>(300001, shape, Execution::kParallel, random);
+#ifdef _OPENMP
+    // An odd number of chunks leaves a run out of the first merge round.
+    omp_set_num_threads(3);
+    CheckSort<uint128_t>(262147, shape, Execution::kParallel, random);
+    omp_set_num_threads(4);
+#endif
+  }
+
+  if (errors)
+    fprintf(stderr, "%d errors\n", errors);
+
+  printf("Done!\n");
+
+  return errors != 0;
+}
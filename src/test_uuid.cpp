@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_kernels.h"
+#include "int128_uuid.h"
+
+using namespace absl;
+using int128_t_internal::KernelLevel;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+static void CheckKnown()
+{
+  const uint128_t value = MakeUint128(0x123e4567e89b12d3u, 0xa456426614174000u);
+  const char * text = "123e4567-e89b-12d3-a456-426614174000";
+  Uuid uuid;
+  Expect(Uuid::Parse(text, strlen(text), &uuid) && uuid.value() == value, "Parse");
+  Expect(Uuid::Parse(std::string("123E4567-E89B-12D3-A456-426614174000"), &uuid) &&
+         uuid.value() == value, "Parse uppercase");
+  Expect(Uuid(value).ToString() == text, "ToString");
+  Expect(uuid.version() == 1 && uuid.variant() == UuidVariant::kRfc4122, "version");
+  Expect(Uuid().ToString() == "00000000-0000-0000-0000-000000000000", "nil");
+  Expect(Uuid(Uint128Max()).ToString() == "ffffffff-ffff-ffff-ffff-ffffffffffff", "max");
+
+  Uuid v4;
+  Expect(Uuid::Parse(std::string("f47ac10b-58cc-4372-a567-0e02b2c3d479"), &v4) &&
+         v4.version() == 4 && v4.variant() == UuidVariant::kRfc4122, "version 4");
+  Uuid v7;
+  Expect(Uuid::Parse(std::string("01890a5d-ac96-774b-bcce-b302099a8057"), &v7) &&
+         v7.version() == 7, "version 7");
+  Uuid guid;
+  Expect(Uuid::Parse(std::string("00000000-0000-0000-c000-000000000046"), &guid) &&
+         guid.variant() == UuidVariant::kMicrosoft, "Microsoft variant");
+  Expect(Uuid().variant() == UuidVariant::kNcs &&
+         Uuid(Uint128Max()).variant() == UuidVariant::kFuture, "other variants");
+
+  Expect(std::hash<Uuid>()(uuid) == std::hash<uint128_t>()(value), "hash");
+}
+
+static void CheckInvalid()
+{
+  const std::string good = "123e4567-e89b-12d3-a456-426614174000";
+  Uuid uuid(MakeUint128(1, 2));
+  Expect(!Uuid::Parse(good.substr(0, 35), &uuid), "short");
+  Expect(!Uuid::Parse(good + "0", &uuid), "long");
+  Expect(!Uuid::Parse(std::string("123e4567e89b12d3a456426614174000"), &uuid),
+         "no hyphens");
+  for (size_t i = 0; i < good.size(); i++) {
+    const bool hyphen = i == 8 || i == 13 || i == 18 || i == 23;
+    for (char c : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\x80', '\xc1', '-', '0'}) {
+      // A hyphen where one belongs, or a digit where one belongs, is valid.
+      if (c == (hyphen ? '-' : '0')) continue;
+      std::string bad = good;
+      bad[i] = c;
+      Expect(!Uuid::Parse(bad, &uuid), "invalid character");
+    }
+  }
+  Expect(uuid.value() == MakeUint128(1, 2), "unchanged on failure");
+}
+
+static void CheckRandom(std::mt19937_64 & random)
+{
+  // Any mix of cases parses to the same value.
+  char text[kUuidStringLength];
+  for (int i = 0; i < 10000; i++) {
+    const Uuid uuid(MakeUint128(random(), random()));
+    uuid.Format(text);
+    for (char & c : text) {
+      if (c >= 'a' && random() % 2) c = static_cast<char>(c - 'a' + 'A');
+    }
+    Uuid parsed;
+    Expect(Uuid::Parse(text, sizeof(text), &parsed) && parsed == uuid, "round trip");
+  }
+
+  // Values order as their text does.
+  std::vector<Uuid> uuids(1000);
+  for (auto & u : uuids) u = Uuid(MakeUint128(random() % 4, random()));
+  std::vector<std::string> texts;
+  for (const Uuid & u : uuids) texts.push_back(u.ToString());
+  std::sort(uuids.begin(), uuids.end());
+  std::sort(texts.begin(), texts.end());
+  bool ordered = true;
+  for (size_t i = 0; i < uuids.size(); i++) ordered &= uuids[i].ToString() == texts[i];
+  Expect(ordered, "ordering");
+}
+
+static void CheckBatch(std::mt19937_64 & random)
+{
+  const size_t n = 1000;
+  const size_t stride = kUuidStringLength + 1;
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = MakeUint128(random(), random());
+  // The exact size, so that reading past the last UUID would overrun.
+  std::vector<char> text(stride * (n - 1) + kUuidStringLength, '\n');
+  FormatUuids(values.data(), n, text.data(), stride);
+  bool same = true;
+  for (size_t i = 0; i < n; i++) {
+    same &= std::string(text.data() + i * stride, kUuidStringLength) ==
+            Uuid(values[i]).ToString();
+    same &= i + 1 == n || text[i * stride + kUuidStringLength] == '\n';
+  }
+  Expect(same, "FormatUuids");
+
+  std::vector<uint128_t> parsed(n);
+  Expect(ParseUuids(text.data(), stride, n, parsed.data()) == n && parsed == values,
+         "ParseUuids");
+  std::vector<Uuid> uuids(n);
+  std::vector<char> again(text.size(), '\n');
+  Expect(ParseUuids(text.data(), stride, n, uuids.data()) == n, "ParseUuids(Uuid)");
+  FormatUuids(uuids.data(), n, again.data(), stride);
+  Expect(again == text, "FormatUuids(Uuid)");
+
+  text[500 * stride + 30] = 'x';
+  Expect(ParseUuids(text.data(), stride, n, parsed.data()) == 500, "ParseUuids error");
+}
+
+static void Benchmark(int level, std::mt19937_64 & random)
+{
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values(n);
+  for (auto & v : values) v = MakeUint128(random(), random());
+  std::vector<char> text(n * kUuidStringLength);
+  std::vector<uint128_t> parsed(n);
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  auto t0 = Clock::now();
+  FormatUuids(values.data(), n, text.data(), kUuidStringLength);
+  auto t1 = Clock::now();
+  const size_t count = ParseUuids(text.data(), kUuidStringLength, n, parsed.data());
+  auto t2 = Clock::now();
+  Expect(count == n && parsed == values, "benchmark round trip");
+  printf("level %d: format %.2f ns/uuid, parse %.2f ns/uuid\n", level, ns(t1 - t0),
+         ns(t2 - t1));
+}
+
+int main()
+{
+  std::mt19937_64 random(45);
+  const int detected = static_cast<int>(int128_t_internal::DetectedKernelLevel());
+  for (int level = 0; level <= detected; level++) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    CheckKnown();
+    CheckInvalid();
+    CheckRandom(random);
+    CheckBatch(random);
+  }
+  for (int level : {0, detected}) {
+    int128_t_internal::SetKernelLevel(static_cast<KernelLevel>(level));
+    Benchmark(level, random);
+  }
+  printf("Done!\n");
+  return errors != 0;
+}
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include "abslint128.h"
+#include "int128_kernels.h"
+#include "int128_varint.h"
+
+using namespace absl;
+using int128_t_internal::MulKernelLevel;
+
+static int errors = 0;
+
+static void Expect(bool ok, const char * what)
+{
+  if (!ok) {
+    fprintf(stderr, "Error : %s\n", what);
+    errors++;
+  }
+}
+
+// LEB128 written byte by byte.
+static std::vector<uint8_t> ReferenceEncode(uint128_t v)
+{
+  std::vector<uint8_t> out;
+  do {
+    uint8_t byte = Uint128Low64(v) & 0x7f;
+    v >>= 7;
+    if (v != 0) byte |= 0x80;
+    out.push_back(byte);
+  } while (v != 0);
+  return out;
+}
+
+// Values of every length, with the bits at each end of the groups set.
+static std::vector<uint128_t> TestValues(std::mt19937_64 & random)
+{
+  std::vector<uint128_t> values = {0, 1, 127, 128, 255, 16383, 16384,
+                                   Uint128Max(), Uint128Max() >> 1};
+  for (int bits = 1; bits <= 128; bits++) {
+    const uint128_t top = uint128_t(1) << (bits - 1);
+    values.push_back(top);
+    values.push_back(top | (top - 1));
+    values.push_back(top | (MakeUint128(random(), random()) & (top - 1)));
+  }
+  return values;
+}
+
+static void CheckScalar(const std::vector<uint128_t> & values)
+{
+  uint8_t buffer[kMaxVarint128Bytes + 8];
+  for (uint128_t v : values) {
+    const std::vector<uint8_t> expected = ReferenceEncode(v);
+    Expect(Varint128Length(v) == expected.size(), "Varint128Length");
+    uint8_t * end = EncodeVarint128(v, buffer);
+    Expect(size_t(end - buffer) == expected.size() &&
+           std::memcmp(buffer, expected.data(), expected.size()) == 0,
+           "EncodeVarint128");
+
+    // Exactly the encoded bytes: the decoder must not need more.
+    std::vector<uint8_t> exact(expected);
+    uint128_t decoded = 0;
+    const uint8_t * next = DecodeVarint128(exact.data(), exact.data() + exact.size(), &decoded);
+    Expect(next == exact.data() + exact.size() && decoded == v, "DecodeVarint128");
+    // Every truncation fails.
+    for (size_t size = 0; size < exact.size(); size++) {
+      Expect(DecodeVarint128(exact.data(), exact.data() + size, &decoded) == nullptr,
+             "DecodeVarint128 truncated");
+    }
+    // Followed by more input.
+    std::vector<uint8_t> padded(expected);
+    padded.resize(expected.size() + 30, 0xff);
+    next = DecodeVarint128(padded.data(), padded.data() + padded.size(), &decoded);
+    Expect(next == padded.data() + expected.size() && decoded == v,
+           "DecodeVarint128 padded");
+  }
+
+  // Redundant zero groups are accepted; more than 128 bits or more than
+  // kMaxVarint128Bytes bytes are not.
+  for (size_t tail : {0, 30}) {
+    std::vector<uint8_t> bytes = {0x80, 0x80, 0x00};
+    bytes.resize(bytes.size() + tail, 0xff);
+    uint128_t decoded = 1;
+    Expect(DecodeVarint128(bytes.data(), bytes.data() + bytes.size(), &decoded) ==
+               bytes.data() + 3 && decoded == 0,
+           "DecodeVarint128 redundant zeros");
+
+    bytes.assign(18, 0xff);
+    bytes.push_back(0x04);  // bit 128
+    bytes.resize(bytes.size() + tail, 0);
+    Expect(DecodeVarint128(bytes.data(), bytes.data() + bytes.size(), &decoded) == nullptr,
+           "DecodeVarint128 overflow");
+    bytes.assign(18, 0xff);
+    bytes.push_back(0x03);
+    bytes.resize(bytes.size() + tail, 0);
+    Expect(DecodeVarint128(bytes.data(), bytes.data() + bytes.size(), &decoded) ==
+               bytes.data() + 19 && decoded == Uint128Max(),
+           "DecodeVarint128 maximum");
+    bytes.assign(19, 0x80);
+    bytes.push_back(0x00);
+    bytes.resize(bytes.size() + tail, 0);
+    Expect(DecodeVarint128(bytes.data(), bytes.data() + bytes.size(), &decoded) == nullptr,
+           "DecodeVarint128 too long");
+  }
+}
+
+static void CheckZigZag(std::mt19937_64 & random)
+{
+  static_assert(Uint128Low64(ZigZagEncode128(0)) == 0, "ZigZagEncode128(0)");
+  static_assert(Uint128Low64(ZigZagEncode128(-1)) == 1, "ZigZagEncode128(-1)");
+  static_assert(Uint128Low64(ZigZagEncode128(1)) == 2, "ZigZagEncode128(1)");
+  static_assert(Int128Low64(ZigZagDecode128(3)) == uint64_t(-2) &&
+                Int128High64(ZigZagDecode128(3)) == -1, "ZigZagDecode128(3)");
+  Expect(ZigZagEncode128(Int128Max()) == Uint128Max() - 1, "ZigZagEncode128 max");
+  Expect(ZigZagEncode128(Int128Min()) == Uint128Max(), "ZigZagEncode128 min");
+  for (int i = 0; i < 10000; i++) {
+    const int128_t v = int128_t(MakeUint128(random(), random())) >> (i % 128);
+    const int128_t s = i % 2 ? -v : v;
+    const uint128_t z = ZigZagEncode128(s);
+    Expect(ZigZagDecode128(z) == s, "ZigZagDecode128");
+    Expect(z == (s < 0 ? (uint128_t(-(s + 1)) << 1) + 1 : uint128_t(s) << 1),
+           "ZigZagEncode128");
+  }
+}
+
+static void CheckBulk(std::vector<uint128_t> values, std::mt19937_64 & random)
+{
+  std::shuffle(values.begin(), values.end(), random);
+  const size_t n = values.size();
+  std::vector<uint8_t> expected;
+  for (uint128_t v : values) {
+    const std::vector<uint8_t> bytes = ReferenceEncode(v);
+    expected.insert(expected.end(), bytes.begin(), bytes.end());
+  }
+  std::vector<uint8_t> buffer(n * kMaxVarint128Bytes);
+  uint8_t * end = EncodeVarint128N(values.data(), n, buffer.data());
+  Expect(size_t(end - buffer.data()) == expected.size() &&
+         std::memcmp(buffer.data(), expected.data(), expected.size()) == 0,
+         "EncodeVarint128N");
+
+  std::vector<uint8_t> exact(expected);
+  std::vector<uint128_t> decoded(n);
+  const uint8_t * next = DecodeVarint128N(exact.data(), exact.data() + exact.size(),
+                                          decoded.data(), n);
+  Expect(next == exact.data() + exact.size() && decoded == values, "DecodeVarint128N");
+  Expect(DecodeVarint128N(exact.data(), exact.data() + exact.size() - 1, decoded.data(), n) ==
+         nullptr, "DecodeVarint128N truncated");
+
+  std::vector<int128_t> signed_values(n);
+  for (size_t i = 0; i < n; i++) signed_values[i] = ZigZagDecode128(values[i]);
+  end = EncodeZigZagVarint128N(signed_values.data(), n, buffer.data());
+  Expect(size_t(end - buffer.data()) == expected.size() &&
+         std::memcmp(buffer.data(), expected.data(), expected.size()) == 0,
+         "EncodeZigZagVarint128N");
+  std::vector<int128_t> signed_decoded(n);
+  next = DecodeZigZagVarint128N(exact.data(), exact.data() + exact.size(),
+                                signed_decoded.data(), n);
+  Expect(next == exact.data() + exact.size() && signed_decoded == signed_values,
+         "DecodeZigZagVarint128N");
+}
+
+static void Benchmark(int level, std::mt19937_64 & random)
+{
+  // Mostly small values, as in counters and deltas of sorted IDs.
+  const size_t n = 1 << 20;
+  std::vector<uint128_t> values(n), decoded(n);
+  for (auto & v : values) {
+    const int bits = 1 + random() % (random() % 8 == 0 ? 128 : 40);
+    v = MakeUint128(random(), random()) >> (128 - bits);
+  }
+  std::vector<uint8_t> buffer(n * kMaxVarint128Bytes);
+  using Clock = std::chrono::steady_clock;
+  auto ns = [n](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  auto t0 = Clock::now();
+  uint8_t * end = EncodeVarint128N(values.data(), n, buffer.data());
+  auto t1 = Clock::now();
+  const uint8_t * next = DecodeVarint128N(buffer.data(), end, decoded.data(), n);
+  auto t2 = Clock::now();
+  Expect(next == end && decoded == values, "benchmark round trip");
+  printf("level %d: %.2f bytes/value; EncodeVarint128N %.2f ns/value, "
+         "DecodeVarint128N %.2f ns/value\n", level, double(end - buffer.data()) / n,
+         ns(t1 - t0), ns(t2 - t1));
+}
+
+int main()
+{
+  std::mt19937_64 random(42);
+  const std::vector<uint128_t> values = TestValues(random);
+  const int detected = static_cast<int>(int128_t_internal::DetectedMulKernelLevel());
+  for (int level = 0; level <= detected; level++) {
+    int128_t_internal::SetMulKernelLevel(static_cast<MulKernelLevel>(level));
+    CheckScalar(values);
+    CheckBulk(values, random);
+  }
+  CheckZigZag(random);
+  for (int level : {0, detected}) {
+    int128_t_internal::SetMulKernelLevel(static_cast<MulKernelLevel>(level));
+    Benchmark(level, random);
+  }
+  printf("Done!\n");
+  return errors != 0;
+}